@@ -0,0 +1,105 @@
+#include "benchmark.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <algorithm>
+
+namespace iimodmanager {
+
+static const int defaultSamples = 15;
+static const qint64 defaultMinSampleNsecs = 10 * 1000000;
+//! Caps the batch size for operations so fast, or so thoroughly optimized away, that no batch reaches the minimum sample time.
+static const qint64 maxCalibrationIterations = qint64(1) << 40;
+
+static const void * volatile sink;
+
+void doNotOptimize(const void *result)
+{
+    sink = result;
+}
+
+QJsonObject BenchmarkSuite::Result::toJson() const
+{
+    QJsonObject object;
+    object["nsPerOp"] = nsPerOp;
+    object["minNsPerOp"] = minNsPerOp;
+    object["iterations"] = iterations;
+    object["samples"] = samples;
+    return object;
+}
+
+BenchmarkSuite::BenchmarkSuite()
+    : samples_(defaultSamples), minSampleNsecs_(defaultMinSampleNsecs)
+{}
+
+void BenchmarkSuite::add(const QString &name, std::function<void()> operation)
+{
+    benchmarks_.append({name, std::move(operation)});
+}
+
+QList<BenchmarkSuite::Result> BenchmarkSuite::run() const
+{
+    QList<Result> results;
+    for (const Benchmark &benchmark : benchmarks_)
+    {
+        if (!filter_.isEmpty() && !benchmark.name.contains(filter_))
+            continue;
+
+        // Double the batch until it's long enough for the timer's resolution not to matter.
+        // This also warms up caches and allocators before the measured samples.
+        qint64 iterations = 1;
+        while (timeBatch(benchmark, iterations) < minSampleNsecs_ && iterations < maxCalibrationIterations)
+            iterations *= 2;
+
+        QList<double> nsPerOp;
+        for (int i = 0; i < samples_; ++i)
+            nsPerOp.append(double(timeBatch(benchmark, iterations)) / iterations);
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+
+        results.append({benchmark.name, nsPerOp.at(nsPerOp.size() / 2), nsPerOp.first(), iterations, samples_});
+    }
+    return results;
+}
+
+qint64 BenchmarkSuite::timeBatch(const Benchmark &benchmark, qint64 iterations)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < iterations; ++i)
+        benchmark.operation();
+    return timer.nsecsElapsed();
+}
+
+bool writeSyntheticMod(const QString &path, const QString &name, int files, qint64 fileSize, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QDir dir(path);
+    if (!dir.mkpath("gfx") || !dir.mkpath("scripts"))
+        return false;
+
+    QFile infoFile(dir.filePath("modinfo.txt"));
+    if (!infoFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    infoFile.write(QStringLiteral("name = %1\nversion = 1.%2\nauthor = Bench\n").arg(name).arg(seed).toUtf8());
+    infoFile.close();
+
+    // Spread files across subfolders, like a mod's scripts and assets.
+    QByteArray content(fileSize, Qt::Uninitialized);
+    for (int i = 0; i < files; ++i)
+    {
+        for (qint64 j = 0; j < content.size(); j += sizeof(quint32))
+        {
+            const quint32 value = random.generate();
+            memcpy(content.data() + j, &value, qMin<qint64>(sizeof(quint32), content.size() - j));
+        }
+        const QString fileName = (i % 2 ? QStringLiteral("gfx/asset%1.bin") : QStringLiteral("scripts/script%1.lua")).arg(i);
+        QFile file(dir.filePath(fileName));
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+            return false;
+    }
+    return true;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,70 @@
+#ifndef IIMODMANAGER_BENCHMARK_H
+#define IIMODMANAGER_BENCHMARK_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <functional>
+
+namespace iimodmanager {
+
+//! Hides a result from the optimizer, so that the work producing it can't be dropped.
+void doNotOptimize(const void *result);
+
+//! Named operations, each timed by running it many times in a row.
+class BenchmarkSuite
+{
+public:
+    struct Result
+    {
+        QString name;
+        //! Median over the samples.
+        double nsPerOp;
+        double minNsPerOp;
+        qint64 iterations;
+        int samples;
+
+        QJsonObject toJson() const;
+    };
+
+    BenchmarkSuite();
+
+    //! Adds an operation. Any setup should happen before adding, and be captured by the operation.
+    void add(const QString &name, std::function<void()> operation);
+
+    //! Only runs benchmarks whose name contains the filter.
+    void setFilter(const QString &filter) { filter_ = filter; }
+    void setSamples(int samples) { samples_ = samples; }
+    //! Each sample runs the operation enough times to take at least this long.
+    void setMinSampleTime(qint64 msecs) { minSampleNsecs_ = msecs * 1000000; }
+
+    //! Runs the matching benchmarks in the order they were added.
+    QList<Result> run() const;
+
+private:
+    struct Benchmark
+    {
+        QString name;
+        std::function<void()> operation;
+    };
+
+    QList<Benchmark> benchmarks_;
+    QString filter_;
+    int samples_;
+    qint64 minSampleNsecs_;
+
+    static qint64 timeBatch(const Benchmark &benchmark, qint64 iterations);
+};
+
+//! Writes a folder of files with content derived from the seed, like an extracted mod.
+bool writeSyntheticMod(const QString &path, const QString &name, int files, qint64 fileSize, quint32 seed);
+
+void addParseBenchmarks(BenchmarkSuite &suite);
+//! Cache benchmarks keep their synthetic folders under the work path, which must outlive the suite's run.
+bool addCacheBenchmarks(BenchmarkSuite &suite, const QString &workPath);
+//! Zip benchmarks likewise keep their archive and output folders under the work path.
+bool addZipBenchmarks(BenchmarkSuite &suite, const QString &workPath);
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_BENCHMARK_H
@@ -0,0 +1,110 @@
+#include "benchmark.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QTextStream>
+#include <memory>
+#include <modcache.h>
+#include <modmanconfig.h>
+#include <modsignature.h>
+#include <modversion.h>
+
+namespace iimodmanager {
+
+static const int cachedModCount = 8;
+//! Enough versions that lookups have to walk past several of them.
+static const int versionsPerMod = 12;
+
+static bool writeSyntheticCache(const QString &cachePath)
+{
+    const QDateTime firstVersionTime(QDate(2020, 1, 1), QTime(0, 0), Qt::UTC);
+    for (int m = 0; m < cachedModCount; ++m)
+    {
+        const QString modId = QStringLiteral("workshop-%1").arg(1000000 + m);
+        for (int v = 0; v < versionsPerMod; ++v)
+        {
+            const QString versionId = formatVersionTime(firstVersionTime.addDays(30 * v + m));
+            const QString path = QDir(cachePath).filePath(QStringLiteral("%1/%2").arg(modId, versionId));
+            if (!writeSyntheticMod(path, QStringLiteral("Bench Mod %1").arg(m), 4, 256, m * versionsPerMod + v))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool addCacheBenchmarks(BenchmarkSuite &suite, const QString &workPath)
+{
+    QTextStream cerr(stderr);
+    const QDir workDir(workPath);
+
+    // Hashing is timed over a tree of many small files and one of a few large files,
+    // to separate per-file overhead from read throughput.
+    const QString smallTreePath = workDir.filePath("tree-small");
+    const QString largeTreePath = workDir.filePath("tree-large");
+    if (!writeSyntheticMod(smallTreePath, "Small Files", 200, 512, 1)
+            || !writeSyntheticMod(largeTreePath, "Large Files", 8, 1 << 20, 2))
+    {
+        cerr << "Couldn't write synthetic mods in " << workPath << Qt::endl;
+        return false;
+    }
+    suite.add(QStringLiteral("signature.hashModPath.smallFiles"), [smallTreePath] {
+        QString result = ModSignature::hashModPath(smallTreePath);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("signature.hashModPath.largeFiles"), [largeTreePath] {
+        QString result = ModSignature::hashModPath(largeTreePath);
+        doNotOptimize(&result);
+    });
+
+    const QString cachePath = workDir.filePath("cache");
+    if (!writeSyntheticCache(cachePath))
+    {
+        cerr << "Couldn't write a synthetic cache in " << cachePath << Qt::endl;
+        return false;
+    }
+    auto config = std::make_shared<ModManConfig>(workDir.filePath("config.ini"));
+    config->setCachePath(cachePath);
+    auto cache = std::make_shared<ModCache>(*config);
+    cache->refresh(ModCache::FULL);
+
+    const CachedMod *cm = cache->mod(QStringLiteral("workshop-%1").arg(1000000));
+    if (!cm || cm->versions().size() != versionsPerMod)
+    {
+        cerr << "Synthetic cache didn't load as expected: " << cachePath << Qt::endl;
+        return false;
+    }
+
+    // Look up the oldest version, which is furthest from the front if versions are sorted newest first.
+    const CachedVersion &oldest = cm->versions().first().timestamp() < cm->versions().last().timestamp()
+            ? cm->versions().first() : cm->versions().last();
+    const QString versionId = oldest.id();
+    const QDateTime versionTime = *oldest.timestamp();
+    suite.add(QStringLiteral("cache.versionIndex.id"), [config, cache, cm, versionId] {
+        int result = cm->versionIndex(versionId);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("cache.versionIndex.time"), [config, cache, cm, versionTime] {
+        int result = cm->versionIndex(versionTime);
+        doNotOptimize(&result);
+    });
+
+    // Hash every version up front, so that only the lookup is timed.
+    for (const CachedVersion &cv : cm->versions())
+        cv.hash();
+    const QString hash = oldest.hash();
+    suite.add(QStringLiteral("cache.versionFromHash.scan"), [config, cache, cm, hash] {
+        const CachedVersion *result = cm->versionFromHash(hash);
+        doNotOptimize(result);
+    });
+    suite.add(QStringLiteral("cache.versionFromHash.expected"), [config, cache, cm, hash, versionId] {
+        const CachedVersion *result = cm->versionFromHash(hash, versionId);
+        doNotOptimize(result);
+    });
+    suite.add(QStringLiteral("cache.versionFromHash.miss"), [config, cache, cm] {
+        const CachedVersion *result = cm->versionFromHash(QStringLiteral("0123456789abcdef0123456789abcdef"));
+        doNotOptimize(result);
+    });
+    return true;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,185 @@
+#include "benchmark.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <modmanconfig.h>
+
+using namespace iimodmanager;
+
+static const double defaultThresholdPercent = 10.0;
+
+static QJsonObject environmentJson()
+{
+    QJsonObject environment;
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpu"] = QSysInfo::currentCpuArchitecture();
+    environment["threads"] = QThread::idealThreadCount();
+    environment["qt"] = QString::fromLatin1(qVersion());
+#ifdef QT_NO_DEBUG
+    environment["build"] = QStringLiteral("release");
+#else
+    environment["build"] = QStringLiteral("debug");
+#endif
+    return environment;
+}
+
+//! Compares the median of each result against the baseline.
+//! Returns false if any benchmark is slower than the baseline by more than the threshold,
+//! or has no baseline timing to compare against.
+static bool compare(const QList<BenchmarkSuite::Result> &results, const QJsonObject &baseline, double thresholdPercent)
+{
+    QTextStream cerr(stderr);
+    const QString baselineBuild = baseline["environment"].toObject()["build"].toString();
+    const QString build = environmentJson()["build"].toString();
+    if (baselineBuild != build)
+        cerr << "WARNING: baseline is from a " << (baselineBuild.isEmpty() ? QStringLiteral("unknown") : baselineBuild)
+             << " build, but this is a " << build << " build" << Qt::endl;
+
+    const QJsonObject baselineBenchmarks = baseline["benchmarks"].toObject();
+    bool success = true;
+    qsizetype missingCount = 0;
+    for (const BenchmarkSuite::Result &result : results)
+    {
+        const double baselineNs = baselineBenchmarks[result.name].toObject()["nsPerOp"].toDouble(-1);
+        cerr << result.name << ": " << QString::number(result.nsPerOp, 'f', 1) << " ns/op";
+        if (baselineNs <= 0)
+        {
+            cerr << " NO BASELINE" << Qt::endl;
+            ++missingCount;
+            success = false;
+            continue;
+        }
+
+        const double changePercent = (result.nsPerOp - baselineNs) * 100 / baselineNs;
+        cerr << " vs " << QString::number(baselineNs, 'f', 1) << " ns/op (" << (changePercent >= 0 ? "+" : "")
+             << QString::number(changePercent, 'f', 1) << "%)";
+        if (changePercent > thresholdPercent)
+        {
+            cerr << " REGRESSION" << Qt::endl;
+            success = false;
+        }
+        else if (changePercent < -thresholdPercent)
+            cerr << " faster" << Qt::endl;
+        else
+            cerr << " ok" << Qt::endl;
+    }
+    if (missingCount > 0)
+        cerr << "ERROR: " << missingCount << " benchmark(s) have no baseline timing. Record them with --save from a release build." << Qt::endl;
+    return success;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("iimodman-bench");
+    app.setOrganizationName(ModManConfig::organizationName);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmarks for the mod manager's parsing, cache lookups, hashing and zip extraction.");
+    parser.addHelpOption();
+    parser.addOptions({
+                          {"filter", "Only run benchmarks whose name contains the given text.", "text"},
+                          {"samples", "Timed samples of each benchmark. The median is reported.", "count"},
+                          {"min-time-ms", "Minimum duration of each sample, in milliseconds.", "ms"},
+                          {"baseline", "Baseline results file, as written by --save on a release build. Required by --save and --compare.", "file"},
+                          {"save", "Write the results to the baseline file."},
+                          {"compare", "Compare the results against the baseline file, and fail if any benchmark regressed or has no baseline."},
+                          {"threshold", QStringLiteral("Slowdown in percent that counts as a regression. Defaults to %1.").arg(defaultThresholdPercent), "percent"},
+                      });
+    parser.process(app);
+
+    QTextStream cerr(stderr);
+    BenchmarkSuite suite;
+    suite.setFilter(parser.value("filter"));
+    bool ok = true;
+    if (parser.isSet("samples"))
+    {
+        const int samples = parser.value("samples").toInt(&ok);
+        if (!ok || samples < 1)
+        {
+            cerr << app.applicationName() << ": Invalid sample count: " << parser.value("samples") << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+        suite.setSamples(samples);
+    }
+    if (parser.isSet("min-time-ms"))
+    {
+        const qint64 msecs = parser.value("min-time-ms").toLongLong(&ok);
+        if (!ok || msecs < 1)
+        {
+            cerr << app.applicationName() << ": Invalid sample time: " << parser.value("min-time-ms") << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+        suite.setMinSampleTime(msecs);
+    }
+    double thresholdPercent = defaultThresholdPercent;
+    if (parser.isSet("threshold"))
+    {
+        thresholdPercent = parser.value("threshold").toDouble(&ok);
+        if (!ok || thresholdPercent < 0)
+        {
+            cerr << app.applicationName() << ": Invalid threshold: " << parser.value("threshold") << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+    }
+    // Timings depend on the machine, so there's no default baseline to compare against.
+    if ((parser.isSet("save") || parser.isSet("compare")) && !parser.isSet("baseline"))
+    {
+        cerr << app.applicationName() << ": --save and --compare need a --baseline file" << Qt::endl;
+        parser.showHelp(EXIT_FAILURE);
+    }
+    const QString baselinePath = parser.value("baseline");
+
+    QJsonObject baseline;
+    if (parser.isSet("compare"))
+    {
+        QFile baselineFile(baselinePath);
+        if (!baselineFile.open(QIODevice::ReadOnly))
+        {
+            cerr << app.applicationName() << ": Couldn't read baseline " << baselinePath << ": " << baselineFile.errorString() << Qt::endl;
+            return EXIT_FAILURE;
+        }
+        baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid())
+    {
+        cerr << app.applicationName() << ": Couldn't create a work folder: " << workDir.errorString() << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    addParseBenchmarks(suite);
+    if (!addCacheBenchmarks(suite, workDir.path()) || !addZipBenchmarks(suite, workDir.path()))
+        return EXIT_FAILURE;
+
+    const QList<BenchmarkSuite::Result> results = suite.run();
+    QJsonObject benchmarks;
+    for (const BenchmarkSuite::Result &result : results)
+        benchmarks[result.name] = result.toJson();
+    QJsonObject report;
+    report["environment"] = environmentJson();
+    report["benchmarks"] = benchmarks;
+    const QByteArray reportJson = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    QTextStream(stdout) << reportJson;
+    if (parser.isSet("save"))
+    {
+        QFile baselineFile(baselinePath);
+        if (!baselineFile.open(QIODevice::WriteOnly) || baselineFile.write(reportJson) != reportJson.size())
+        {
+            cerr << app.applicationName() << ": Couldn't write baseline " << baselinePath << ": " << baselineFile.errorString() << Qt::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (parser.isSet("compare") && !compare(results, baseline, thresholdPercent))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
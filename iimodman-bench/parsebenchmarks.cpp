@@ -0,0 +1,65 @@
+#include "benchmark.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <memory>
+#include <modinfo.h>
+#include <modspec.h>
+#include <modversion.h>
+
+namespace iimodmanager {
+
+void addParseBenchmarks(BenchmarkSuite &suite)
+{
+    // Each operation cycles through a few inputs, so that a single branch isn't all that's measured.
+    // Pairs cover numeric, dotted and suffixed versions as seen in modinfo.txt files.
+    static const std::pair<QString, QString> versionPairs[] = {
+        {QStringLiteral("1.2"), QStringLiteral("1.10")},
+        {QStringLiteral("2.0.1"), QStringLiteral("2.0")},
+        {QStringLiteral("1.4b"), QStringLiteral("1.4c")},
+        {QStringLiteral("v3"), QStringLiteral("v3.0.0")},
+    };
+    auto versionIndex = std::make_shared<size_t>(0);
+    suite.add(QStringLiteral("version.isLessThan"), [versionIndex] {
+        const auto &pair = versionPairs[(*versionIndex)++ % std::size(versionPairs)];
+        bool result = isVersionLessThan(pair.first, pair.second);
+        doNotOptimize(&result);
+    });
+
+    const QDateTime versionTime(QDate(2021, 3, 4), QTime(5, 6, 7), Qt::UTC);
+    suite.add(QStringLiteral("version.formatTime"), [versionTime] {
+        QString result = formatVersionTime(versionTime);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("version.parseTime"), [] {
+        QDateTime result = parseVersionTime(QStringLiteral("2021-03-04T05_06_07Z"));
+        doNotOptimize(&result);
+    });
+
+    auto infoBuffer = std::make_shared<QBuffer>();
+    infoBuffer->setData(QByteArrayLiteral(
+            "name = \"Generic Agents\"\n"
+            "author = Bench\n"
+            "version = 1.4.2\n"
+            "icon = gfx/icon.png\n"
+            "description = \"A synthetic modinfo.txt, with a few fields that aren't read.\"\n"));
+    infoBuffer->open(QIODevice::ReadOnly);
+    suite.add(QStringLiteral("modinfo.read"), [infoBuffer] {
+        infoBuffer->seek(0);
+        ModInfo result = ModInfo::readModInfo(*infoBuffer, QStringLiteral("workshop-2151835746"));
+        doNotOptimize(&result);
+    });
+
+    static const QString specLines[] = {
+        QStringLiteral("workshop-2151835746::::Generic Agents"),
+        QStringLiteral("workshop-2151835746:agents:2021-03-04T05_06_07Z::Generic Agents"),
+        QStringLiteral("workshop-2151835746:agents:2021-03-04T05_06_07Z:0123456789abcdef0123456789abcdef/1048576:Generic Agents"),
+    };
+    auto specIndex = std::make_shared<size_t>(0);
+    suite.add(QStringLiteral("spec.fromSpecString"), [specIndex] {
+        std::optional<SpecMod> result = SpecMod::fromSpecString(specLines[(*specIndex)++ % std::size(specLines)]);
+        doNotOptimize(&result);
+    });
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,86 @@
+#include "benchmark.h"
+
+#include <JlCompress.h>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <zipextractor.h>
+#include <zipstreamextractor.h>
+
+namespace iimodmanager {
+
+//! Chunk size for the streamed extraction, similar to what a network reply delivers at once.
+static const qsizetype streamChunkSize = 64 * 1024;
+
+//! Writes script-like text, which deflates well, so that inflating takes a realistic share of the time.
+static bool writeScripts(const QString &path, int files, int linesPerFile)
+{
+    QDir dir(path);
+    if (!dir.mkpath("scripts/text"))
+        return false;
+    for (int i = 0; i < files; ++i)
+    {
+        QFile file(dir.filePath(QStringLiteral("scripts/text/module%1.lua").arg(i)));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            return false;
+        QTextStream out(&file);
+        for (int line = 0; line < linesPerFile; ++line)
+            out << "local value" << line << " = util.tcopy( defs.module" << i << "[ " << line << " ] ) -- " << line * 7919 % 1000 << "\n";
+    }
+    return true;
+}
+
+bool addZipBenchmarks(BenchmarkSuite &suite, const QString &workPath)
+{
+    QTextStream cerr(stderr);
+    const QDir workDir(workPath);
+
+    // Above ZipExtractor's threshold for extracting on several threads, with a mix of
+    // incompressible assets and compressible scripts.
+    const QString modPath = workDir.filePath("zip-source");
+    const QString zipPath = workDir.filePath("mod.zip");
+    if (!writeSyntheticMod(modPath, "Zipped", 16, 512 * 1024, 3)
+            || !writeScripts(modPath, 64, 2000)
+            || !JlCompress::compressDir(zipPath, modPath))
+    {
+        cerr << "Couldn't write a synthetic mod zip in " << workPath << Qt::endl;
+        return false;
+    }
+    QFile zipFile(zipPath);
+    if (!zipFile.open(QIODevice::ReadOnly))
+    {
+        cerr << "Couldn't read " << zipPath << ": " << zipFile.errorString() << Qt::endl;
+        return false;
+    }
+    const QByteArray zipData = zipFile.readAll();
+
+    // Every operation starts by removing the previous output, so that each extracts into an empty folder
+    // as it would in the cache. The removal is part of each timing, and is the same for every method.
+    const QString outputPath = workDir.filePath("zip-output");
+    suite.add(QStringLiteral("zip.extract.jlcompress"), [zipPath, outputPath] {
+        QDir(outputPath).removeRecursively();
+        QStringList result = JlCompress::extractDir(zipPath, outputPath);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("zip.extract.file.singleWorker"), [zipPath, outputPath] {
+        QDir(outputPath).removeRecursively();
+        bool result = ZipExtractor::extractFile(zipPath, outputPath, nullptr, 1);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("zip.extract.file"), [zipPath, outputPath] {
+        QDir(outputPath).removeRecursively();
+        bool result = ZipExtractor::extractFile(zipPath, outputPath);
+        doNotOptimize(&result);
+    });
+    suite.add(QStringLiteral("zip.extract.stream"), [zipData, outputPath] {
+        QDir(outputPath).removeRecursively();
+        ZipStreamExtractor extractor(outputPath);
+        for (qsizetype pos = 0; pos < zipData.size() && extractor.state() == ZipStreamExtractor::READING; pos += streamChunkSize)
+            extractor.write(zipData.mid(pos, streamChunkSize));
+        bool result = extractor.finish();
+        doNotOptimize(&result);
+    });
+    return true;
+}
+
+} // namespace iimodmanager
@@ -74,40 +74,33 @@ QString AddModsImpl::checkModId(const QString &modId)
 
 void AddModsImpl::startInfos()
 {
-    steamInfoCall = downloader->modInfoCall();
-    connect(steamInfoCall, &ModInfoCall::finished, this, &AddModsImpl::steamInfoFinished);
+    steamInfoCall = downloader->modInfoBatchCall();
+    connect(steamInfoCall, &ModInfoBatchCall::finished, this, &AddModsImpl::steamInfosFinished);
 
-    loopIndex = 0;
-    steamInfoCall->start(workshopIds.first());
+    steamInfoCall->start(workshopIds);
 }
 
-void AddModsImpl::nextSteamInfo()
+void AddModsImpl::steamInfosFinished()
 {
-    if (++loopIndex < workshopIds.size())
-    {
-        // Next steamInfo
-        steamInfoCall->start(workshopIds.at(loopIndex));
-    }
-    else
-    {
-        // No downloads needed.
-        steamInfoCall->deleteLater();
-        steamInfoCall = nullptr;
+    for (qsizetype i = 0; i < steamInfoCall->size(); ++i)
+        steamInfoFinished(i);
 
-        cache_->saveMetadata();
-        emit finished();
-    }
+    // No downloads needed.
+    steamInfoCall->deleteLater();
+    steamInfoCall = nullptr;
+
+    cache_->saveMetadata();
+    emit finished();
 }
 
-void AddModsImpl::steamInfoFinished()
+void AddModsImpl::steamInfoFinished(qsizetype index)
 {
-    const SteamModInfo steamInfo = steamInfoCall->result();
+    const SteamModInfo &steamInfo = steamInfoCall->result(index);
 
     if (!steamInfo.valid())
     {
         QTextStream cerr(stderr);
-        cerr << "workshop-" << steamInfoCall->workshopId() << " couldn't be added to cache. Skipping." << Qt::endl;
-        nextSteamInfo();
+        cerr << "workshop-" << steamInfoCall->workshopId(index) << " couldn't be added to cache: " << steamInfoCall->errorDetail(index) << ". Skipping." << Qt::endl;
         return;
     }
 
@@ -117,8 +110,6 @@ void AddModsImpl::steamInfoFinished()
         cerr << cachedMod->info().toString() << " registered to cache" << Qt::endl;
     else
         cerr << steamInfo.modId() << " couldn't be added to cache. Skipping." << Qt::endl;
-
-    nextSteamInfo();
 }
 
 } // namespace iimodmanager
@@ -30,16 +30,15 @@ private:
     ModCache *cache_;
     ModDownloader *downloader;
 
-    ModInfoCall *steamInfoCall;
+    ModInfoBatchCall *steamInfoCall;
     QStringList workshopIds;
-    qsizetype loopIndex;
 
     QStringList checkModIds(const QStringList &modIds);
     QString checkModId(const QString &modId);
     void startInfos();
-    void nextSteamInfo();
 
-    void steamInfoFinished();
+    void steamInfosFinished();
+    void steamInfoFinished(qsizetype index);
 };
 
 } // namespace iimodmanager
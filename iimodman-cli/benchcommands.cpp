@@ -0,0 +1,33 @@
+#include "benchcommands.h"
+#include "benchgeneratecommand.h"
+#include "benchruncommand.h"
+#include "modmancliapplication.h"
+
+#include <QCommandLineParser>
+
+namespace iimodmanager {
+
+BenchCommands::BenchCommands(ModManCliApplication &app)
+    : CommandCategory(app)
+{}
+
+void BenchCommands::addArgs(QCommandLineParser &parser) const
+{
+    parser.addPositionalArgument("bench", "Category: Measure how long core operations take on this machine");
+}
+
+void BenchCommands::addTerminalArgs(QCommandLineParser &parser) const
+{
+    parser.addPositionalArgument("command", "Command to be executed (generate|run)", "generate|run|help");
+}
+
+Command *BenchCommands::parseCommands(const QString command) const
+{
+    if (command == "generate")
+        return new BenchGenerateCommand(app_);
+    if (command == "run")
+        return new BenchRunCommand(app_);
+    return nullptr;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,22 @@
+#ifndef IIMODMANAGER_BENCHCOMMANDS_H
+#define IIMODMANAGER_BENCHCOMMANDS_H
+
+#include "commandcategory.h"
+
+namespace iimodmanager {
+
+class BenchCommands : public CommandCategory
+{
+public:
+    BenchCommands(ModManCliApplication &app);
+
+    // CommandCategory interface
+protected:
+    void addArgs(QCommandLineParser &parser) const;
+    void addTerminalArgs(QCommandLineParser &parser) const;
+    Command *parseCommands(const QString command) const;
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_BENCHCOMMANDS_H
@@ -0,0 +1,425 @@
+#include "benchgeneratecommand.h"
+#include "modmancliapplication.h"
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QtEndian>
+#include <cstring>
+#include <modversion.h>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+namespace iimodmanager {
+
+static const quint64 defaultSeed = 1;
+static const int defaultModCount = 100;
+static const int defaultMaxVersions = 3;
+static const int defaultFilesPerVersion = 20;
+static const int defaultInstalledPercent = 50;
+static const qint64 writeChunkSize = 64 * 1024;
+
+namespace {
+
+//! Deterministic across platforms and library versions, unlike the standard distributions.
+class Random
+{
+public:
+    explicit Random(quint64 seed) : engine_(seed) {}
+
+    quint64 next() { return engine_(); }
+    //! Uniform in [low, high]. The modulo bias is negligible at these ranges.
+    qint64 range(qint64 low, qint64 high) { return low + static_cast<qint64>(next() % static_cast<quint64>(high - low + 1)); }
+    bool chance(int percent) { return range(0, 99) < percent; }
+    template<typename T, size_t N>
+    const T &pick(const T (&items)[N]) { return items[range(0, N - 1)]; }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+struct GeneratedFile
+{
+    QString path;
+    qint64 size;
+    quint64 contentSeed;
+};
+
+struct GeneratedVersion
+{
+    QString id;
+    QString version;
+    QList<GeneratedFile> files;
+};
+
+struct GeneratedMod
+{
+    QString steamId;
+    QString id;
+    QString name;
+    QList<GeneratedVersion> versions;
+};
+
+//! Folders found in real mods, and the kind of files they hold.
+struct AssetDir
+{
+    const char *path;
+    const char *extension;
+    bool isText;
+};
+
+} // namespace
+
+static const AssetDir assetDirs[] = {
+    {"", "lua", true},
+    {"scripts", "lua", true},
+    {"scripts/abilities", "lua", true},
+    {"scripts/missions", "lua", true},
+    {"data/anims", "abld", false},
+    {"gui/images", "png", false},
+    {"images/icons", "png", false},
+    {"sound", "fev", false},
+};
+static const char *const nameAdjectives[] = {"Advanced", "Covert", "Expanded", "Extra", "Generic", "Improved", "Interesting", "More", "New", "Programmable", "Tactical", "Worldgen"};
+static const char *const nameNouns[] = {"Agents", "Augments", "Banter", "Corporations", "Drones", "Guards", "Items", "Missions", "Programs", "Tweaks", "UI", "Weapons"};
+static const char *const fileStems[] = {"agent", "anim", "banter", "daemon", "guard", "icon", "item", "mission", "modinit", "prop", "strings", "util"};
+
+//! Version times start at the game's release, so they sort and parse like real workshop updates.
+static const QDateTime baseTime = QDateTime::fromString(QStringLiteral("2015-05-12T00:00:00Z"), Qt::ISODate);
+
+//! Mostly small scripts, with fewer larger assets, similar to the mix in workshop mods.
+static qint64 generateFileSize(Random &random, bool isText)
+{
+    if (isText)
+        return random.range(512, 16 * 1024);
+    if (random.chance(85))
+        return random.range(16 * 1024, 256 * 1024);
+    return random.range(256 * 1024, 1024 * 1024);
+}
+
+static GeneratedFile generateFile(Random &random, int index)
+{
+    const AssetDir &dir = random.pick(assetDirs);
+    const QString name = QStringLiteral("%1_%2.%3").arg(QString::fromLatin1(random.pick(fileStems))).arg(index).arg(QString::fromLatin1(dir.extension));
+    GeneratedFile file;
+    file.path = *dir.path ? QStringLiteral("%1/%2").arg(QString::fromLatin1(dir.path), name) : name;
+    file.size = generateFileSize(random, dir.isText);
+    file.contentSeed = random.next();
+    return file;
+}
+
+static bool isTextFile(const QString &path)
+{
+    return path.endsWith(QLatin1String(".lua"));
+}
+
+static GeneratedMod generateMod(Random &random, int index, int maxVersions, int filesPerVersion)
+{
+    GeneratedMod mod;
+    // Unique, as each index has its own range of IDs.
+    mod.steamId = QString::number(1000000000 + qint64(index) * 1000 + random.range(0, 999));
+    mod.id = QStringLiteral("workshop-%1").arg(mod.steamId);
+    mod.name = QStringLiteral("%1 %2").arg(QString::fromLatin1(random.pick(nameAdjectives)), QString::fromLatin1(random.pick(nameNouns)));
+
+    QList<GeneratedFile> files;
+    int fileIndex = 0;
+    const qint64 fileCount = qMax<qint64>(1, random.range(filesPerVersion / 2, filesPerVersion * 3 / 2));
+    for (qint64 i = 0; i < fileCount; ++i)
+        files.append(generateFile(random, fileIndex++));
+
+    QDateTime time = baseTime.addSecs(random.range(0, 5 * 365 * 24 * 3600));
+    const qint64 major = random.range(0, 3);
+    const qint64 versionCount = random.range(1, maxVersions);
+    for (qint64 v = 0; v < versionCount; ++v)
+    {
+        if (v > 0)
+        {
+            // Updates change some files and add or remove a few, leaving the rest identical.
+            time = time.addSecs(random.range(24 * 3600, 180 * 24 * 3600));
+            for (GeneratedFile &file : files)
+            {
+                if (random.chance(20))
+                {
+                    file.contentSeed = random.next();
+                    file.size = generateFileSize(random, isTextFile(file.path));
+                }
+            }
+            if (files.size() > 1 && random.chance(20))
+                files.removeAt(random.range(0, files.size() - 1));
+            if (random.chance(30))
+                files.append(generateFile(random, fileIndex++));
+        }
+
+        GeneratedVersion version;
+        version.id = formatVersionTime(time);
+        version.version = QStringLiteral("%1.%2").arg(major).arg(v);
+        version.files = files;
+        mod.versions.append(version);
+    }
+    return mod;
+}
+
+static QByteArray modInfoContent(const GeneratedMod &mod, const GeneratedVersion &version)
+{
+    QString content;
+    QTextStream out(&content);
+    out << "name = " << mod.name << '\n';
+    out << "author = Generated\n";
+    out << "version = " << version.version << '\n';
+    out << "workshop = " << mod.steamId << '\n';
+    out << "description = Synthetic mod for benchmarking.\n";
+    out.flush();
+    return content.toUtf8();
+}
+
+//! Fills the file with bytes derived from its content seed, so that identical files hash identically.
+static bool writeFileContent(const QString &filePath, const GeneratedFile &file, QString *errorInfo)
+{
+    QFile out(filePath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        *errorInfo = QStringLiteral("Failed to create %1: %2").arg(filePath, out.errorString());
+        return false;
+    }
+
+    Random random(file.contentSeed);
+    const bool isText = isTextFile(file.path);
+    QByteArray buffer;
+    for (qint64 written = 0; written < file.size; written += buffer.size())
+    {
+        buffer.resize(static_cast<int>(qMin(writeChunkSize, file.size - written)));
+        char *data = buffer.data();
+        for (qsizetype i = 0; i < buffer.size(); i += 8)
+        {
+            quint64 value = qToLittleEndian(random.next());
+            memcpy(data + i, &value, qMin<qsizetype>(8, buffer.size() - i));
+        }
+        if (isText)
+        {
+            for (qsizetype i = 0; i < buffer.size(); ++i)
+                data[i] = (i % 64 == 63) ? '\n' : static_cast<char>('a' + static_cast<unsigned char>(data[i]) % 26);
+        }
+        if (out.write(buffer) != buffer.size())
+        {
+            *errorInfo = QStringLiteral("Failed to write %1: %2").arg(filePath, out.errorString());
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Writes a version's files into the folder, and returns the totals that a hash would count.
+static bool writeVersion(const QString &dirPath, const GeneratedMod &mod, const GeneratedVersion &version, qint64 *bytes, int *files, QString *errorInfo)
+{
+    const QDir dir(dirPath);
+    if (!dir.mkpath("."))
+    {
+        *errorInfo = QStringLiteral("Failed to create %1").arg(dirPath);
+        return false;
+    }
+
+    const QByteArray modInfo = modInfoContent(mod, version);
+    QFile infoFile(dir.filePath("modinfo.txt"));
+    if (!infoFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || infoFile.write(modInfo) != modInfo.size())
+    {
+        *errorInfo = QStringLiteral("Failed to write %1: %2").arg(infoFile.fileName(), infoFile.errorString());
+        return false;
+    }
+    *bytes = modInfo.size();
+    *files = 1;
+
+    for (const GeneratedFile &file : version.files)
+    {
+        const QString filePath = dir.filePath(file.path);
+        if (!QDir().mkpath(QFileInfo(filePath).path()))
+        {
+            *errorInfo = QStringLiteral("Failed to create folder for %1").arg(filePath);
+            return false;
+        }
+        if (!writeFileContent(filePath, file, errorInfo))
+            return false;
+        *bytes += file.size;
+        ++*files;
+    }
+    return true;
+}
+
+static bool writeJson(const QString &filePath, const QJsonObject &root, QString *errorInfo)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) || file.write(QJsonDocument(root).toJson()) < 0)
+    {
+        *errorInfo = QStringLiteral("Failed to write %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+BenchGenerateCommand::BenchGenerateCommand(ModManCliApplication &app)
+    : Command(app), seed(defaultSeed), modCount(defaultModCount), maxVersions(defaultMaxVersions),
+      filesPerVersion(defaultFilesPerVersion), installedPercent(defaultInstalledPercent)
+{}
+
+void BenchGenerateCommand::addTerminalArgs(QCommandLineParser &parser) const
+{
+    parser.addPositionalArgument("generate", "Command: Generate a synthetic cache and install folder, with a config.ini pointing at them for bench run --config.");
+    parser.addOptions({
+                          {{"o", "output"}, "Folder to generate into. Must be empty or not exist yet.", "dir"},
+                          {"seed", QStringLiteral("Seed for the generated content. The same seed and options always produce the same files. Defaults to %1.").arg(defaultSeed), "seed"},
+                          {"mods", QStringLiteral("Number of mods in the cache. Defaults to %1.").arg(defaultModCount), "count"},
+                          {"versions", QStringLiteral("Maximum number of versions of each mod. Defaults to %1.").arg(defaultMaxVersions), "count"},
+                          {"files", QStringLiteral("Average number of files in each version. Defaults to %1.").arg(defaultFilesPerVersion), "count"},
+                          {"installed", QStringLiteral("Percentage of mods to install. Defaults to %1.").arg(defaultInstalledPercent), "percent"},
+                      });
+}
+
+void BenchGenerateCommand::parse(QCommandLineParser &parser, const QStringList &args)
+{
+    Q_UNUSED(args);
+
+    QTextStream cerr(stderr);
+    outputPath = parser.value("output");
+    if (outputPath.isEmpty())
+    {
+        cerr << app_.applicationName() << ": Missing output folder" << Qt::endl;
+        parser.showHelp(EXIT_FAILURE);
+    }
+
+    const auto readNumber = [&](const QString &name, qint64 min, qint64 max, auto *value) {
+        if (!parser.isSet(name))
+            return;
+        bool ok;
+        const qint64 number = parser.value(name).toLongLong(&ok);
+        if (!ok || number < min || number > max)
+        {
+            cerr << app_.applicationName() << ": Invalid --" << name << ": " << parser.value(name) << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+        *value = static_cast<std::remove_pointer_t<decltype(value)>>(number);
+    };
+    readNumber("seed", 0, std::numeric_limits<qint64>::max(), &seed);
+    readNumber("mods", 1, 999999, &modCount);
+    readNumber("versions", 1, 1000, &maxVersions);
+    readNumber("files", 1, 100000, &filesPerVersion);
+    readNumber("installed", 0, 100, &installedPercent);
+}
+
+void BenchGenerateCommand::execute()
+{
+    QString errorInfo;
+    if (generate(&errorInfo))
+        QTimer::singleShot(0, this, &Command::finished);
+    else
+    {
+        QTextStream(stderr) << app_.applicationName() << ": " << errorInfo << Qt::endl;
+        QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
+    }
+}
+
+bool BenchGenerateCommand::generate(QString *errorInfo)
+{
+    const QDir outputDir(outputPath);
+    if (outputDir.exists() && !outputDir.isEmpty())
+    {
+        *errorInfo = QStringLiteral("Output folder isn't empty: %1").arg(outputPath);
+        return false;
+    }
+    const QString cachePath = outputDir.absoluteFilePath("cache");
+    const QString installPath = outputDir.absoluteFilePath("install");
+    const QDir cacheDir(cachePath);
+    const QDir modDir(QDir(installPath).filePath("mods"));
+    if (!cacheDir.mkpath(".") || !modDir.mkpath("."))
+    {
+        *errorInfo = QStringLiteral("Failed to create %1").arg(outputPath);
+        return false;
+    }
+
+    // An install folder is only recognized if it has the game's main.lua.
+    QFile mainFile(QDir(installPath).filePath("main.lua"));
+    if (!mainFile.open(QIODevice::WriteOnly))
+    {
+        *errorInfo = QStringLiteral("Failed to write %1: %2").arg(mainFile.fileName(), mainFile.errorString());
+        return false;
+    }
+    mainFile.close();
+
+    Random random(seed);
+    QJsonArray modsArray;
+    qint64 cacheBytes = 0;
+    qint64 installedBytes = 0;
+    int versionCount = 0;
+    int installedCount = 0;
+    for (int i = 0; i < modCount; ++i)
+    {
+        const GeneratedMod mod = generateMod(random, i, maxVersions, filesPerVersion);
+
+        // Sizes are recorded like a real cache, so that estimates don't need to scan the folders.
+        QJsonArray versionsArray;
+        for (const GeneratedVersion &version : mod.versions)
+        {
+            qint64 bytes;
+            int files;
+            if (!writeVersion(cacheDir.filePath(QStringLiteral("%1/%2").arg(mod.id, version.id)), mod, version, &bytes, &files, errorInfo))
+                return false;
+            QJsonObject versionObject;
+            versionObject["versionId"] = version.id;
+            versionObject["size"] = bytes;
+            versionObject["files"] = files;
+            versionsArray.append(versionObject);
+            cacheBytes += bytes;
+            ++versionCount;
+        }
+        QJsonObject modObject;
+        modObject["modId"] = mod.id;
+        modObject["modName"] = mod.name;
+        modObject["versions"] = versionsArray;
+        modsArray.append(modObject);
+
+        if (random.chance(installedPercent))
+        {
+            // Mostly the latest version, as after a sync, but some are left on older versions.
+            const GeneratedVersion &version = random.chance(80) ? mod.versions.last() : mod.versions.at(random.range(0, mod.versions.size() - 1));
+            const QString installedPath = modDir.filePath(mod.id);
+            qint64 bytes;
+            int files;
+            if (!writeVersion(installedPath, mod, version, &bytes, &files, errorInfo))
+                return false;
+
+            QJsonObject claim;
+            claim["modId"] = mod.id;
+            claim["versionId"] = version.id;
+            if (!writeJson(QDir(installedPath).filePath("modman.json"), claim, errorInfo))
+                return false;
+            installedBytes += bytes;
+            ++installedCount;
+        }
+    }
+
+    QJsonObject db;
+    db["mods"] = modsArray;
+    if (!writeJson(cacheDir.filePath("modmandb.json"), db, errorInfo))
+        return false;
+
+    const QString configPath = outputDir.absoluteFilePath("config.ini");
+    {
+        ModManConfig config(configPath);
+        config.setCachePath(cachePath);
+        config.setInstallPath(installPath);
+    }
+
+    QTextStream cerr(stderr);
+    cerr << "Generated " << modCount << " mods with " << versionCount << " versions (" << cacheBytes << " bytes) in the cache, and "
+         << installedCount << " installed mods (" << installedBytes << " bytes)." << Qt::endl;
+    cerr << "Use with: bench run --config " << QDir::toNativeSeparators(configPath) << Qt::endl;
+    return true;
+}
+
+} // namespace iimodmanager
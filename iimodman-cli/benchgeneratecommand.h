@@ -0,0 +1,34 @@
+#ifndef IIMODMANAGER_BENCHGENERATECOMMAND_H
+#define IIMODMANAGER_BENCHGENERATECOMMAND_H
+
+#include "command.h"
+
+
+namespace iimodmanager {
+
+//! Builds a synthetic cache and install folder that look like real mods, for benchmarking at scale.
+//! The output only depends on the seed and the size options.
+class BenchGenerateCommand : public Command
+{
+public:
+    BenchGenerateCommand(ModManCliApplication &app);
+
+    // Command interface
+    void addTerminalArgs(QCommandLineParser &parser) const;
+    void parse(QCommandLineParser &parser, const QStringList &args);
+    void execute();
+
+private:
+    QString outputPath;
+    quint64 seed;
+    int modCount;
+    int maxVersions;
+    int filesPerVersion;
+    int installedPercent;
+
+    bool generate(QString *errorInfo);
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_BENCHGENERATECOMMAND_H
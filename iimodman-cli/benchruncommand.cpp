@@ -0,0 +1,366 @@
+#include "benchruncommand.h"
+#include "modmancliapplication.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <modcache.h>
+#include <modinfo.h>
+#include <modlist.h>
+#include <modsignature.h>
+#include <modspec.h>
+#include <numeric>
+
+namespace iimodmanager {
+
+static const int defaultIterations = 10;
+
+static qint64 timed(const std::function<void()> &operation)
+{
+    QElapsedTimer timer;
+    timer.start();
+    operation();
+    return timer.nsecsElapsed();
+}
+
+static double toMs(qint64 ns)
+{
+    return ns / 1e6;
+}
+
+//! Nearest-rank percentile of sorted samples.
+static qint64 percentile(const QList<qint64> &sorted, int p)
+{
+    const qsizetype rank = qMax<qsizetype>(1, (p * sorted.size() + 99) / 100);
+    return sorted.at(rank - 1);
+}
+
+void BenchRunCommand::Samples::add(qint64 ns)
+{
+    if (firstNs < 0)
+        firstNs = ns;
+    else
+        warmNs.append(ns);
+}
+
+QJsonObject BenchRunCommand::Samples::toJson() const
+{
+    QJsonObject object;
+    object["firstMs"] = toMs(firstNs);
+    if (warmNs.isEmpty())
+        return object;
+
+    QList<qint64> sorted = warmNs;
+    std::sort(sorted.begin(), sorted.end());
+    const qint64 total = std::accumulate(sorted.cbegin(), sorted.cend(), qint64(0));
+
+    QJsonObject warm;
+    warm["runs"] = sorted.size();
+    warm["minMs"] = toMs(sorted.first());
+    warm["p50Ms"] = toMs(percentile(sorted, 50));
+    warm["p90Ms"] = toMs(percentile(sorted, 90));
+    warm["p99Ms"] = toMs(percentile(sorted, 99));
+    warm["maxMs"] = toMs(sorted.last());
+    warm["meanMs"] = toMs(total / sorted.size());
+    object["warm"] = warm;
+    return object;
+}
+
+QString BenchRunCommand::Samples::toString() const
+{
+    QString result = QStringLiteral("first %1 ms").arg(toMs(firstNs), 0, 'f', 3);
+    if (!warmNs.isEmpty())
+    {
+        QList<qint64> sorted = warmNs;
+        std::sort(sorted.begin(), sorted.end());
+        result += QStringLiteral(", warm p50 %1 ms, p90 %2 ms, max %3 ms")
+                .arg(toMs(percentile(sorted, 50)), 0, 'f', 3)
+                .arg(toMs(percentile(sorted, 90)), 0, 'f', 3)
+                .arg(toMs(sorted.last()), 0, 'f', 3);
+    }
+    return result;
+}
+
+BenchRunCommand::BenchRunCommand(ModManCliApplication &app)
+    : Command(app), iterations(defaultIterations), isSkipInstallSet(false)
+{}
+
+void BenchRunCommand::addTerminalArgs(QCommandLineParser &parser) const
+{
+    parser.addPositionalArgument("run", "Command: Time refreshing, hashing, spec parsing and installing against the configured folders, and print the results as JSON.");
+    parser.addOptions({
+                          {{"n", "iterations"}, QStringLiteral("Warm runs of each operation, after the first run. Defaults to %1.").arg(defaultIterations), "count"},
+                          {"mod", "Cached mod to hash, read and install. Defaults to the downloaded mod with the largest latest version.", "modId"},
+                          {"config", "Use the settings in the given INI file instead of the user's, such as the config.ini written by bench generate.", "file"},
+                          {"skip-install", "Don't time installing and removing a mod. Otherwise it's installed to a scratch folder, leaving the game's mods untouched."},
+                      });
+}
+
+void BenchRunCommand::parse(QCommandLineParser &parser, const QStringList &args)
+{
+    Q_UNUSED(args);
+
+    if (parser.isSet("iterations"))
+    {
+        bool ok;
+        iterations = parser.value("iterations").toInt(&ok);
+        if (!ok || iterations < 0)
+        {
+            QTextStream cerr(stderr);
+            cerr << app_.applicationName() << ": Invalid iteration count: " << parser.value("iterations") << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+    }
+    targetModId = parser.value("mod");
+    if (parser.isSet("config"))
+    {
+        if (!QFile::exists(parser.value("config")))
+        {
+            QTextStream cerr(stderr);
+            cerr << app_.applicationName() << ": Config file not found: " << parser.value("config") << Qt::endl;
+            parser.showHelp(EXIT_FAILURE);
+        }
+        customConfig = std::make_unique<ModManConfig>(parser.value("config"));
+    }
+    isSkipInstallSet = parser.isSet("skip-install");
+}
+
+void BenchRunCommand::execute()
+{
+    QTextStream cerr(stderr);
+
+    ModCache cache(config());
+    cache.refresh(ModCache::LATEST_ONLY);
+    const CachedVersion *target = findTarget(cache);
+    if (!target && !targetModId.isEmpty())
+    {
+        cerr << "Mod has no downloaded versions in the cache: " << targetModId << Qt::endl;
+        QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
+        return;
+    }
+
+    benchRefresh();
+    benchSpec(cache);
+    bool success = true;
+    if (target)
+    {
+        benchTarget(*target);
+        if (!isSkipInstallSet)
+            success = benchInstall(*target);
+    }
+    else
+        cerr << "No downloaded mods in the cache. Skipping hashing and installing." << Qt::endl;
+
+    QJsonObject environment;
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpu"] = QSysInfo::currentCpuArchitecture();
+    environment["threads"] = QThread::idealThreadCount();
+    environment["qt"] = QString::fromLatin1(qVersion());
+#ifdef QT_NO_DEBUG
+    environment["build"] = QStringLiteral("release");
+#else
+    environment["build"] = QStringLiteral("debug");
+#endif
+
+    QJsonObject report;
+    report["environment"] = environment;
+    report["iterations"] = iterations;
+    report["cachedMods"] = cache.mods().size();
+    if (target)
+    {
+        report["modId"] = target->modId();
+        report["versionId"] = target->id();
+    }
+    report["results"] = results;
+
+    QTextStream cout(app_.out());
+    cout << QJsonDocument(report).toJson(QJsonDocument::Indented);
+    cout.flush();
+
+    if (success)
+        QTimer::singleShot(0, this, &Command::finished);
+    else
+        QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
+}
+
+const CachedVersion *BenchRunCommand::findTarget(const ModCache &cache) const
+{
+    if (!targetModId.isEmpty())
+    {
+        const CachedMod *cm = cache.mod(targetModId);
+        return cm ? cm->latestVersion() : nullptr;
+    }
+
+    const CachedVersion *target = nullptr;
+    for (const CachedMod &cm : cache.mods())
+    {
+        const CachedVersion *cv = cm.latestVersion();
+        if (cv && (!target || cv->size() > target->size()))
+            target = cv;
+    }
+    return target;
+}
+
+BenchRunCommand::Samples BenchRunCommand::measure(const std::function<qint64()> &run) const
+{
+    Samples samples;
+    for (int i = 0; i <= iterations; ++i)
+        samples.add(run());
+    return samples;
+}
+
+void BenchRunCommand::record(const QString &name, const Samples &samples, const QJsonObject &details)
+{
+    QJsonObject result = samples.toJson();
+    result["name"] = name;
+    for (auto it = details.begin(); it != details.end(); ++it)
+        result[it.key()] = it.value();
+    results.append(result);
+
+    QTextStream(stderr) << name << ": " << samples.toString() << Qt::endl;
+}
+
+void BenchRunCommand::benchRefresh()
+{
+    const ModManConfig &config = this->config();
+
+    // Each run uses fresh objects, so only the OS file cache carries over between runs.
+    const std::pair<ModCache::RefreshLevel, QString> cacheLevels[] = {
+        {ModCache::FULL, QStringLiteral("cache.refresh.full")},
+        {ModCache::LATEST_ONLY, QStringLiteral("cache.refresh.latest")},
+        {ModCache::ID_ONLY, QStringLiteral("cache.refresh.id")},
+    };
+    for (const auto &level : cacheLevels)
+    {
+        record(level.second, measure([&config, &level] {
+            ModCache cache(config);
+            return timed([&] { cache.refresh(level.first); });
+        }));
+    }
+
+    const std::pair<ModList::RefreshLevel, QString> modListLevels[] = {
+        {ModList::FULL, QStringLiteral("modlist.refresh.full")},
+        {ModList::CONTENT_ONLY, QStringLiteral("modlist.refresh.content")},
+        {ModList::ID_ONLY, QStringLiteral("modlist.refresh.id")},
+    };
+    for (const auto &level : modListLevels)
+    {
+        record(level.second, measure([&config, &level] {
+            ModCache cache(config);
+            cache.refresh(ModCache::LATEST_ONLY);
+            ModList modList(config, &cache);
+            return timed([&] { modList.refresh(level.first); });
+        }));
+    }
+}
+
+void BenchRunCommand::benchTarget(const CachedVersion &target)
+{
+    const QString path = target.path();
+    ModSignature::Stats stats;
+    const Samples hashSamples = measure([&path, &stats] {
+        return timed([&] { ModSignature::hashModPath(path, &stats); });
+    });
+    QJsonObject details;
+    details["bytes"] = stats.bytes;
+    details["files"] = stats.files;
+    record(QStringLiteral("hash"), hashSamples, details);
+
+    const QString infoPath = QDir(path).filePath("modinfo.txt");
+    const QString modId = target.modId();
+    record(QStringLiteral("modinfo.read"), measure([&infoPath, &modId] {
+        return timed([&] {
+            QFile infoFile(infoPath);
+            ModInfo::readModInfo(infoFile, modId);
+        });
+    }));
+}
+
+void BenchRunCommand::benchSpec(const ModCache &cache)
+{
+    QByteArray content;
+    int lines = 0;
+    for (const CachedMod &cm : cache.mods())
+    {
+        if (const CachedVersion *cv = cm.latestVersion())
+        {
+            content += cv->asSpec().asVersionedSpecString().toUtf8();
+            content += '\n';
+            ++lines;
+        }
+    }
+    if (lines == 0)
+        return;
+
+    QJsonObject details;
+    details["lines"] = lines;
+    details["bytes"] = content.size();
+    record(QStringLiteral("spec.parse"), measure([&content] {
+        ModSpec spec;
+        return timed([&] { spec.appendFromFile(content); });
+    }), details);
+}
+
+bool BenchRunCommand::benchInstall(const CachedVersion &target)
+{
+    QTextStream cerr(stderr);
+
+    // A scratch install folder, so that the game's mods are never touched.
+    QTemporaryDir scratchDir;
+    if (!scratchDir.isValid() || !QDir(scratchDir.path()).mkpath("mods"))
+    {
+        cerr << "Couldn't create a scratch folder for installing: " << scratchDir.errorString() << Qt::endl;
+        return false;
+    }
+    QFile mainFile(QDir(scratchDir.path()).filePath("main.lua"));
+    if (!mainFile.open(QIODevice::WriteOnly))
+    {
+        cerr << "Couldn't create a scratch folder for installing: " << mainFile.errorString() << Qt::endl;
+        return false;
+    }
+    mainFile.close();
+
+    ModManConfig scratchConfig(QDir(scratchDir.path()).filePath("config.ini"));
+    scratchConfig.setCachePath(config().cachePath());
+    scratchConfig.setInstallPath(scratchDir.path());
+    ModCache cache(scratchConfig);
+    cache.refresh(ModCache::LATEST_ONLY);
+    ModList modList(scratchConfig, &cache);
+    modList.refresh(ModList::ID_ONLY);
+
+    const SpecMod spec = target.asSpec();
+    Samples installSamples;
+    Samples removeSamples;
+    for (int i = 0; i <= iterations; ++i)
+    {
+        QString errorInfo;
+        bool ok = true;
+        installSamples.add(timed([&] { ok = modList.installMod(spec, &errorInfo); }));
+        if (ok)
+            removeSamples.add(timed([&] { ok = modList.removeMod(spec.id(), &errorInfo); }));
+        if (!ok)
+        {
+            cerr << "Failed to install and remove " << target.info().toString() << ": " << errorInfo << Qt::endl;
+            return false;
+        }
+        modList.refresh(ModList::ID_ONLY);
+    }
+
+    QJsonObject details;
+    details["bytes"] = target.size();
+    details["files"] = target.fileCount();
+    record(QStringLiteral("mods.install"), installSamples, details);
+    record(QStringLiteral("mods.remove"), removeSamples, details);
+    return true;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,63 @@
+#ifndef IIMODMANAGER_BENCHRUNCOMMAND_H
+#define IIMODMANAGER_BENCHRUNCOMMAND_H
+
+#include "command.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <functional>
+#include <memory>
+#include <modmanconfig.h>
+
+namespace iimodmanager {
+
+class CachedVersion;
+class ModCache;
+
+class BenchRunCommand : public Command
+{
+public:
+    BenchRunCommand(ModManCliApplication &app);
+
+    // Command interface
+    void addTerminalArgs(QCommandLineParser &parser) const;
+    void parse(QCommandLineParser &parser, const QStringList &args);
+    void execute();
+
+private:
+    //! Timings of one operation: the first run, and the runs after it.
+    //! The first run is the first in this process, so it pays for lazy setup but not for a cold disk:
+    //! the OS file cache isn't dropped, and may be warm from earlier benchmarks or processes.
+    struct Samples
+    {
+        qint64 firstNs = -1;
+        QList<qint64> warmNs;
+
+        void add(qint64 ns);
+        QJsonObject toJson() const;
+        QString toString() const;
+    };
+
+    //! Settings read from --config, if given.
+    std::unique_ptr<ModManConfig> customConfig;
+    int iterations;
+    QString targetModId;
+    bool isSkipInstallSet;
+
+    QJsonArray results;
+
+    inline const ModManConfig &config() const { return customConfig ? *customConfig : app_.config(); }
+    const CachedVersion *findTarget(const ModCache &cache) const;
+    //! Runs the operation once, then once per iteration. Each run returns the nanoseconds it took.
+    Samples measure(const std::function<qint64()> &run) const;
+    void record(const QString &name, const Samples &samples, const QJsonObject &details = QJsonObject());
+
+    void benchRefresh();
+    void benchTarget(const CachedVersion &target);
+    void benchSpec(const ModCache &cache);
+    bool benchInstall(const CachedVersion &target);
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_BENCHRUNCOMMAND_H
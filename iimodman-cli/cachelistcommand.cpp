@@ -2,6 +2,7 @@
 #include "modmancliapplication.h"
 
 #include <QCommandLineParser>
+#include <QJsonObject>
 #include <QTextStream>
 #include <QTimer>
 #include <modcache.h>
@@ -23,6 +24,7 @@ void CacheListCommand::addTerminalArgs(QCommandLineParser &parser) const
                           {"hash", "Print mod version hashes."},
                           {"spec", "Format output as a mod-spec."},
                           {"spec-full", "Format output as a full versioned mod-spec."},
+                          {"json", "Write one JSON object per line for each mod, or each version with --all, as each mod is read.\nHashes and installed versions are included with --hash."},
                       });
 }
 
@@ -45,41 +47,71 @@ void CacheListCommand::parse(QCommandLineParser &parser, const QStringList &args
         versionSetting = NONE;
         includeHashes = false;
     }
+    if (parser.isSet("json"))
+        format = JSON;
 }
 
 void CacheListCommand::execute()
 {
-    ModCache cache(app_.config());
-    if (versionSetting == ALL)
+    ModCache *cache = app_.servedCache();
+    installedKnown = cache != nullptr;
+    if (!cache && format == JSON)
     {
-        cache.refresh(ModCache::FULL);
-        ModList modList(app_.config(), &cache, nullptr);
-        modList.refresh(ModList::FULL);
+        // No widths to measure, so each record is written as soon as its mod has been read.
+        // Matching the installed mods needs their hashes, so only do that with --hash.
+        cache = new ModCache(app_.config(), this);
+        ModList *modList = nullptr;
+        if (includeHashes)
+        {
+            modList = new ModList(app_.config(), cache, this);
+            modList->refresh(ModList::CONTENT_ONLY);
+        }
+        cache->refresh(versionSetting == ALL ? ModCache::FULL : ModCache::LATEST_ONLY,
+                       [this, modList](const CachedMod &mod) { writeJsonMod(mod, modList); });
+
+        QTimer::singleShot(0, this, &Command::finished);
+        return;
     }
-    else
+    if (!cache)
     {
-        cache.refresh(ModCache::LATEST_ONLY);
+        cache = new ModCache(app_.config(), this);
+        if (versionSetting == ALL)
+        {
+            // Matching installed mods marks which versions are installed.
+            cache->refresh(ModCache::FULL);
+            ModList modList(app_.config(), cache, nullptr);
+            modList.refresh(ModList::FULL);
+        }
+        else
+        {
+            cache->refresh(ModCache::LATEST_ONLY);
+        }
     }
 
     if (format == TEXT)
     {
         maxWidth = 0;
-        for (auto mod : cache.mods()) {
+        for (auto mod : cache->mods()) {
         const qsizetype width = mod.id().size() + mod.info().name().size() + 3;
         if (width > maxWidth)
             maxWidth = width;
         }
 
-        QTextStream cout(stdout);
+        QTextStream cout(app_.out());
         cout.setFieldAlignment(QTextStream::AlignLeft);
-        for (auto mod : cache.mods()) {
+        for (auto mod : cache->mods()) {
             writeTextMod(cout, mod);
         }
     }
+    else if (format == JSON)
+    {
+        for (const CachedMod &mod : cache->mods())
+            writeJsonMod(mod, nullptr);
+    }
     else
     {
-        QTextStream cout(stdout);
-        for (auto mod : cache.mods()) {
+        QTextStream cout(app_.out());
+        for (auto mod : cache->mods()) {
             if (mod.downloaded()) {
                 if (format == MODSPEC_VERSIONED)
                     cout << mod.latestVersion()->asSpec().asVersionedSpecString() << Qt::endl;
@@ -135,4 +167,51 @@ void CacheListCommand::writeTextMod(QTextStream &cout, const CachedMod &mod)
     cout << Qt::endl;
 }
 
+void CacheListCommand::writeJsonMod(const CachedMod &mod, const ModList *modList)
+{
+    // Without a served cache, the installed version is found by hashing the installed mod.
+    std::optional<const CachedVersion *> installedVersion;
+    if (modList && mod.downloaded())
+    {
+        const InstalledMod *im = modList->mod(mod.id());
+        installedVersion = im ? mod.versionFromHash(im->hash()) : nullptr;
+    }
+
+    if (!mod.downloaded())
+        writeJsonVersion(mod, nullptr, installedVersion);
+    else if (versionSetting == ALL)
+    {
+        const QList<CachedVersion> &versions = mod.versions();
+        for (auto it = versions.rbegin(); it != versions.rend() ; ++it)
+            writeJsonVersion(mod, &*it, installedVersion);
+    }
+    else
+        writeJsonVersion(mod, mod.latestVersion(), installedVersion);
+}
+
+void CacheListCommand::writeJsonVersion(const CachedMod &mod, const CachedVersion *version, std::optional<const CachedVersion *> installedVersion)
+{
+    QJsonObject record;
+    record["modId"] = mod.id();
+    record["name"] = mod.info().name();
+    record["downloaded"] = version != nullptr;
+    if (version)
+    {
+        record["versionId"] = version->id();
+        if (version->version())
+            record["version"] = *version->version();
+        if (version->timestamp())
+            record["timestamp"] = version->timestamp()->toString(Qt::ISODate);
+        if (installedVersion)
+            record["installed"] = *installedVersion == version;
+        else if (installedKnown)
+            record["installed"] = version->installed();
+        record["size"] = version->size();
+        record["files"] = version->fileCount();
+        if (includeHashes)
+            record["hash"] = version->hash();
+    }
+    app_.writeRecord(record);
+}
+
 }  // namespace iimodmanager
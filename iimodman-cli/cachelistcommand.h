@@ -3,12 +3,16 @@
 
 #include "command.h"
 
+#include <optional>
+
 class QTextStream;
 
 
 namespace iimodmanager {
 
 class CachedMod;
+class CachedVersion;
+class ModList;
 
 
 class CacheListCommand : public Command
@@ -20,6 +24,7 @@ public:
     void addTerminalArgs(QCommandLineParser &parser) const;
     void parse(QCommandLineParser &parser, const QStringList &args);
     void execute();
+    bool canServe() const { return true; }
 
 private:
     enum OutputFormat
@@ -27,6 +32,7 @@ private:
         TEXT,
         MODSPEC,
         MODSPEC_VERSIONED,
+        JSON,
     };
     enum VersionSetting
     {
@@ -37,9 +43,13 @@ private:
     OutputFormat format;
     VersionSetting versionSetting;
     bool includeHashes;
+    //! Whether the cache already knows which versions are installed, as a served cache does.
+    bool installedKnown;
     qsizetype maxWidth;
 
     void writeTextMod(QTextStream &out, const CachedMod &mod);
+    void writeJsonMod(const CachedMod &mod, const ModList *modList);
+    void writeJsonVersion(const CachedMod &mod, const CachedVersion *version, std::optional<const CachedVersion *> installedVersion);
 };
 
 }  // namespace iimodmanager
@@ -21,6 +21,7 @@ void CacheUpdateCommand::addTerminalArgs(QCommandLineParser &parser) const
                           {{"a","add"}, "Automatically add missing mods to the cache."},
                           {{"f","force"}, "Overwrite even if the latest version is already downloaded."},
                           {{"v","verbose"}, "Print additional status messages."},
+                          {"metrics", "Print transfer metrics as JSON on stdout when done."},
                           {{"y","yes"}, "Automatic yes to all prompts."},
                       });
 }
@@ -54,6 +55,7 @@ void CacheUpdateCommand::parse(QCommandLineParser &parser, const QStringList &ar
     impl->setAlreadyLatestVersionBehavior(parser.isSet("force") ? UpdateModsImpl::LATEST_FORCE : UpdateModsImpl::LATEST_SKIP);
     impl->setConfirmBeforeDownloading(!parser.isSet("yes"));
     impl->setVerbose(parser.isSet("verbose"));
+    impl->setPrintMetrics(parser.isSet("metrics"));
 
     if (parser.isSet("mod-id"))
         modIds.append(parser.values("mod-id"));
@@ -12,4 +12,9 @@ Command::Command(ModManCliApplication &app)
     : app_(app)
 {}
 
+bool Command::canServe() const
+{
+    return false;
+}
+
 }  // namespace iimodmanager
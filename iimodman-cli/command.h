@@ -21,6 +21,9 @@ public:
     virtual void addTerminalArgs(QCommandLineParser &parser) const = 0;
     virtual void parse(QCommandLineParser &parser, const QStringList &args) = 0;
     virtual void execute() = 0;
+    //! True if the command only reads the cache and mod list, so that a running serve command can answer it.
+    //! Such commands use the application's served state and output device, and report completion through finished().
+    virtual bool canServe() const;
 
 signals:
     void finished();
@@ -1,8 +1,10 @@
+#include "benchcommands.h"
 #include "cachecommands.h"
 #include "commandcategory.h"
 #include "commandparser.h"
 #include "configcommands.h"
 #include "modscommands.h"
+#include "servecommand.h"
 #include "steamapicommands.h"
 
 #include <QTextStream>
@@ -12,7 +14,7 @@ namespace iimodmanager {
 CommandParser::CommandParser(ModManCliApplication &app) : app_(app) {}
 
 void CommandParser::addTerminalArgs() {
-    parser_.addPositionalArgument("category", "Category of the command to be executed (cache|config|mods|steamapi)", "(cache|config|mods|steamapi)");
+    parser_.addPositionalArgument("category", "Category of the command to be executed (bench|cache|config|mods|steamapi), or serve", "(bench|cache|config|mods|steamapi|serve)");
     parser_.addPositionalArgument("command", "Command to be executed", "[command]|help");
 }
 
@@ -46,6 +48,11 @@ Command *CommandParser::parse(const QStringList &arguments)
         addTerminalArgs();
         parser_.showHelp(EXIT_SUCCESS);
     }
+    else if (category == "bench")
+    {
+        BenchCommands benchCommands(app_);
+        command = benchCommands.parse(parser_, args, parser_.isSet(help));
+    }
     else if (category == "cache")
     {
         CacheCommands cacheCommands(app_);
@@ -66,6 +73,10 @@ Command *CommandParser::parse(const QStringList &arguments)
         SteamAPICommands apiCommands(app_);
         command = apiCommands.parse(parser_, args, parser_.isSet(help));
     }
+    else if (category == "serve")
+    {
+        command = new ServeCommand(app_);
+    }
     else
     {
         addTerminalArgs();
@@ -45,6 +45,46 @@ void ConfigGetCommand::execute()
     {
         cout << QDir::toNativeSeparators(app_.config().localPath()) << Qt::endl;
     }
+    else if (key == "download.concurrency")
+    {
+        cout << app_.config().downloadConcurrency() << Qt::endl;
+    }
+    else if (key == "download.hostConcurrency")
+    {
+        cout << app_.config().downloadHostConcurrency() << Qt::endl;
+    }
+    else if (key == "download.infoBatchSize")
+    {
+        cout << app_.config().infoBatchSize() << Qt::endl;
+    }
+    else if (key == "download.infoCacheTtl")
+    {
+        cout << app_.config().infoCacheTtl() << Qt::endl;
+    }
+    else if (key == "download.streaming")
+    {
+        cout << (app_.config().downloadStreaming() ? "true" : "false") << Qt::endl;
+    }
+    else if (key == "download.mirrors")
+    {
+        cout << app_.config().downloadMirrors().join(',') << Qt::endl;
+    }
+    else if (key == "network.requestRate")
+    {
+        cout << app_.config().requestRate() << Qt::endl;
+    }
+    else if (key == "network.timeout")
+    {
+        cout << app_.config().requestTimeout() << Qt::endl;
+    }
+    else if (key == "network.maxRetries")
+    {
+        cout << app_.config().maxRetries() << Qt::endl;
+    }
+    else if (key == "network.retryDelay")
+    {
+        cout << app_.config().retryDelay() << Qt::endl;
+    }
     else
     {
         QTextStream cerr(stderr);
@@ -29,6 +29,16 @@ void ConfigListCommand::execute()
     cout << "core.cachePath=" << QDir::toNativeSeparators(app_.config().cachePath()) << Qt::endl;
     cout << "core.installPath=" << QDir::toNativeSeparators(app_.config().installPath()) << Qt::endl;
     cout << "core.localPath=" << QDir::toNativeSeparators(app_.config().localPath()) << Qt::endl;
+    cout << "download.concurrency=" << app_.config().downloadConcurrency() << Qt::endl;
+    cout << "download.hostConcurrency=" << app_.config().downloadHostConcurrency() << Qt::endl;
+    cout << "download.infoBatchSize=" << app_.config().infoBatchSize() << Qt::endl;
+    cout << "download.infoCacheTtl=" << app_.config().infoCacheTtl() << Qt::endl;
+    cout << "download.streaming=" << (app_.config().downloadStreaming() ? "true" : "false") << Qt::endl;
+    cout << "download.mirrors=" << app_.config().downloadMirrors().join(',') << Qt::endl;
+    cout << "network.requestRate=" << app_.config().requestRate() << Qt::endl;
+    cout << "network.timeout=" << app_.config().requestTimeout() << Qt::endl;
+    cout << "network.maxRetries=" << app_.config().maxRetries() << Qt::endl;
+    cout << "network.retryDelay=" << app_.config().retryDelay() << Qt::endl;
 
     QTimer::singleShot(0, this, &Command::finished);
 }
@@ -39,6 +39,32 @@ void ConfigSetCommand::parse(QCommandLineParser &parser, const QStringList &args
 
 }
 
+std::optional<int> ConfigSetCommand::parseInt(int minimum)
+{
+    bool ok;
+    int number = value.toInt(&ok);
+    if (ok && number >= minimum)
+        return number;
+
+    QTextStream cerr(stderr);
+    cerr << app_.applicationName() << ": Expected a number of at least " << minimum << " for " << key << ": " << value << Qt::endl;
+    app_.exit(EXIT_FAILURE);
+    return {};
+}
+
+std::optional<bool> ConfigSetCommand::parseBool()
+{
+    if (value == "true" || value == "1")
+        return true;
+    if (value == "false" || value == "0")
+        return false;
+
+    QTextStream cerr(stderr);
+    cerr << app_.applicationName() << ": Expected true or false for " << key << ": " << value << Qt::endl;
+    app_.exit(EXIT_FAILURE);
+    return {};
+}
+
 void ConfigSetCommand::execute()
 {
     if (key == "core.cachePath")
@@ -53,6 +79,62 @@ void ConfigSetCommand::execute()
     {
         app_.config().setLocalPath(QDir::fromNativeSeparators(value));
     }
+    else if (key == "download.concurrency")
+    {
+        if (std::optional<int> number = parseInt(1))
+            app_.config().setDownloadConcurrency(*number);
+    }
+    else if (key == "download.hostConcurrency")
+    {
+        if (std::optional<int> number = parseInt(1))
+            app_.config().setDownloadHostConcurrency(*number);
+    }
+    else if (key == "download.infoBatchSize")
+    {
+        if (std::optional<int> number = parseInt(1))
+            app_.config().setInfoBatchSize(*number);
+    }
+    else if (key == "download.infoCacheTtl")
+    {
+        if (std::optional<int> number = parseInt(0))
+            app_.config().setInfoCacheTtl(*number);
+    }
+    else if (key == "download.streaming")
+    {
+        if (std::optional<bool> flag = parseBool())
+            app_.config().setDownloadStreaming(*flag);
+    }
+    else if (key == "download.mirrors")
+    {
+        // Comma-separated, in order of preference. Empty to use only Steam.
+        QStringList mirrors;
+        for (const QString &mirror : value.split(',', Qt::SkipEmptyParts))
+        {
+            const QString trimmed = mirror.trimmed();
+            mirrors.append(QDir::isAbsolutePath(trimmed) ? QDir::fromNativeSeparators(trimmed) : trimmed);
+        }
+        app_.config().setDownloadMirrors(mirrors);
+    }
+    else if (key == "network.requestRate")
+    {
+        if (std::optional<int> number = parseInt(0))
+            app_.config().setRequestRate(*number);
+    }
+    else if (key == "network.timeout")
+    {
+        if (std::optional<int> number = parseInt(0))
+            app_.config().setRequestTimeout(*number);
+    }
+    else if (key == "network.maxRetries")
+    {
+        if (std::optional<int> number = parseInt(0))
+            app_.config().setMaxRetries(*number);
+    }
+    else if (key == "network.retryDelay")
+    {
+        if (std::optional<int> number = parseInt(0))
+            app_.config().setRetryDelay(*number);
+    }
     else
     {
         QTextStream cerr(stderr);
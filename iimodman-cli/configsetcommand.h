@@ -3,6 +3,8 @@
 
 #include "command.h"
 
+#include <optional>
+
 
 namespace iimodmanager {
 
@@ -19,6 +21,9 @@ public:
 private:
     QString key;
     QString value;
+
+    std::optional<int> parseInt(int minimum);
+    std::optional<bool> parseBool();
 };
 
 }  // namespace iimodmanager
@@ -1,16 +1,42 @@
 #include "modmancliapplication.h"
 #include "commandparser.h"
 #include "command.h"
+#include "servecommand.h"
 
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QTextStream>
 
 namespace iimodmanager {
 
 ModManCliApplication::ModManCliApplication(int &argc, char **argv[])
-    : QCoreApplication(argc, *argv), config_()
+    : QCoreApplication(argc, *argv), config_(), out_(&stdout_), servedCache_(nullptr), servedModList_(nullptr)
 {
     setApplicationName(ModManConfig::applicationName);
     setOrganizationName(ModManConfig::organizationName);
+
+    // Unbuffered, so that output stays in order with anything written directly to stdout.
+    stdout_.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+void ModManCliApplication::setOutput(QIODevice *device)
+{
+    out_ = device ? device : &stdout_;
+}
+
+void ModManCliApplication::writeRecord(const QJsonObject &record)
+{
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    out_->write(line);
+    if (out_ == &stdout_)
+        stdout_.flush();
+}
+
+void ModManCliApplication::setServedState(ModCache *cache, ModList *modList)
+{
+    servedCache_ = cache;
+    servedModList_ = modList;
 }
 
 int ModManCliApplication::main(int argc, char *argv[])
@@ -22,6 +48,11 @@ int ModManCliApplication::main(int argc, char *argv[])
     CommandParser parser(app);
     Command *command = parser.parse(app.arguments());
 
+    // Let a running server answer from its loaded cache, if it can.
+    int exitCode;
+    if (command->canServe() && ServeCommand::forward(app, &exitCode))
+        return exitCode;
+
     connect(command, &Command::finished, &app, &QCoreApplication::quit);
 
     command->execute();
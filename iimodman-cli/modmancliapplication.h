@@ -2,10 +2,16 @@
 #define MODMANCLIAPPLICATION_H
 
 #include <QCoreApplication>
+#include <QFile>
 #include <modmanconfig.h>
 
+class QJsonObject;
+
 namespace iimodmanager {
 
+class ModCache;
+class ModList;
+
 class ModManCliApplication: public QCoreApplication
 {
 public:
@@ -13,10 +19,26 @@ public:
 
     inline ModManConfig &config() { return config_; }
 
+    //! Where commands write their results: stdout, or a client's buffer while serving.
+    inline QIODevice *out() const { return out_; }
+    //! Redirects out() to the given device, or back to stdout if null.
+    void setOutput(QIODevice *device);
+    //! Writes one line of compact JSON to out(), flushed so that readers get each record as soon as it's known.
+    void writeRecord(const QJsonObject &record);
+
+    //! The cache and mod list kept loaded by the serve command, or null when each command loads its own.
+    inline ModCache *servedCache() const { return servedCache_; }
+    inline ModList *servedModList() const { return servedModList_; }
+    void setServedState(ModCache *cache, ModList *modList);
+
     static int main(int argc, char *argv[]);
 
 private:
     ModManConfig config_;
+    QFile stdout_;
+    QIODevice *out_;
+    ModCache *servedCache_;
+    ModList *servedModList_;
 };
 
 }  // namespace iimodmanager
@@ -2,6 +2,7 @@
 #include "modslistcommand.h"
 
 #include <QCommandLineParser>
+#include <QJsonObject>
 #include <QTextStream>
 #include <QTimer>
 #include <modcache.h>
@@ -22,6 +23,8 @@ void ModsListCommand::addTerminalArgs(QCommandLineParser &parser) const
                           {"hash", "Print mod version hashes."},
                           {"spec", "Format output as a mod-spec."},
                           {"spec-full", "Format output as a full versioned mod-spec."},
+                          {"spec-lock", "Format output as a versioned mod-spec that also locks each mod's hash and size."},
+                          {"json", "Write one JSON object per line for each mod, as each mod folder is read.\nHashes and matching cached versions are included with --hash."},
                       });
 }
 
@@ -29,45 +32,77 @@ void ModsListCommand::parse(QCommandLineParser &parser, const QStringList &args)
 {
     Q_UNUSED(args);
 
-    format = parser.isSet("spec-full") ? MODSPEC_VERSIONED : parser.isSet("spec") ? MODSPEC : TEXT;
+    format = parser.isSet("json") ? JSON
+            : parser.isSet("spec-lock") ? MODSPEC_LOCKED
+            : parser.isSet("spec-full") ? MODSPEC_VERSIONED
+            : parser.isSet("spec") ? MODSPEC
+            : TEXT;
     includeHashes = parser.isSet("hash");
 }
 
 void ModsListCommand::execute()
 {
-    ModCache cache(app_.config());
-    ModList modList(app_.config(), &cache);
-
-    if (format == TEXT || format == MODSPEC_VERSIONED)
+    ModList *modList = app_.servedModList();
+    if (!modList && format == JSON)
     {
-        cache.refresh(ModCache::LATEST_ONLY);
-        modList.refresh();
+        // No widths to measure, so each record is written as soon as its folder has been read.
+        ModCache *cache = new ModCache(app_.config(), this);
+        modList = new ModList(app_.config(), cache, this);
+        if (includeHashes)
+            cache->refresh(ModCache::LATEST_ONLY);
+        modList->refresh(includeHashes ? ModList::FULL : ModList::CONTENT_ONLY,
+                         [this](const InstalledMod &mod) { writeJsonMod(mod); });
+
+        QTimer::singleShot(0, this, &Command::finished);
+        return;
     }
-    else
+    if (!modList)
     {
-        modList.refresh(ModList::CONTENT_ONLY);
+        ModCache *cache = new ModCache(app_.config(), this);
+        modList = new ModList(app_.config(), cache, this);
+
+        if (format == TEXT || format == MODSPEC_VERSIONED || format == MODSPEC_LOCKED)
+        {
+            cache->refresh(ModCache::LATEST_ONLY);
+            modList->refresh();
+        }
+        else
+        {
+            modList->refresh(ModList::CONTENT_ONLY);
+        }
     }
 
     if (format == TEXT)
     {
         maxWidth = 0;
-        for (auto mod : modList.mods()) {
+        for (auto mod : modList->mods()) {
         const int width = mod.id().size() + mod.info().name().size() + 3;
         if (width > maxWidth)
             maxWidth = width;
         }
 
-        QTextStream cout(stdout);
+        QTextStream cout(app_.out());
         cout.setFieldAlignment(QTextStream::AlignLeft);
-        for (auto mod : modList.mods()) {
+        for (auto mod : modList->mods()) {
             writeTextMod(cout, mod);
         }
     }
+    else if (format == JSON)
+    {
+        for (const InstalledMod &mod : modList->mods())
+            writeJsonMod(mod);
+    }
     else
     {
-        QTextStream cout(stdout);
-        for (auto mod : modList.mods()) {
-            if (format == MODSPEC_VERSIONED)
+        QTextStream cout(app_.out());
+        for (auto mod : modList->mods()) {
+            if (format == MODSPEC_LOCKED)
+            {
+                // Hashing fills in the size of mods that aren't in the cache.
+                const QString &hash = mod.hash();
+                cout << mod.asSpec().withLock(hash, mod.knownSize()).asLockedSpecString() << Qt::endl;
+            }
+            else if (format == MODSPEC_VERSIONED)
                 cout << mod.asSpec().asVersionedSpecString() << Qt::endl;
             else
                 cout << mod.asSpec().asSpecString() << Qt::endl;
@@ -95,4 +130,31 @@ void ModsListCommand::writeTextMod(QTextStream &cout, const InstalledMod &mod)
     cout << Qt::endl;
 }
 
+void ModsListCommand::writeJsonMod(const InstalledMod &mod)
+{
+    QJsonObject record;
+    record["modId"] = mod.id();
+    if (!mod.alias().isEmpty())
+        record["alias"] = mod.alias();
+    record["name"] = mod.info().name();
+    if (!mod.info().version().isEmpty())
+        record["version"] = mod.info().version();
+    if (includeHashes)
+    {
+        record["hash"] = mod.hash();
+        record["inCache"] = mod.hasCacheVersion();
+        if (const CachedVersion *cv = mod.cacheVersion())
+        {
+            record["versionId"] = cv->id();
+            if (cv->timestamp())
+                record["timestamp"] = cv->timestamp()->toString(Qt::ISODate);
+        }
+    }
+    // Without a hash, only list the installed files rather than reading them.
+    record["size"] = includeHashes && mod.knownSize() >= 0 ? mod.knownSize() : mod.size();
+    if (mod.knownFileCount() >= 0)
+        record["files"] = mod.knownFileCount();
+    app_.writeRecord(record);
+}
+
 } // namespace iimodmanager
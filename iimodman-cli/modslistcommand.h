@@ -20,6 +20,7 @@ public:
     void addTerminalArgs(QCommandLineParser &parser) const;
     void parse(QCommandLineParser &parser, const QStringList &args);
     void execute();
+    bool canServe() const { return true; }
 
 private:
     enum OutputFormat
@@ -27,12 +28,15 @@ private:
         TEXT,
         MODSPEC,
         MODSPEC_VERSIONED,
+        MODSPEC_LOCKED,
+        JSON,
     };
     OutputFormat format;
     bool includeHashes;
     int maxWidth;
 
     void writeTextMod(QTextStream &out, const InstalledMod &mod);
+    void writeJsonMod(const InstalledMod &mod);
 };
 
 } // namespace iimodmanager
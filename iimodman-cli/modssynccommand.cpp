@@ -1,20 +1,24 @@
 #include "confirmationprompt.h"
 #include "modmancliapplication.h"
 #include "modssynccommand.h"
+#include "updatemodsimpl.h"
 
 #include <QCommandLineParser>
 #include <QFile>
+#include <QHash>
 #include <QTextStream>
 #include <QTimer>
+#include <algorithm>
 #include <modcache.h>
 #include <modinfo.h>
 #include <modlist.h>
 #include <modspec.h>
+#include <modsyncplan.h>
 
 namespace iimodmanager {
 
 ModsSyncCommand::ModsSyncCommand(ModManCliApplication &app)
-    : Command(app), isForceSet(false)
+    : Command(app), isForceSet(false), isCheckSet(false), isFetchSet(false), hasFailure(false), fetchImpl(nullptr)
 {}
 
 void ModsSyncCommand::addTerminalArgs(QCommandLineParser &parser) const
@@ -23,6 +27,8 @@ void ModsSyncCommand::addTerminalArgs(QCommandLineParser &parser) const
     parser.addOptions({
                           {{"s", "spec"}, "Spec file, such as the output of a list --spec command.", "specfile"},
                           {{"f", "force"}, "Remove non-matching mods even if they're not in the cache."},
+                          {"check", "Only report whether the installed mods match the spec, such as a --spec-lock list.\nExits with an error if anything would change."},
+                          {"fetch", "Download mods that aren't in the cache, installing each one as soon as it arrives.\nOnly the latest version of a workshop mod can be downloaded."},
                       });
 }
 
@@ -31,6 +37,8 @@ void ModsSyncCommand::parse(QCommandLineParser &parser, const QStringList &args)
     Q_UNUSED(args);
 
     isForceSet = parser.isSet("force");
+    isCheckSet = parser.isSet("check");
+    isFetchSet = parser.isSet("fetch");
 
     if (parser.isSet("spec"))
     {
@@ -43,10 +51,8 @@ void ModsSyncCommand::execute()
     cache = new ModCache(app_.config(), this);
     modList = new ModList(app_.config(), cache, this);
     cache->refresh(ModCache::LATEST_ONLY);
-    modList->refresh();
 
     inputSpec = new ModSpec(this);
-    targetSpec = new ModSpec(this);
 
 
     // Read input
@@ -54,6 +60,7 @@ void ModsSyncCommand::execute()
     bool success = true;
     if (specFileNames.isEmpty())
     {
+        modList->refresh();
         for (const auto &im : modList->mods())
             inputSpec->append(im.asSpec().withoutVersion());
     }
@@ -67,24 +74,44 @@ void ModsSyncCommand::execute()
         QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
         return;
     }
+    if (!specFileNames.isEmpty())
+    {
+        // Checking a fully locked spec only compares each installed mod against its lock, and hashes it only if
+        // the size matches. Skips hashing every installed mod to match it with the cache.
+        const QList<SpecMod> &specMods = inputSpec->mods();
+        const bool isLockedCheck = isCheckSet && std::all_of(specMods.begin(), specMods.end(), [](const SpecMod &sm) { return sm.isLocked(); });
+        modList->refresh(isLockedCheck ? ModList::CONTENT_ONLY : ModList::FULL);
+    }
 
     // Match up with cached and installed mods
-    qsizetype inputSize = inputSpec->mods().size();
-    targetSpec->reserve(inputSize);
-    addedMods.reserve(inputSize);
-    updatedMods.reserve(inputSize);
-    removedMods.reserve(inputSize);
-    success = true;
-    for (const auto &specMod : inputSpec->mods())
+    ModSyncPlan::refreshPinnedVersions(*cache, inputSpec->mods());
+    ModSyncPlan plan = ModSyncPlan::build(*cache, *modList, inputSpec->mods());
+    if (isFetchSet && !isCheckSet)
     {
-        std::optional<SpecMod> targetSpecMod = makeInstallTarget(specMod);
-        if (targetSpecMod)
-            targetSpec->append(*targetSpecMod);
-        else
-            success = false;
+        // Mods missing from the cache are planned again once they've been downloaded.
+        QHash<QString, SpecMod> specMods;
+        specMods.reserve(inputSpec->mods().size());
+        for (const SpecMod &sm : inputSpec->mods())
+            specMods.insert(sm.id(), sm);
+        const int missingIssues = ModChange::NOT_FOUND | ModChange::NOT_DOWNLOADED | ModChange::VERSION_NOT_CACHED;
+        for (auto it = plan.changes.begin(); it != plan.changes.end();)
+        {
+            if (it->issues & missingIssues)
+            {
+                fetchedMods.append(specMods.value(it->modId));
+                it = plan.changes.erase(it);
+            }
+            else
+                ++it;
+        }
     }
-    for (const auto &im : modList->mods())
-        success &= checkInstalledMod(im);
+    success = true;
+    for (const ModChange &change : plan.changes)
+        success &= checkChange(change);
+    QStringList errors;
+    success &= plan.collect(*cache, *modList, &addedMods, &updatedMods, &removedMods, &errors);
+    for (const QString &error : qAsConst(errors))
+        QTextStream(stderr) << error << Qt::endl;
     if (!success)
     {
         QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
@@ -118,13 +145,29 @@ void ModsSyncCommand::execute()
         cerr << QString("\"%1\" [%2 %3] ").arg(sm.name(), sm.id(), sm.versionName());
         cerr << Qt::endl;
     }
+    if (!fetchedMods.empty())
+    {
+        hasAction = true;
+        cerr << "The following mods will be downloaded and installed:" << Qt::endl << "  ";
+        for (const SpecMod &sm : qAsConst(fetchedMods))
+        cerr << QString("\"%1\" [%2 %3] ").arg(sm.name(), sm.id(), sm.versionId().isEmpty() ? QStringLiteral("latest") : sm.versionName());
+        cerr << Qt::endl;
+    }
 
     if (!hasAction)
     {
-        cerr << "No mods to update or remove." << Qt::endl;
+        cerr << (isCheckSet ? "Installed mods match the spec." : "No mods to update or remove.") << Qt::endl;
         QTimer::singleShot(0, this, &Command::finished);
         return;
     }
+    if (isCheckSet)
+    {
+        QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
+        return;
+    }
+
+    const SyncCost cost = SyncCost::estimate(*cache, *modList, addedMods, updatedMods, removedMods);
+    cerr << "Estimated cost: " << cost.toString() << Qt::endl;
 
     prompt = new ConfirmationPrompt(this);
     connect(prompt, &ConfirmationPrompt::yes, this, &ModsSyncCommand::doSync);
@@ -139,15 +182,73 @@ void ModsSyncCommand::doSync()
 {
     for (const InstalledMod &sm : removedMods)
         if (!removeMod(sm))
-            emit finished();
+            hasFailure = true;
+
+    // Downloads and extraction continue in the background while cached mods are installed.
+    if (!fetchedMods.empty())
+        startFetch();
+
     for (const SpecMod &sm : addedMods)
         if (!installMod(sm))
-            emit finished();
+            hasFailure = true;
     for (const SpecMod &sm : updatedMods)
         if (!installMod(sm))
-            emit finished();
+            hasFailure = true;
 
-    emit finished();
+    if (!fetchImpl)
+        finishSync();
+}
+
+void ModsSyncCommand::startFetch()
+{
+    QStringList modIds;
+    modIds.reserve(fetchedMods.size());
+    for (const SpecMod &sm : qAsConst(fetchedMods))
+        modIds.append(sm.id());
+
+    fetchImpl = new UpdateModsImpl(app_, cache, nullptr, this);
+    fetchImpl->setVerb(UpdateModsImpl::VERB_DOWNLOAD);
+    fetchImpl->setMissingCacheAction(UpdateModsImpl::CACHE_ADD);
+    fetchImpl->setConfirmBeforeDownloading(false);
+    connect(fetchImpl, &UpdateModsImpl::versionDownloaded, this, [this](const QString &modId) {
+        for (qsizetype i = 0; i < fetchedMods.size(); ++i)
+        {
+            if (fetchedMods.at(i).id() == modId)
+            {
+                if (!installFetchedMod(fetchedMods.takeAt(i)))
+                    hasFailure = true;
+                break;
+            }
+        }
+    });
+    connect(fetchImpl, &UpdateModsImpl::finished, this, &ModsSyncCommand::fetchFinished);
+    fetchImpl->start(modIds);
+}
+
+void ModsSyncCommand::fetchFinished()
+{
+    // Whatever is left wasn't downloaded, or was already the latest version. Report why it can't be installed.
+    for (const SpecMod &sm : qAsConst(fetchedMods))
+        if (!installFetchedMod(sm))
+            hasFailure = true;
+    fetchedMods.clear();
+    if (!fetchImpl->success())
+        hasFailure = true;
+
+    fetchImpl->deleteLater();
+    fetchImpl = nullptr;
+    finishSync();
+}
+
+void ModsSyncCommand::finishSync()
+{
+    // Persist measured sizes and throughput for future estimates.
+    cache->saveMetadata();
+
+    if (hasFailure)
+        app_.exit(EXIT_FAILURE);
+    else
+        emit finished();
 }
 
 bool ModsSyncCommand::readSpecFile(const QString &fileName)
@@ -162,63 +263,42 @@ bool ModsSyncCommand::readSpecFile(const QString &fileName)
     return true;
 }
 
-std::optional<SpecMod> ModsSyncCommand::makeInstallTarget(const SpecMod &sm)
+bool ModsSyncCommand::checkChange(const ModChange &change)
 {
-    const InstalledMod *im = modList->mod(sm.id());
-    const CachedMod *cm = cache->mod(sm.id());
-    if ((!cm && im && sm.versionId().isEmpty()) // Assume we're just using the existing version.
-            || (im && sm.versionId() == '-')) // Explicitly using the existing version.
+    if (change.hasIssue(ModChange::NOT_FOUND))
     {
-        if (sm.alias() == im->alias())
-            return im->asSpec();
-        else
-        {
-            QTextStream(stderr) << "Request has a different alias than the installed mod being retained: " << sm.name() << " [" << sm.id() << ']' << Qt::endl;
-            return {};
-        }
+        QTextStream(stderr) << "Mod does not exist in cache: " << change.modName << " [" << change.modId << ']' << Qt::endl;
+        return false;
     }
-    else if (!cm)
+    if (change.hasIssue(ModChange::NOT_DOWNLOADED))
     {
-        QTextStream(stderr) << "Mod does not exist in cache: " << sm.name() << " [" << sm.id() << ']' << Qt::endl;
-        return {};
+        QTextStream(stderr) << "Mod has no downloaded versions: " << change.modName << " [" << change.modId << ']' << Qt::endl;
+        return false;
     }
-    if (!cm->downloaded())
+    if (change.hasIssue(ModChange::LOCK_MISMATCH))
     {
-        QTextStream(stderr) << "Mod has no downloaded versions: " << cm->info().toString() << Qt::endl;
-        return {};
+        if (change.requestedVersionId.isEmpty() || change.requestedVersionId == '-')
+            QTextStream(stderr) << "Neither the installed nor any cached mod version matches the locked hash: " << change.modName << " [" << change.modId << ']' << Qt::endl;
+        else
+            QTextStream(stderr) << "Cached mod version doesn't match the locked hash: " << change.modName << " [" << change.modId << "] " << change.requestedVersionId << Qt::endl;
+        return false;
     }
-
-    const CachedVersion *cv = sm.versionId().isEmpty() ? cm->latestVersion() : cache->refreshVersion(sm.id(), sm.versionId());
-    if (!cv)
+    if (change.hasIssue(ModChange::VERSION_NOT_CACHED))
     {
-        QTextStream(stderr) << "Mod version is not in cache: " << cm->info().toString() << ' ' << sm.versionId() << Qt::endl;
-        return {};
+        QTextStream(stderr) << "Mod version is not in cache: " << change.modName << " [" << change.modId << "] " << change.requestedVersionId << Qt::endl;
+        return false;
     }
-
-    SpecMod targetMod = cv->asSpec();
-
-    if (!im)
-        addedMods.append(targetMod);
-    else if (!cv->installed())
-        updatedMods.append(targetMod);
-
-    return targetMod;
-}
-
-bool ModsSyncCommand::checkInstalledMod(const InstalledMod &im)
-{
-    const QString &modId = im.id();
-    if (targetSpec->contains(modId))
-        return true;
-
-    removedMods.append(im);
-
-    if (!im.hasCacheVersion() && !isForceSet)
+    if (change.isUncachedMove())
     {
-        QTextStream(stderr) << "Trying to remove a mod version that isn't saved in the mod cache (-f to override): " << im.info().toString() << ' ' << im.info().version() << Qt::endl;
+        QTextStream(stderr) << "Request has a different alias than the installed mod being retained: " << change.modName << " [" << change.modId << ']' << Qt::endl;
+        return false;
+    }
+    if (change.hasIssue(ModChange::REMOVES_UNCACHED) && !isForceSet)
+    {
+        const InstalledMod *im = modList->mod(change.modId);
+        QTextStream(stderr) << "Trying to remove a mod version that isn't saved in the mod cache (-f to override): " << im->info().toString() << ' ' << im->info().version() << Qt::endl;
         return false;
     }
-
     return true;
 }
 
@@ -252,5 +332,36 @@ bool ModsSyncCommand::installMod(const SpecMod &specMod)
     return installed;
 }
 
+bool ModsSyncCommand::installFetchedMod(const SpecMod &specMod)
+{
+    ModSyncPlan::refreshPinnedVersions(*cache, {specMod});
+    const ModChange change = ModChange::plan(*cache, *modList, specMod);
+    if (change.hasIssue(ModChange::VERSION_NOT_CACHED))
+    {
+        QTextStream(stderr) << "Mod version can't be downloaded, as only the latest version is available: " << change.modName << " [" << change.modId << "] " << change.requestedVersionId << Qt::endl;
+        return false;
+    }
+    if (!checkChange(change))
+        return false;
+
+    QList<SpecMod> toInstall;
+    QList<SpecMod> toUpdate;
+    QList<InstalledMod> toRemove;
+    QString errorInfo;
+    if (!change.collect(*cache, *modList, &toInstall, &toUpdate, &toRemove, &errorInfo))
+    {
+        QTextStream(stderr) << errorInfo << Qt::endl;
+        return false;
+    }
+    bool success = true;
+    for (const InstalledMod &im : qAsConst(toRemove))
+        success &= removeMod(im);
+    for (const SpecMod &sm : qAsConst(toInstall))
+        success &= installMod(sm);
+    for (const SpecMod &sm : qAsConst(toUpdate))
+        success &= installMod(sm);
+    return success;
+}
+
 
 } // namespace iimodmanager
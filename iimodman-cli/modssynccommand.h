@@ -3,7 +3,6 @@
 
 #include "command.h"
 
-#include <optional>
 #include <modspec.h>
 
 namespace iimodmanager {
@@ -12,6 +11,8 @@ class ConfirmationPrompt;
 class InstalledMod;
 class ModCache;
 class ModList;
+class UpdateModsImpl;
+struct ModChange;
 
 class ModsSyncCommand : public Command
 {
@@ -26,28 +27,41 @@ private:
     ModCache *cache;
     ModList *modList;
     bool isForceSet;
+    //! Only compare against the spec, without changing anything.
+    bool isCheckSet;
+    //! Download mods and versions that are missing from the cache before installing them.
+    bool isFetchSet;
     QStringList specFileNames;
 
     // All ModSpec lines from input
     ModSpec *inputSpec;
-    // ModSpec with exact versions specified
-    ModSpec *targetSpec;
     // Mods that need to be newly installed
     QList<SpecMod> addedMods;
     // Mods that need to be updated
     QList<SpecMod> updatedMods;
     // Mods that need to be removed
     QList<InstalledMod> removedMods;
+    // Mods that need to be downloaded before they can be installed
+    QList<SpecMod> fetchedMods;
+    //! Set if any part of the sync failed.
+    bool hasFailure;
+
+    UpdateModsImpl *fetchImpl;
 
     ConfirmationPrompt *prompt;
 
     void doSync();
+    void startFetch();
+    void fetchFinished();
+    void finishSync();
 
     bool readSpecFile(const QString &fileName);
-    std::optional<SpecMod> makeInstallTarget(const SpecMod &inputSpec);
-    bool checkInstalledMod(const InstalledMod &installedMod);
+    //! Reports any part of the planned change that can't be applied as requested.
+    bool checkChange(const ModChange &change);
     bool removeMod(const InstalledMod &installedMod);
     bool installMod(const SpecMod &specMod);
+    //! Plans and applies a spec line again, now that its download has finished.
+    bool installFetchedMod(const SpecMod &specMod);
 };
 
 } // namespace iimodmanager
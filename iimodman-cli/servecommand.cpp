@@ -0,0 +1,363 @@
+#include "commandparser.h"
+#include "modmancliapplication.h"
+#include "servecommand.h"
+
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+#include <modcache.h>
+#include <modlist.h>
+
+namespace iimodmanager {
+
+//! Bumped whenever requests or responses change shape, so that mismatched clients fall back to running locally.
+static const int protocolVersion = 1;
+static const int connectTimeoutMs = 200;
+static const int responseTimeoutMs = 60000;
+//! Changes usually arrive in bursts, such as while a mod is being copied, so wait for them to settle before reloading.
+static const int refreshDelayMs = 250;
+//! Set this environment variable to always run commands locally.
+static const char noServerVariable[] = "IIMODMAN_NO_SERVER";
+
+ServeCommand::ServeCommand(ModManCliApplication &app)
+    : Command(app), cache(nullptr), modList(nullptr), server(nullptr), watcher(nullptr), refreshTimer(nullptr),
+      isRunning(false)
+{}
+
+void ServeCommand::addTerminalArgs(QCommandLineParser &parser) const
+{
+    parser.addPositionalArgument("serve", "Command: Keep the cache and installed mods loaded, and answer list commands from other invocations until stopped.");
+}
+
+void ServeCommand::parse(QCommandLineParser &parser, const QStringList &args)
+{
+    Q_UNUSED(parser);
+    Q_UNUSED(args);
+}
+
+void ServeCommand::execute()
+{
+    cache = new ModCache(app_.config(), this);
+    modList = new ModList(app_.config(), cache, this);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(refreshDelayMs);
+    connect(refreshTimer, &QTimer::timeout, this, &ServeCommand::refreshIfChanged);
+
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+        changedPaths.insert(path);
+        refreshTimer->start();
+    });
+
+    refresh();
+    app_.setServedState(cache, modList);
+
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &ServeCommand::acceptConnections);
+    if (!listen())
+    {
+        QTimer::singleShot(0, this, [this](){ app_.exit(EXIT_FAILURE); });
+        return;
+    }
+
+    QTextStream cerr(stderr);
+    cerr << "Serving " << cache->mods().size() << " cached and " << modList->mods().size() << " installed mods on " << server->fullServerName() << Qt::endl;
+}
+
+bool ServeCommand::forward(ModManCliApplication &app, int *exitCode)
+{
+    if (qEnvironmentVariableIsSet(noServerVariable))
+        return false;
+
+    const QString name = serverName(app.config());
+    if (name.isEmpty())
+        return false;
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (!socket.waitForConnected(connectTimeoutMs))
+        return false;
+
+    QJsonObject request;
+    request["protocol"] = protocolVersion;
+    request["arguments"] = QJsonArray::fromStringList(app.arguments());
+    socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+
+    // Served commands don't change anything, so it's safe to run locally if the server goes away.
+    while (!socket.canReadLine())
+        if (!socket.waitForReadyRead(responseTimeoutMs))
+            return false;
+    const QJsonObject response = QJsonDocument::fromJson(socket.readLine()).object();
+    if (!response.contains("exitCode"))
+        return false;
+
+    app.out()->write(QByteArray::fromBase64(response["out"].toString().toLatin1()));
+    *exitCode = response["exitCode"].toInt();
+    return true;
+}
+
+QString ServeCommand::serverName(const ModManConfig &config)
+{
+    // One server per set of folders, so that a server never answers for a different configuration.
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QDir(config.cachePath()).absolutePath().toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(QDir(config.modPath()).absolutePath().toUtf8());
+    const QString name = QStringLiteral("iimodman-%1").arg(QString::fromLatin1(hash.result().toHex().left(16)));
+#ifdef Q_OS_WIN
+    // A pipe name, rather than a path. UserAccessOption limits the pipe to the current user.
+    return name;
+#else
+    // In a folder of our own inside the user's runtime folder, rather than the shared temporary folder,
+    // where other users could see or take the name.
+    const QString runtimePath = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimePath.isEmpty())
+        return QString();
+    return QDir(runtimePath).filePath(QStringLiteral("iimodman/%1.sock").arg(name));
+#endif
+}
+
+bool ServeCommand::listen()
+{
+    QTextStream cerr(stderr);
+    const QString name = serverName(app_.config());
+    if (name.isEmpty())
+    {
+        cerr << app_.applicationName() << ": Couldn't start server: No runtime folder for the socket" << Qt::endl;
+        return false;
+    }
+#ifndef Q_OS_WIN
+    const QString socketDirPath = QFileInfo(name).absolutePath();
+    if (!QDir().mkpath(socketDirPath)
+            || !QFile::setPermissions(socketDirPath, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner))
+    {
+        cerr << app_.applicationName() << ": Couldn't start server: Couldn't create " << socketDirPath << Qt::endl;
+        return false;
+    }
+#endif
+    if (server->listen(name))
+        return true;
+
+    if (server->serverError() == QAbstractSocket::AddressInUseError)
+    {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(connectTimeoutMs))
+        {
+            cerr << app_.applicationName() << ": A server is already running for these folders." << Qt::endl;
+            return false;
+        }
+
+        // Left behind by a server that didn't shut down cleanly. Only this user can create sockets in the folder,
+        // so the stale socket is this user's own.
+        QLocalServer::removeServer(name);
+        if (server->listen(name))
+            return true;
+    }
+    cerr << app_.applicationName() << ": Couldn't start server: " << server->errorString() << Qt::endl;
+    return false;
+}
+
+void ServeCommand::refresh()
+{
+    changedPaths.clear();
+    // Watch first, so that anything that changes during the refresh triggers another one.
+    watchFolders();
+    cache->refresh(ModCache::FULL);
+    modList->refresh(ModList::FULL);
+}
+
+void ServeCommand::refreshIfChanged()
+{
+    if (changedPaths.isEmpty())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    const QSet<QString> paths = changedPaths;
+    changedPaths.clear();
+    int cachedCount, installedCount;
+    if (!refreshChangedMods(paths, &cachedCount, &installedCount))
+    {
+        refresh();
+        cachedCount = cache->mods().size();
+        installedCount = modList->mods().size();
+    }
+    QTextStream(stderr) << "Reloaded " << cachedCount << " cached and " << installedCount << " installed mods in " << timer.elapsed() << " ms" << Qt::endl;
+}
+
+bool ServeCommand::refreshChangedMods(const QSet<QString> &paths, int *cachedCount, int *installedCount)
+{
+    // Mods were added or removed, which also changes which folders are watched.
+    const QString cacheRoot = QDir(app_.config().cachePath()).absolutePath();
+    const QString modRoot = QDir(app_.config().modPath()).absolutePath();
+    if (paths.contains(cacheRoot) || paths.contains(modRoot))
+        return false;
+
+    QSet<QString> installedIds;
+    *cachedCount = 0;
+    for (const QString &path : paths)
+    {
+        const QFileInfo info(path);
+        if (info.absolutePath() == cacheRoot)
+        {
+            // Served commands list every version, so load them all.
+            cache->refreshMod(info.fileName(), ModCache::FULL);
+            ++*cachedCount;
+            // A new or removed version may change which one is marked installed.
+            if (const InstalledMod *im = modList->mod(info.fileName()))
+                installedIds.insert(im->installedId());
+        }
+        else if (path.startsWith(modRoot + '/'))
+        {
+            // A change anywhere inside an installed mod changes its hash.
+            const QString relativePath = path.mid(modRoot.size() + 1);
+            installedIds.insert(relativePath.section('/', 0, 0));
+        }
+    }
+    // Served commands show each installed mod's cache version, so match it with the cache.
+    for (const QString &installedId : qAsConst(installedIds))
+        modList->refreshMod(installedId, ModList::FULL);
+    *installedCount = installedIds.size();
+    // Folders may have been added inside the changed mods.
+    watchFolders();
+    return true;
+}
+
+void ServeCommand::watchFolders()
+{
+    // Each mod's folder is watched as well, as adding a version or changing an installed mod doesn't touch the top folder.
+    // Cached versions don't change once added, but installed mods may be edited anywhere, so watch all of their folders.
+    QSet<QString> paths;
+    const QDir cacheDir(app_.config().cachePath());
+    if (cacheDir.exists())
+    {
+        paths.insert(cacheDir.absolutePath());
+        for (const QString &name : cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+            paths.insert(cacheDir.absoluteFilePath(name));
+    }
+    const QDir modDir(app_.config().modPath());
+    if (modDir.exists())
+    {
+        paths.insert(modDir.absolutePath());
+        QDirIterator it(modDir.absolutePath(), QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            paths.insert(it.next());
+    }
+
+    QStringList removedPaths;
+    for (const QString &path : watcher->directories())
+    {
+        if (!paths.remove(path))
+            removedPaths.append(path);
+    }
+    if (!removedPaths.isEmpty())
+        watcher->removePaths(removedPaths);
+    if (!paths.isEmpty())
+        watcher->addPaths(paths.values());
+}
+
+void ServeCommand::acceptConnections()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] { readRequest(socket); });
+    }
+}
+
+void ServeCommand::readRequest(QLocalSocket *socket)
+{
+    if (!socket->canReadLine())
+        return;
+    disconnect(socket, &QLocalSocket::readyRead, this, nullptr);
+
+    const QJsonObject request = QJsonDocument::fromJson(socket->readLine()).object();
+    if (request["protocol"].toInt() != protocolVersion)
+    {
+        // An empty response tells the client to run the command itself.
+        socket->write("{}\n");
+        socket->disconnectFromServer();
+        return;
+    }
+
+    QStringList arguments;
+    for (const QJsonValue &argument : request["arguments"].toArray())
+        arguments.append(argument.toString());
+    pending.append({socket, arguments});
+    startNext();
+}
+
+void ServeCommand::startNext()
+{
+    // Commands share the loaded state and output device, so they run one at a time.
+    while (!isRunning && !pending.isEmpty())
+    {
+        const Request request = pending.takeFirst();
+        isRunning = true;
+
+        // Pick up changes made just before the request, such as by a command that ran locally.
+        QCoreApplication::processEvents();
+        refreshIfChanged();
+        if (request.socket)
+            runRequest(request);
+        else
+            isRunning = false;
+    }
+}
+
+void ServeCommand::runRequest(const Request &request)
+{
+    // The client already parsed the same arguments, so they can't fail here.
+    CommandParser parser(app_);
+    Command *command = parser.parse(request.arguments);
+    command->setParent(this);
+    if (!command->canServe())
+    {
+        request.socket->write("{}\n");
+        request.socket->disconnectFromServer();
+        command->deleteLater();
+        isRunning = false;
+        return;
+    }
+
+    QBuffer *output = new QBuffer(command);
+    output->open(QIODevice::WriteOnly);
+    app_.setOutput(output);
+
+    QPointer<QLocalSocket> socket = request.socket;
+    connect(command, &Command::finished, this, [this, command, output, socket] {
+        app_.setOutput(nullptr);
+        if (socket)
+        {
+            QJsonObject response;
+            response["exitCode"] = EXIT_SUCCESS;
+            response["out"] = QString::fromLatin1(output->data().toBase64());
+            socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n');
+            socket->disconnectFromServer();
+        }
+        command->deleteLater();
+        isRunning = false;
+        QTimer::singleShot(0, this, &ServeCommand::startNext);
+    });
+    command->execute();
+}
+
+} // namespace iimodmanager
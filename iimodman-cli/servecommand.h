@@ -0,0 +1,74 @@
+#ifndef IIMODMANAGER_SERVECOMMAND_H
+#define IIMODMANAGER_SERVECOMMAND_H
+
+#include "command.h"
+
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+
+
+namespace iimodmanager {
+
+class ModCache;
+class ModList;
+class ModManConfig;
+
+//! Keeps the cache and mod list loaded, and answers read-only commands from other CLI invocations over a local socket.
+//! The socket lives in the user's private runtime folder, so only the same user can connect.
+//! The loaded state is refreshed whenever the watched cache or mods folders change, one mod at a time where possible.
+//! Every folder inside the installed mods is watched, so that edits to their files also refresh their hashes.
+class ServeCommand : public Command
+{
+public:
+    ServeCommand(ModManCliApplication &app);
+
+    // Command interface
+    void addTerminalArgs(QCommandLineParser &parser) const;
+    void parse(QCommandLineParser &parser, const QStringList &args);
+    void execute();
+
+    //! Runs the parsed command line on a server for the same folders, if one is running.
+    //! Returns false if the command should run locally instead.
+    static bool forward(ModManCliApplication &app, int *exitCode);
+
+private:
+    struct Request
+    {
+        QPointer<QLocalSocket> socket;
+        QStringList arguments;
+    };
+
+    ModCache *cache;
+    ModList *modList;
+    QLocalServer *server;
+    QFileSystemWatcher *watcher;
+    QTimer *refreshTimer;
+    //! Watched folders that changed since the last refresh.
+    QSet<QString> changedPaths;
+    bool isRunning;
+    QList<Request> pending;
+
+    //! Full path of the socket for the configured folders.
+    static QString serverName(const ModManConfig &config);
+
+    bool listen();
+    void refresh();
+    void refreshIfChanged();
+    //! Refreshes only the mods whose folders changed. Returns false if a top folder changed, which needs a full refresh.
+    bool refreshChangedMods(const QSet<QString> &paths, int *cachedCount, int *installedCount);
+    void watchFolders();
+    void acceptConnections();
+    void readRequest(QLocalSocket *socket);
+    void startNext();
+    void runRequest(const Request &request);
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_SERVECOMMAND_H
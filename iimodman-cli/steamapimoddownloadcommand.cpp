@@ -20,6 +20,7 @@ void SteamAPIDownloadModCommand::addTerminalArgs(QCommandLineParser &parser) con
     parser.addOptions({
                           {{"id", "steam-id"}, "REQUIRED: Steam workshop ID (e.g. '2151835746')", "id"},
                           {{"f","force"}, "Overwrite even if the latest version is already downloaded."},
+                          {"metrics", "Print transfer metrics as JSON on stdout when done."},
                       });
 }
 
@@ -39,6 +40,7 @@ void SteamAPIDownloadModCommand::parse(QCommandLineParser &parser, const QString
     impl->setAlreadyLatestVersionBehavior(parser.isSet("force") ? UpdateModsImpl::LATEST_FORCE : UpdateModsImpl::LATEST_SKIP);
     impl->setConfirmBeforeDownloading(false);
     impl->setVerbose(true);
+    impl->setPrintMetrics(parser.isSet("metrics"));
 
     modId = "workshop-" + parser.value("steam-id");
 
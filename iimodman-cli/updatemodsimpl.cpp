@@ -3,6 +3,9 @@
 
 #include <iostream>
 #include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QTimer>
 #include <QThreadPool>
 #include <modcache.h>
@@ -23,11 +26,16 @@ UpdateModsImpl::UpdateModsImpl(ModManCliApplication &app, ModCache *cache, ModDo
       missingCacheAction(CACHE_SKIP),
       alreadyLatestVersionAction(LATEST_SKIP),
       confirmBeforeDownloading(true),
-      success_(false)
+      verbose(false),
+      printMetrics(false),
+      success_(false),
+      steamInfoCall(nullptr),
+      downloadQueue(nullptr)
 {}
 
 void UpdateModsImpl::start(const QStringList &modIds)
 {
+    startStats = downloader->requestStats();
     if (cache_->mods().isEmpty())
         cache_->refresh(ModCache::LATEST_ONLY);
 
@@ -39,6 +47,7 @@ void UpdateModsImpl::start(const QStringList &modIds)
 
         // Use a single-shot timer in case the event loop hasn't started yet.
         QTimer::singleShot(0, this, [this]{
+            reportMetrics();
             success_ = true;
             emit finished();
         });
@@ -99,39 +108,36 @@ QString UpdateModsImpl::checkModId(const QString &modId)
 
 void UpdateModsImpl::startInfos()
 {
-    steamInfoCall = downloader->modInfoCall();
-    connect(steamInfoCall, &ModInfoCall::finished, this, &UpdateModsImpl::steamInfoFinished);
+    steamInfoCall = downloader->modInfoBatchCall();
+    connect(steamInfoCall, &ModInfoBatchCall::finished, this, &UpdateModsImpl::steamInfosFinished);
 
     steamInfos.clear();
     steamInfos.reserve(workshopIds.size());
 
-    loopIndex = 0;
-    steamInfoCall->start(workshopIds.first());
+    steamInfoCall->start(workshopIds);
 }
 
-void UpdateModsImpl::nextSteamInfo()
+void UpdateModsImpl::steamInfosFinished()
 {
-    if (++loopIndex < workshopIds.size())
-    {
-        // Next steamInfo
-        steamInfoCall->start(workshopIds.at(loopIndex));
-    }
-    else if (steamInfos.empty())
+    for (qsizetype i = 0; i < steamInfoCall->size(); ++i)
+        steamInfoFinished(i);
+    steamInfoCall->deleteLater();
+    steamInfoCall = nullptr;
+
+    if (steamInfos.empty())
     {
         // No downloads needed.
-        steamInfoCall->deleteLater();
-        steamInfoCall = nullptr;
         success_ = true;
 
         QTextStream cerr(stderr);
         cerr << (verb == VERB_UPDATE ? "No mods to update." : "No mods to download.") << Qt::endl;
+        reportRequestStats();
+        reportMetrics();
         emit finished();
     }
     else
     {
         // Begin downloading.
-        steamInfoCall->deleteLater();
-        steamInfoCall = nullptr;
         if (confirmBeforeDownloading)
             confirmDownloads();
         else
@@ -161,41 +167,79 @@ void UpdateModsImpl::confirmDownloads()
 
 void UpdateModsImpl::startDownloads()
 {
-    steamDownloadCall = downloader->modDownloadCall(*cache_);
-    connect(steamDownloadCall, &ModDownloadCall::finished, this, &UpdateModsImpl::steamDownloadFinished);
+    downloadQueue = downloader->downloadQueue(*cache_);
+    connect(downloadQueue, &ModDownloadQueue::downloadCompleted, this, &UpdateModsImpl::steamDownloadCompleted);
+    connect(downloadQueue, &ModDownloadQueue::downloadFinished, this, &UpdateModsImpl::steamDownloadFinished);
+    connect(downloadQueue, &ModDownloadQueue::finished, this, &UpdateModsImpl::downloadsFinished);
+
+    downloadQueue->start(steamInfos);
+}
+
+void UpdateModsImpl::downloadsFinished()
+{
+    cache_->saveMetadata();
+    reportRequestStats();
+    reportMetrics();
+    downloadQueue->deleteLater();
+    downloadQueue = nullptr;
 
-    loopIndex = 0;
-    steamDownloadCall->start(steamInfos.first());
+    success_ = true;
+    emit finished();
 }
 
-void UpdateModsImpl::nextDownload()
+void UpdateModsImpl::reportRequestStats()
 {
-    if (++loopIndex < steamInfos.size())
+    const RequestScheduler::Stats stats = downloader->requestStats() - startStats;
+    if (verbose || stats.retries > 0 || stats.timeouts > 0)
     {
-        // Next download.
-        steamDownloadCall->start(steamInfos.at(loopIndex));
+        QTextStream cerr(stderr);
+        cerr << "Network: " << stats.toString() << Qt::endl;
     }
-    else
-    {
-        // Finished.
-        steamDownloadCall->deleteLater();
-        steamDownloadCall = nullptr;
+}
 
-        cache_->saveMetadata();
-        success_ = true;
-        emit finished();
+void UpdateModsImpl::reportMetrics()
+{
+    if (!printMetrics)
+        return;
+
+    QJsonArray downloads;
+    DownloadSummary summary;
+    if (downloadQueue)
+    {
+        summary = downloadQueue->summary();
+        for (int i = 0; i < downloadQueue->size(); ++i)
+        {
+            QJsonObject download = downloadQueue->metrics(i).toJson();
+            download["modId"] = downloadQueue->steamInfo(i).modId();
+            if (const CachedVersion *v = downloadQueue->resultVersion(i))
+                download["versionId"] = v->id();
+            downloads.append(download);
+        }
     }
+
+    const RequestScheduler::Stats stats = downloader->requestStats() - startStats;
+    QJsonObject network;
+    network["requests"] = stats.requests;
+    network["retries"] = stats.retries;
+    network["timeouts"] = stats.timeouts;
+    network["throttled"] = stats.throttled;
+
+    QJsonObject report;
+    report["downloads"] = downloads;
+    report["summary"] = summary.toJson();
+    report["network"] = network;
+    QTextStream cout(stdout);
+    cout << QJsonDocument(report).toJson(QJsonDocument::Compact) << Qt::endl;
 }
 
-void UpdateModsImpl::steamInfoFinished()
+void UpdateModsImpl::steamInfoFinished(qsizetype index)
 {
-    const SteamModInfo steamInfo = steamInfoCall->result();
+    const SteamModInfo steamInfo = steamInfoCall->result(index);
 
     if (!steamInfo.valid())
     {
         QTextStream cerr(stderr);
-        cerr << "workshop-" << steamInfoCall->workshopId() << " couldn't be added to cache. Skipping." << Qt::endl;
-        nextSteamInfo();
+        cerr << "workshop-" << steamInfoCall->workshopId(index) << " couldn't be added to cache: " << steamInfoCall->errorDetail(index) << ". Skipping." << Qt::endl;
         return;
     }
 
@@ -218,20 +262,22 @@ void UpdateModsImpl::steamInfoFinished()
     {
         steamInfos.append(steamInfo);
     }
+}
 
-    nextSteamInfo();
+void UpdateModsImpl::steamDownloadCompleted(int index)
+{
+    if (downloadQueue->resultVersion(index))
+        emit versionDownloaded(downloadQueue->steamInfo(index).modId());
 }
 
-void UpdateModsImpl::steamDownloadFinished()
+void UpdateModsImpl::steamDownloadFinished(int index)
 {
     QTextStream cerr(stderr);
-    const CachedVersion *v = steamDownloadCall->resultVersion();
+    const CachedVersion *v = downloadQueue->resultVersion(index);
     if (v)
         cerr << v->info().toString() << (verb == VERB_UPDATE ? " updated" : " downloaded") << Qt::endl;
     else
-        cerr << "Failed to " << (verb == VERB_UPDATE ? " update " : " download ") << steamDownloadCall->steamInfo().modId() << Qt::endl;
-
-    nextDownload();
+        cerr << "Failed to " << (verb == VERB_UPDATE ? " update " : " download ") << downloadQueue->steamInfo(index).modId() << Qt::endl;
 }
 
 } // namespace iimodmanager
@@ -3,15 +3,13 @@
 
 #include "modmancliapplication.h"
 
+#include <moddownloader.h>
+
 
 namespace iimodmanager {
 
 class ConfirmationPrompt;
 class ModCache;
-class ModDownloadCall;
-class ModDownloader;
-class ModInfoCall;
-struct SteamModInfo;
 
 //! Shared implementation for commands that update mods in the mod cache.
 class UpdateModsImpl : public QObject
@@ -45,10 +43,14 @@ public:
     void setAlreadyLatestVersionBehavior(AlreadyLatestVersionAction);
     void setConfirmBeforeDownloading(bool);
     void setVerbose(bool);
+    //! Prints transfer metrics as a single line of JSON on stdout once finished.
+    void setPrintMetrics(bool);
 
     void start(const QStringList &modIds);
 
 signals:
+    //! Emitted as soon as a mod's new version is in the cache, while other downloads may still be running.
+    void versionDownloaded(const QString &modId);
     void finished();
 
 private:
@@ -60,25 +62,30 @@ private:
     AlreadyLatestVersionAction alreadyLatestVersionAction;
     bool confirmBeforeDownloading;
     bool verbose;
+    bool printMetrics;
 
     bool success_;
-    ModInfoCall *steamInfoCall;
-    ModDownloadCall *steamDownloadCall;
+    ModInfoBatchCall *steamInfoCall;
+    ModDownloadQueue *downloadQueue;
     ConfirmationPrompt *prompt;
     QStringList workshopIds;
     QList<SteamModInfo> steamInfos;
-    qsizetype loopIndex;
+    //! Request totals before this update started, to report only this update's retries.
+    RequestScheduler::Stats startStats;
 
     QStringList checkModIds(const QStringList &modIds);
     QString checkModId(const QString &modId);
     void startInfos();
-    void nextSteamInfo();
     void confirmDownloads();
     void startDownloads();
-    void nextDownload();
-
-    void steamInfoFinished();
-    void steamDownloadFinished();
+    void downloadsFinished();
+    void reportRequestStats();
+    void reportMetrics();
+
+    void steamInfosFinished();
+    void steamInfoFinished(qsizetype index);
+    void steamDownloadCompleted(int index);
+    void steamDownloadFinished(int index);
 };
 
 inline void UpdateModsImpl::setVerb(UpdateModsImpl::ActionVerb verb)
@@ -106,6 +113,11 @@ inline void UpdateModsImpl::setVerbose(bool behavior)
     verbose = behavior;
 }
 
+inline void UpdateModsImpl::setPrintMetrics(bool behavior)
+{
+    printMetrics = behavior;
+}
+
 } // namespace iimodmanager
 
 #endif // IIMODMANAGER_UPDATEMODSIMPL_H
@@ -15,6 +15,7 @@
 #include <modinfo.h>
 #include <modlist.h>
 #include <modspec.h>
+#include <modsyncplan.h>
 
 namespace iimodmanager {
 
@@ -61,6 +62,21 @@ static QString containsNewAliases(const ModCache &cache, const QList<SpecMod> &t
     return aliasChanges.join('\n');
 }
 
+static QString describeChanges(const ModCache &cache, const ModList &modList, const QList<SpecMod> &toAddMods, const QList<SpecMod> &toUpdateMods, const QList<InstalledMod> &toRemoveMods)
+{
+    QStringList lines;
+    for (const auto &im : toRemoveMods)
+        lines << QStringLiteral("Remove\t%1").arg(util::displayInfo(im.info(), im.alias()));
+    for (const auto &sm : toAddMods)
+        lines << QStringLiteral("Install\t%1 \t%2").arg(util::displayInfo(sm), util::displayVersion(sm.versionName()));
+    for (const auto &sm : toUpdateMods)
+        lines << QStringLiteral("Update\t%1 \t%2").arg(util::displayInfo(sm), util::displayVersion(sm.versionName()));
+
+    const SyncCost cost = SyncCost::estimate(cache, modList, toAddMods, toUpdateMods, toRemoveMods);
+    lines << QString() << QStringLiteral("Estimated cost: %1").arg(cost.toString());
+    return lines.join('\n');
+}
+
 static void updateDefaultAliases(ModCache &cache, const QList<SpecMod> &toAddMods)
 {
     for (const auto &sm : toAddMods)
@@ -90,7 +106,24 @@ void ApplyPreviewCommand::execute()
 
     preview->prepareChanges(&toAddMods, &toUpdateMods, &toRemoveMods);
     // TODO: Warn if about to delete uncached mod versions.
-    // TODO: Confirmation dialog with list of changes.
+
+    DetailedDialog *prompt = new DetailedDialog(
+            tr("Apply the following changes?"),
+            describeChanges(app.cache(), app.modList(), toAddMods, toUpdateMods, toRemoveMods),
+            static_cast<QWidget*>(parent()));
+    connect(prompt, &QDialog::finished, this, &ApplyPreviewCommand::confirmFinished);
+    prompt->show();
+}
+
+void ApplyPreviewCommand::confirmFinished(int result)
+{
+    if (result != QDialog::Accepted)
+    {
+        emit textOutput("Sync cancelled");
+        emit finished();
+        deleteLater();
+        return;
+    }
 
     const QString aliasChanges = containsNewAliases(app.cache(), toAddMods);
     if (aliasChanges.isEmpty())
@@ -130,6 +163,8 @@ void ApplyPreviewCommand::applyChanges()
     else
         emit textOutput("Sync aborted");
 
+    // Persist measured sizes and throughput before the refresh reloads metadata.
+    app.cache().saveMetadata();
     app.refreshMods();
 
     // Wait for any refresh callbacks to propagate.
@@ -34,6 +34,7 @@ private:
     QList<InstalledMod> toRemoveMods;
 
     void finish();
+    void confirmFinished(int result);
     void dialogFinished(int result);
     void applyChanges();
     bool doApply();
@@ -139,33 +139,29 @@ void CacheAddCommand::filterNewWorkshopIds(QStringList modIds)
 
 void CacheAddCommand::startInfos()
 {
-    steamInfoCall = app.modDownloader().modInfoCall();
+    steamInfoCall = app.modDownloader().modInfoBatchCall();
     steamInfoCall->setParent(this);
-    connect(steamInfoCall, &ModInfoCall::finished, this, &CacheAddCommand::steamInfoFinished);
+    connect(steamInfoCall, &ModInfoBatchCall::progress, this, &CacheAddCommand::updateProgress);
+    connect(steamInfoCall, &ModInfoBatchCall::finished, this, &CacheAddCommand::steamInfosFinished);
 
     steamInfos.clear();
     steamInfos.reserve(workshopIds.size());
     emit beginProgress(workshopIds.size());
 
-    loopIndex = 0;
-    steamInfoCall->start(workshopIds.first());
+    steamInfoCall->start(workshopIds);
 }
 
-void CacheAddCommand::nextSteamInfo()
+void CacheAddCommand::steamInfosFinished()
 {
-    if (++loopIndex < workshopIds.size())
-    {
-        // Next steamInfo
-        emit updateProgress(loopIndex);
-        steamInfoCall->start(workshopIds.at(loopIndex));
-    }
-    else if (steamInfos.empty())
+    for (qsizetype i = 0; i < steamInfoCall->size(); ++i)
+        steamInfoFinished(i);
+
+    if (steamInfos.empty())
     {
         // No downloads needed.
         steamInfoCall->deleteLater();
         steamInfoCall = nullptr;
 
-        emit updateProgress(loopIndex);
         emit textOutput("No downloadable mods.");
         emit finished();
         deleteLater();
@@ -182,13 +178,12 @@ void CacheAddCommand::nextSteamInfo()
     }
 }
 
-void CacheAddCommand::steamInfoFinished()
+void CacheAddCommand::steamInfoFinished(qsizetype index)
 {
-    const SteamModInfo &steamInfo = steamInfoCall->result();
+    const SteamModInfo &steamInfo = steamInfoCall->result(index);
     if (!steamInfo.valid())
     {
-        emit textOutput(QString("  Skipping workshop-%1: %2").arg(steamInfoCall->workshopId(), steamInfoCall->errorDetail()));
-        nextSteamInfo();
+        emit textOutput(QString("  Skipping workshop-%1: %2").arg(steamInfoCall->workshopId(index), steamInfoCall->errorDetail(index)));
         return;
     }
 
@@ -202,7 +197,6 @@ void CacheAddCommand::steamInfoFinished()
     {
         steamInfos.append(steamInfo);
     }
-    nextSteamInfo();
 }
 
 void CacheAddCommand::startDownloads()
@@ -7,7 +7,7 @@
 namespace iimodmanager {
 
 class ModDownloadCall;
-class ModInfoCall;
+class ModInfoBatchCall;
 class ModManGuiApplication;
 struct SteamModInfo;
 
@@ -28,23 +28,22 @@ signals:
     void updateProgress(int value);
 
 private slots:
-    void steamInfoFinished();
+    void steamInfosFinished();
     void modDownloadFinished();
 
 private:
     ModManGuiApplication &app;
 
-    ModInfoCall *steamInfoCall;
+    ModInfoBatchCall *steamInfoCall;
     QStringList workshopIds;
     QList<SteamModInfo> steamInfos;
-    qsizetype loopIndex;
 
     QString parseIds(QString input, QStringList *modIds, bool *ok = nullptr, QStringList *failedIds = nullptr);
     void filterNewWorkshopIds(QStringList modIds);
 
     void startInfos();
-    void nextSteamInfo();
     void startDownloads();
+    void steamInfoFinished(qsizetype index);
 };
 
 } // namespace iimodmanager
@@ -81,7 +81,7 @@ void CacheImportInstalledCommand::execute()
 {
     app.refreshMods();
 
-    model = new CacheImportModel(app.cache(), app.modList(), app.modDownloader().modInfoCall(), this);
+    model = new CacheImportModel(app.cache(), app.modList(), app.modDownloader().modInfoBatchCall(), this);
     connect(model, &CacheImportModel::textOutput, this, &CacheImportInstalledCommand::textOutput);
     CacheImportDialog *dialog = new CacheImportDialog(model, static_cast<QWidget*>(parent()));
     connect(dialog, &QDialog::finished, this, &CacheImportInstalledCommand::dialogFinished);
@@ -47,11 +47,11 @@ namespace ColumnData {
 }
 
 
-CacheImportModel::CacheImportModel(const ModCache &cache, const ModList &modList, ModInfoCall *steamInfoCall, QObject *parent)
+CacheImportModel::CacheImportModel(const ModCache &cache, const ModList &modList, ModInfoBatchCall *steamInfoCall, QObject *parent)
     : ModsModel(cache, modList, parent), steamInfoCall(steamInfoCall), steamInfoIdle(true), previousEmptyState_(true)
 {
     steamInfoCall->setParent(this);
-    connect(steamInfoCall, &ModInfoCall::finished, this, &CacheImportModel::steamInfoFinished);
+    connect(steamInfoCall, &ModInfoBatchCall::finished, this, &CacheImportModel::steamInfosFinished);
 
     // Load pending imports.
     int total = rowCount(QModelIndex());
@@ -439,50 +439,65 @@ void CacheImportModel::reportImportChanged(int row, bool modifiedByView)
     }
 }
 
-void CacheImportModel::steamInfoFinished()
+void CacheImportModel::steamInfosFinished()
 {
-    const SteamModInfo &steamInfo = steamInfoCall->result();
-    const QString modId = util::fromSteamId(steamInfoCall->workshopId());
+    QList<int> rows;
+    for (qsizetype i = 0; i < steamInfoCall->size(); ++i)
+    {
+        int row = steamInfoFinished(i);
+        if (row != -1)
+            rows.append(row);
+    }
+
+    steamInfoIdle = true;
+    nextInfo();
+
+    for (int row : rows)
+        reportImportChanged(row);
+}
+
+int CacheImportModel::steamInfoFinished(qsizetype index)
+{
+    const SteamModInfo &steamInfo = steamInfoCall->result(index);
+    const QString &workshopId = steamInfoCall->workshopId(index);
+    const QString modId = util::fromSteamId(workshopId);
     if (!steamInfo.valid())
     {
-        emit textOutput(QStringLiteral("  Skipping %1: %2").arg(modId, steamInfoCall->errorDetail()));
-        infoResults[steamInfoCall->workshopId()] = SteamModInfo();
+        emit textOutput(QStringLiteral("  Skipping %1: %2").arg(modId, steamInfoCall->errorDetail(index)));
+        infoResults[workshopId] = SteamModInfo();
     }
     else
     {
         infoResults[steamInfo.id] = steamInfo;
     }
 
-    int row = -1;
     for (auto &pi : pendingImports)
         if (pi.modId == modId)
         {
-            row = rowOf(pi.installedId);
             const CachedMod *cm = cache.mod(modId);
             pi.updateStatus(cm, &steamInfo);
             if (pi.status == PendingImport::DOWNLOAD_AVAILABLE)
                 pi.status = PendingImport::IMPORT_DOWNLOAD;
-            break;
+            return rowOf(pi.installedId);
         }
-
-    steamInfoIdle = true;
-    nextInfo();
-
-    if (row != -1)
-        reportImportChanged(row);
+    return -1;
 }
 
 void CacheImportModel::nextInfo()
 {
     if (!steamInfoIdle)
         return;
+
+    // Look up every pending mod at once. Mods that become pending during the lookup are collected by the next call.
+    QStringList steamIds;
     for (const auto &pi : pendingImports)
-        if (pi.status == PendingImport::PENDING)
-        {
-            steamInfoIdle = false;
-            steamInfoCall->start(pi.steamId);
-            return;
-        }
+        if (pi.status == PendingImport::PENDING && !steamIds.contains(pi.steamId))
+            steamIds.append(pi.steamId);
+    if (!steamIds.isEmpty())
+    {
+        steamInfoIdle = false;
+        steamInfoCall->start(steamIds);
+    }
 }
 
 
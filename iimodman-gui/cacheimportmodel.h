@@ -76,7 +76,7 @@ public:
         bool deactivate();
     };
 
-    CacheImportModel(const ModCache &cache, const ModList &modList, ModInfoCall *steamInfoCall, QObject *parent);
+    CacheImportModel(const ModCache &cache, const ModList &modList, ModInfoBatchCall *steamInfoCall, QObject *parent);
 
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
@@ -99,14 +99,14 @@ protected:
     int idColumn() const override;
 
 private slots:
-    void steamInfoFinished();
+    void steamInfosFinished();
 
 private:
     //! Pending imports, by installed mod ID.
     QHash<QString, PendingImport> pendingImports;
     //! Steam mod info results, by steam workshop ID.
     QHash<QString, SteamModInfo> infoResults;
-    ModInfoCall *steamInfoCall;
+    ModInfoBatchCall *steamInfoCall;
     bool steamInfoIdle;
 
     // Used to report ::isEmptyChanged.
@@ -122,6 +122,9 @@ private:
     //! If a pending action is not present, a default is inserted and provided for editing.
     PendingImport *seekMutablePendingRow(int row, const InstalledMod **imOut);
 
+    //! Applies a single lookup result. Returns the updated row, or -1 if none.
+    int steamInfoFinished(qsizetype index);
+    //! Starts looking up all pending mods, unless a lookup is already in progress.
     void nextInfo();
 
     //! Report that the visible model has changed.
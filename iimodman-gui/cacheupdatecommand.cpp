@@ -51,33 +51,29 @@ void CacheUpdateCommand::execute()
 
 void CacheUpdateCommand::startInfos()
 {
-    steamInfoCall = app.modDownloader().modInfoCall();
+    steamInfoCall = app.modDownloader().modInfoBatchCall();
     steamInfoCall->setParent(this);
-    connect(steamInfoCall, &ModInfoCall::finished, this, &CacheUpdateCommand::steamInfoFinished);
+    connect(steamInfoCall, &ModInfoBatchCall::progress, this, &CacheUpdateCommand::updateProgress);
+    connect(steamInfoCall, &ModInfoBatchCall::finished, this, &CacheUpdateCommand::steamInfosFinished);
 
     steamInfos.clear();
     steamInfos.reserve(workshopIds.size());
     emit beginProgress(workshopIds.size());
 
-    loopIndex = 0;
-    steamInfoCall->start(workshopIds.first());
+    steamInfoCall->start(workshopIds);
 }
 
-void CacheUpdateCommand::nextSteamInfo()
+void CacheUpdateCommand::steamInfosFinished()
 {
-    if (++loopIndex < workshopIds.size())
-    {
-        // Next steamInfo
-        emit updateProgress(loopIndex);
-        steamInfoCall->start(workshopIds.at(loopIndex));
-    }
-    else if (steamInfos.empty())
+    for (qsizetype i = 0; i < steamInfoCall->size(); ++i)
+        steamInfoFinished(i);
+
+    if (steamInfos.empty())
     {
         // No downloads needed.
         steamInfoCall->deleteLater();
         steamInfoCall = nullptr;
 
-        emit updateProgress(loopIndex);
         emit textOutput("All workshop mods are up to date.");
         emit finished();
         deleteLater();
@@ -97,13 +93,12 @@ void CacheUpdateCommand::nextSteamInfo()
     }
 }
 
-void CacheUpdateCommand::steamInfoFinished()
+void CacheUpdateCommand::steamInfoFinished(qsizetype index)
 {
-    const SteamModInfo &steamInfo = steamInfoCall->result();
+    const SteamModInfo &steamInfo = steamInfoCall->result(index);
     if (!steamInfo.valid())
     {
-        emit textOutput(QString("  Skipping workshop-%1: %2").arg(steamInfoCall->workshopId(), steamInfoCall->errorDetail()));
-        nextSteamInfo();
+        emit textOutput(QString("  Skipping workshop-%1: %2").arg(steamInfoCall->workshopId(index), steamInfoCall->errorDetail(index)));
         return;
     }
 
@@ -118,7 +113,6 @@ void CacheUpdateCommand::steamInfoFinished()
         app.cache().markAvailableVersion(modId, steamInfo.lastUpdated);
         steamInfos.append(steamInfo);
     }
-    nextSteamInfo();
 }
 
 void CacheUpdateCommand::startDownloads()
@@ -6,7 +6,7 @@
 
 namespace iimodmanager {
 
-class ModInfoCall;
+class ModInfoBatchCall;
 class ModManGuiApplication;
 struct SteamModInfo;
 
@@ -28,21 +28,20 @@ signals:
     void updateProgress(int value);
 
 private slots:
-    void steamInfoFinished();
+    void steamInfosFinished();
     void modDownloadFinished();
 
 private:
     void startInfos();
-    void nextSteamInfo();
     void startDownloads();
+    void steamInfoFinished(qsizetype index);
 
     ModManGuiApplication &app;
 
-    ModInfoCall *steamInfoCall;
+    ModInfoBatchCall *steamInfoCall;
     bool onlyAlreadyPending;
     QStringList workshopIds;
     QList<SteamModInfo> steamInfos;
-    qsizetype loopIndex;
 };
 
 } // namespace iimodmanager
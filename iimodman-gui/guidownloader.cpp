@@ -8,50 +8,89 @@
 namespace iimodmanager {
 
 GuiModDownloader::GuiModDownloader(ModManGuiApplication &app, const QList<SteamModInfo> &steamInfos, QObject *parent)
-    : QObject(parent), steamInfos(steamInfos), loopIndex(0)
+    : QObject(parent), steamInfos(steamInfos), downloader(app.modDownloader()), started(false), byteProgress(false)
 {
-    steamDownloadCall = app.modDownloader().modDownloadCall(app.cache());
-    steamDownloadCall->setParent(this);
-    connect(steamDownloadCall, &ModDownloadCall::finished, this, &GuiModDownloader::steamDownloadFinished);
+    downloadQueue = downloader.downloadQueue(app.cache());
+    downloadQueue->setParent(this);
+    connect(downloadQueue, &ModDownloadQueue::downloadProgress, this, &GuiModDownloader::steamDownloadProgress);
+    connect(downloadQueue, &ModDownloadQueue::downloadFinished, this, &GuiModDownloader::steamDownloadFinished);
+    connect(downloadQueue, &ModDownloadQueue::finished, this, &GuiModDownloader::queueFinished);
 }
 
 void GuiModDownloader::execute()
 {
-    if (loopIndex != 0)
+    if (started)
         return;
 
-    steamDownloadCall->start(steamInfos.first());
+    started = true;
+    startStats = downloader.requestStats();
+
+    qint64 totalBytes = 0;
+    byteProgress = !steamInfos.isEmpty();
+    for (const SteamModInfo &info : steamInfos)
+    {
+        byteProgress = byteProgress && info.fileSize >= 0;
+        totalBytes += info.fileSize;
+    }
+    if (byteProgress)
+    {
+        receivedBytes = QVector<qint64>(steamInfos.size(), 0);
+        emit beginProgress(static_cast<int>(totalBytes / 1024));
+    }
+
+    downloadQueue->start(steamInfos);
 }
 
-void GuiModDownloader::steamDownloadFinished()
+void GuiModDownloader::steamDownloadProgress(int index, qint64 received, qint64 total)
 {
-    const CachedVersion *v = steamDownloadCall->resultVersion();
+    Q_UNUSED(total);
+    if (!byteProgress)
+        return;
+
+    receivedBytes[index] = qMin(received, steamInfos.at(index).fileSize);
+    updateByteProgress();
+}
+
+void GuiModDownloader::updateByteProgress()
+{
+    qint64 sum = 0;
+    for (qint64 bytes : qAsConst(receivedBytes))
+        sum += bytes;
+    emit updateProgress(static_cast<int>(sum / 1024));
+}
+
+void GuiModDownloader::steamDownloadFinished(int index)
+{
+    const CachedVersion *v = downloadQueue->resultVersion(index);
     if (v)
     {
         emit textOutput(QString("  %1 downloaded.").arg(v->info().toString()));
     }
     else
     {
-        emit textOutput(QString("  %1 download failed: %2").arg(steamDownloadCall->steamInfo().modId(), steamDownloadCall->errorDetail()));
+        emit textOutput(QString("  %1 download failed: %2").arg(downloadQueue->steamInfo(index).modId(), downloadQueue->errorDetail(index)));
     }
 
-    // Next.
-    if (++loopIndex < steamInfos.size())
+    if (byteProgress)
     {
-        // Next download.
-        emit updateProgress(loopIndex);
-        steamDownloadCall->start(steamInfos.at(loopIndex));
+        // Count failures as done too, so that the bar still fills once everything is finished.
+        receivedBytes[index] = steamInfos.at(index).fileSize;
+        updateByteProgress();
     }
     else
-    {
-        // Finished.
-        steamDownloadCall->deleteLater();
-        steamDownloadCall = nullptr;
+        emit updateProgress(index + 1);
+}
 
-        emit updateProgress(loopIndex);
-        emit finished();
-        deleteLater();
-    }
+void GuiModDownloader::queueFinished()
+{
+    const RequestScheduler::Stats stats = downloader.requestStats() - startStats;
+    if (stats.retries > 0 || stats.timeouts > 0)
+        emit textOutput(QString("  Network: %1").arg(stats.toString()));
+    if (!steamInfos.isEmpty())
+        emit textOutput(QString("  Transfers: %1").arg(downloadQueue->summary().toString()));
+
+    emit finished();
+    deleteLater();
 }
 
 } // namespace iimodmanager
@@ -2,11 +2,12 @@
 #define GUIDOWNLOADER_H
 
 #include <QObject>
+#include <QVector>
 #include <moddownloader.h>
 
 namespace iimodmanager {
 
-class ModDownloadCall;
+class ModDownloadQueue;
 class ModManGuiApplication;
 struct SteamModInfo;
 
@@ -27,13 +28,23 @@ signals:
     void updateProgress(int value);
 
 private slots:
-    void steamDownloadFinished();
+    void steamDownloadProgress(int index, qint64 received, qint64 total);
+    void steamDownloadFinished(int index);
+    void queueFinished();
 
 private:
     const QList<SteamModInfo> steamInfos;
 
-    ModDownloadCall *steamDownloadCall;
-    qsizetype loopIndex;
+    ModDownloader &downloader;
+    ModDownloadQueue *downloadQueue;
+    bool started;
+    //! Request totals before the downloads started, to report only their retries.
+    RequestScheduler::Stats startStats;
+    //! Set if progress is shown in KiB, when Steam listed every zip's size. Otherwise it's shown in mods.
+    bool byteProgress;
+    QVector<qint64> receivedBytes;
+
+    void updateByteProgress();
 };
 
 } // namespace iimodmanager
@@ -153,101 +153,30 @@ namespace ColumnData {
     }
 }
 
-static std::optional<ModSpecPreviewModel::PendingChange> pinCurrent(const InstalledMod *im, const ModSpecPreviewModel::PendingChange *previous, const QString &requestedAlias = QString())
+bool ModSpecPreviewModel::checkPlannedChange(const ModChange &change) const
 {
-    using PendingChange = ModSpecPreviewModel::PendingChange;
-
-    if (!im)
-        return std::nullopt;
-
-    PendingChange pc(im->id());
-    pc.modName = im->info().name();
-    pc.alias = previous ? previous->alias : im->alias();
-    const CachedVersion *iv = im->cacheVersion();
-    if (iv)
-        pc.versionId = iv->id();
-    else
-        pc.versionId.clear();
-    pc.versionPin = PendingChange::CURRENT;
-    pc.type = pc.alias == im->alias() ? PendingChange::PIN_CURRENT : PendingChange::RE_ALIAS;
-    return pc;
-}
-
-static std::optional<ModSpecPreviewModel::PendingChange> useLatest(const CachedMod *cm, const InstalledMod *im, const ModSpecPreviewModel::PendingChange *previous)
-{
-    using PendingChange = ModSpecPreviewModel::PendingChange;
-
-    const CachedVersion *lv = cm ? cm->latestVersion() : nullptr;
-    if (!lv || !cm)
-        return pinCurrent(im, previous);
-
-    PendingChange pc(cm->id());
-    pc.modName = cm->info().name();
-    pc.alias = previous ? previous->alias : im ? im->alias() : cm->defaultAlias();
-    pc.versionId = lv->id();
-    pc.versionPin = PendingChange::LATEST;
-    if (!im)
-        pc.type = PendingChange::INSTALL;
-    else if (pc.alias != im->alias())
-        pc.type = PendingChange::RE_ALIAS;
-    else if (lv == cm->installedVersion())
-        pc.type = PendingChange::PIN_LATEST;
-    else
-        pc.type = PendingChange::UPDATE;
-    return pc;
-}
-
-std::optional<ModSpecPreviewModel::PendingChange> ModSpecPreviewModel::toPendingChange(const SpecMod &sm) const
-{
-    if (sm.id().isEmpty())
-        return std::nullopt;
-
-    const CachedMod *cm = cache.mod(sm.id());
-    const InstalledMod *im = modList.mod(sm.id());
-    if (!cm && !im)
+    if (change.hasIssue(ModChange::NOT_FOUND))
     {
         emit textOutput(QStringLiteral("! Skipping %2 [%1]: Not in cache or installed.")
-                .arg(sm.id(), sm.name()));
-        return std::nullopt;
-    }
-
-    PendingChange base(sm.id());
-    base.alias = sm.alias();
-
-    if (sm.versionId().isEmpty())
-        return useLatest(cm, im, &base);
-    if (sm.versionId() == '-')
-    {
-        // Keep current, if possible.
-        if (im)
-            return pinCurrent(im, &base);
-        else
-            return useLatest(cm, im, &base);
+                .arg(change.modId, change.modName));
+        return false;
     }
-    // A specific version ID was requested.
-
-    const CachedVersion *tv = cm ? cm->version(sm.versionId()) : nullptr;
-    if (!tv || !cm)
-    {
+    if (change.hasIssue(ModChange::LOCK_MISMATCH) && change.versionPin == ModChange::CURRENT)
+        emit textOutput(QStringLiteral("! Keeping installed files for %2 [%1]: Neither they nor any cached version match the lock.")
+                .arg(change.modId, change.modName));
+    else if (change.hasIssue(ModChange::LOCK_MISMATCH) && (change.requestedVersionId.isEmpty() || change.requestedVersionId == '-'))
+        emit textOutput(QStringLiteral("! Installing latest for %2 [%1]: No cached version matches the lock.")
+                .arg(change.modId, change.modName));
+    else if (change.hasIssue(ModChange::LOCK_MISMATCH))
+        emit textOutput(QStringLiteral("! Replacing locked version (%3) with latest for %2 [%1]: Cached files don't match the lock.")
+                .arg(change.modId, change.modName, change.requestedVersionId));
+    if (change.hasIssue(ModChange::VERSION_NOT_CACHED))
         emit textOutput(QStringLiteral("! Replacing requested version (%3) with latest for %2 [%1]: Not in cache.")
-                .arg(sm.id(), sm.name(), sm.versionId()));
-        return useLatest(cm, im, &base);
-    }
-
-    PendingChange pc(cm->id());
-    pc.modName = cm->info().name();
-    pc.alias = sm.alias();
-    pc.versionId = tv->id();
-    pc.versionPin = PendingChange::PINNED;
-    if (!im)
-        pc.type = PendingChange::INSTALL;
-    else if (pc.alias != im->alias())
-        pc.type = PendingChange::RE_ALIAS;
-    else if (tv == cm->installedVersion())
-        pc.type = PendingChange::PIN_CURRENT;
-    else
-        pc.type = PendingChange::UPDATE;
-    return pc;
+                .arg(change.modId, change.modName, change.requestedVersionId));
+    // Neither downloaded nor installed, so there's nothing to show.
+    if (change.hasIssue(ModChange::NOT_DOWNLOADED) && change.isNone())
+        return false;
+    return true;
 }
 
 ModSpecPreviewModel::ModSpecPreviewModel(const ModCache &cache, const ModList &modList, QObject *parent)
@@ -711,19 +640,14 @@ void ModSpecPreviewModel::setModSpec(const QList<SpecMod> &specMods)
 {
     pendingChanges.clear();
 
-    // Create a pending change for each mod.
-    for (const auto &sm : specMods)
-        if (auto pc = toPendingChange(sm))
-            pendingChanges.insert(pc->modId, *pc);
-
-    // Mark removal of each installed mod that's not in the spec.
-    for (const auto &im : modList.mods())
-        if (!pendingChanges.contains(im.id()))
-        {
-            PendingChange &pc = *pendingChanges.insert(im.id(), PendingChange(im.id()));
-            pc.modName = im.info().name();
-            pc.type = PendingChange::REMOVE;
-        }
+    if (mutableCache)
+        ModSyncPlan::refreshPinnedVersions(*mutableCache, specMods);
+    // Includes removal of each installed mod that's not in the spec.
+    const ModSyncPlan plan = ModSyncPlan::build(cache, modList, specMods, ModSyncPlan::SYNC);
+    pendingChanges.reserve(plan.changes.size());
+    for (const ModChange &change : plan.changes)
+        if (checkPlannedChange(change))
+            pendingChanges.insert(change.modId, PendingChange(change));
 
     setDirty();
     reportSpecChanged();
@@ -731,12 +655,14 @@ void ModSpecPreviewModel::setModSpec(const QList<SpecMod> &specMods)
 
 void ModSpecPreviewModel::insertModSpec(const QList<SpecMod> &specMods)
 {
-    // Create a pending change for each mod.
-    for (const auto &sm : specMods)
-        if (auto pc = toPendingChange(sm))
-            pendingChanges.insert(pc->modId, *pc);
+    if (mutableCache)
+        ModSyncPlan::refreshPinnedVersions(*mutableCache, specMods);
+    const ModSyncPlan plan = ModSyncPlan::build(cache, modList, specMods, ModSyncPlan::PARTIAL);
+    for (const ModChange &change : plan.changes)
+        if (checkPlannedChange(change))
+            pendingChanges.insert(change.modId, PendingChange(change));
         else
-            pendingChanges.remove(sm.id());
+            pendingChanges.remove(change.modId);
 
     setDirty();
     reportSpecChanged();
@@ -845,42 +771,10 @@ void ModSpecPreviewModel::prepareChanges(QList<SpecMod> *toAddMods, QList<SpecMo
     toUpdateMods->reserve(pendingChanges.size());
     toRemoveMods->reserve(pendingChanges.size());
 
+    QString errorInfo;
     for (const auto &pc : pendingChanges)
-        switch (pc.type)
-        {
-        case PendingChange::RE_ALIAS:
-        case PendingChange::INSTALL:
-            {
-                const auto *cm = cache.mod(pc.modId);
-                const auto *cv = cm ? cm->version(pc.versionId) : nullptr;
-                if (cv)
-                    *toAddMods << cv->asSpec().withAlias(pc.alias);
-                else
-                    emit textOutput(QStringLiteral("! Cannot install %1 '%2': Not in cache.").arg(pc.modId, pc.versionId));
-            }
-            break;
-        case PendingChange::UPDATE:
-            {
-                const auto *cm = cache.mod(pc.modId);
-                const auto *cv = cm ? cm->version(pc.versionId) : nullptr;
-                if (cv)
-                    *toUpdateMods << cv->asSpec().withAlias(pc.alias);
-                else
-                    emit textOutput(QStringLiteral("! Cannot update %1 to '%2': Not in cache.").arg(pc.modId, pc.versionId));
-            }
-            break;
-        case PendingChange::REMOVE:
-            {
-                const auto *im = modList.mod(pc.modId);
-                if (im)
-                    *toRemoveMods << *im;
-                else
-                    emit textOutput(QStringLiteral("! Cannot remove %1: No longer installed.").arg(pc.modId, pc.versionId));
-            }
-            break;
-        default:
-            break;
-        }
+        if (!pc.collect(cache, modList, toAddMods, toUpdateMods, toRemoveMods, &errorInfo))
+            emit textOutput(QStringLiteral("! %1").arg(errorInfo));
 }
 
 void ModSpecPreviewModel::revert()
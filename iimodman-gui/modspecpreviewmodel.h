@@ -6,6 +6,7 @@
 #include <QAbstractItemModel>
 #include <optional>
 #include <modspec.h>
+#include <modsyncplan.h>
 
 namespace iimodmanager {
 
@@ -43,55 +44,15 @@ public:
         COLUMN_COUNT = COLUMN_MAX+1,
     };
 
-    struct PendingChange
+    //! A planned change, as edited in the preview.
+    struct PendingChange : public ModChange
     {
-        enum ChangeType {
-            //! No change. An uninstalled mod remains so. An installed mod remains installed.
-            //! The latter case may be further specified with PIN_CURRENT or PIN_LATEST to modify how this change reacts to cache changes.
-            NONE,
-            //! Like NONE, but specifically pinning the current installed version.
-            PIN_CURRENT,
-            //! Like NONE, but specifically pinning the latest available version.
-            //! Must have LATEST pin type.
-            PIN_LATEST,
-            INSTALL,
-            REMOVE,
-            //! Remove the currently installed mod, and re-install it with a different alias.
-            //! The installed version may change.
-            RE_ALIAS,
-            //! Install a different version of the mod (not necessarily newer).
-            //! The mod will be installed under the same alias/ID as the current installation.
-            UPDATE,
-
-            ACTIVE_CHANGE_MIN = INSTALL,
-        };
-        //! How this change specifies a version.
-        //! Controls how this pending change is affected by cache/installed updates.
-        enum VersionPinning {
-            //! Currently installed version.
-            CURRENT,
-            //! Latest available version.
-            LATEST,
-            //! Specific version.
-            PINNED,
-        };
-
-        QString modId;
-        QString modName;
-        QString alias;
-        QString versionId;
-        VersionPinning versionPin;
-        ChangeType type;
-
         bool hasDupe;
 
         PendingChange(const QString &modId = QString())
-            : modId(modId), versionPin(CURRENT), type(NONE), hasDupe(false) {};
-
-        inline bool isValid() const { return !modId.isNull(); };
-        inline bool isNone() const { return type == NONE; };
-        inline bool isActive() const { return type >= ACTIVE_CHANGE_MIN; }
-        inline bool isUncachedMove() const { return type == RE_ALIAS && versionId.isEmpty(); }
+            : ModChange(modId), hasDupe(false) {};
+        PendingChange(const ModChange &change)
+            : ModChange(change), hasDupe(false) {};
     };
 
     ModSpecPreviewModel(const ModCache &cache, const ModList &modList, QObject *parent);
@@ -175,7 +136,9 @@ private:
     //! Pass the updated mod ID for a single mod; leave blank for all mods.
     void reportSpecChanged(int row = -1, bool modifiedByView = false);
 
-    std::optional<PendingChange> toPendingChange(const SpecMod &specMod) const;
+    //! Reports any part of the planned change that couldn't be followed.
+    //! Returns false if the mod should be skipped.
+    bool checkPlannedChange(const ModChange &change) const;
     void generateModSpec() const;
     void checkDuplicates();
     void refreshPendingChange(PendingChange &pc);
@@ -1,24 +1,130 @@
 #include "fileutils.h"
+#include "tracing.h"
 
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QRegularExpression>
 #include <QString>
+#include <QTemporaryDir>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace iimodmanager {
 
 Q_DECLARE_LOGGING_CATEGORY(fileutils)
 Q_LOGGING_CATEGORY(fileutils, "files", QtWarningMsg);
 
-bool FileUtils::removeModDir(const QString &path, QString *errorInfo)
+const QString FileUtils::trashDirName = QStringLiteral(".iimodman-trash");
+const QString FileUtils::stagingDirName = QStringLiteral(".iimodman-staging");
+const QString FileUtils::partialDirName = QStringLiteral(".iimodman-partial");
+
+struct ReaperState
+{
+    QMutex mutex;
+    //! Trash directories with a running reaper. The value is set if more folders were trashed after the reaper started.
+    QHash<QString, bool> active;
+};
+
+static ReaperState &reaperState()
+{
+    // Intentionally leaked, as a reaper may still be running during static destruction.
+    static ReaperState *state = new ReaperState;
+    return *state;
+}
+
+static void startReaper(const QString &trashPath)
+{
+    ReaperState &state = reaperState();
+    {
+        QMutexLocker locker(&state.mutex);
+        auto it = state.active.find(trashPath);
+        if (it != state.active.end())
+        {
+            *it = true;
+            return;
+        }
+        state.active.insert(trashPath, false);
+    }
+
+    QThread *thread = QThread::create([trashPath, &state] {
+        bool again = true;
+        while (again)
+        {
+            QDir trashDir(trashPath);
+            for (const QString &entry : trashDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden))
+            {
+                // Anything left is reclaimed by the next startup.
+                if (QCoreApplication::closingDown())
+                    break;
+                qCDebug(fileutils).noquote() << "Reaping" << trashDir.filePath(entry);
+                if (!QDir(trashDir.filePath(entry)).removeRecursively())
+                    qCWarning(fileutils).noquote() << "Failed to delete trashed folder" << trashDir.filePath(entry);
+            }
+
+            QMutexLocker locker(&state.mutex);
+            again = state.active.value(trashPath) && !QCoreApplication::closingDown();
+            if (again)
+                state.active[trashPath] = false;
+            else
+            {
+                state.active.remove(trashPath);
+                // Only succeeds if nothing new has been trashed.
+                QDir().rmdir(trashPath);
+            }
+        }
+    });
+    QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    // On Linux, idle priority also moves the thread to the idle scheduling class.
+    thread->start(QThread::IdlePriority);
+}
+
+static bool moveToTrash(const QString &path, const QString &trashRoot)
+{
+    const QDir dir(path);
+    const QString trashPath = QDir(trashRoot.isEmpty() ? QFileInfo(dir.absolutePath()).absolutePath() : trashRoot).absoluteFilePath(FileUtils::trashDirName);
+    if (!QDir().mkpath(trashPath))
+        return false;
+
+    // Nest each trashed folder in a unique directory, so that repeated names don't collide.
+    QTemporaryDir entryDir(QDir(trashPath).filePath(QStringLiteral("XXXXXX")));
+    if (!entryDir.isValid())
+        return false;
+    entryDir.setAutoRemove(false);
+
+    const QString trashedPath = QDir(entryDir.path()).filePath(dir.dirName());
+    if (!QDir().rename(dir.absolutePath(), trashedPath))
+    {
+        QDir().rmdir(entryDir.path());
+        return false;
+    }
+
+    qCDebug(fileutils).noquote() << "Moved" << path << "to" << trashedPath;
+    startReaper(trashPath);
+    return true;
+}
+
+bool FileUtils::removeModDir(const QString &path, QString *errorInfo, RemoveMode mode, const QString &trashRoot)
 {
     QDir dir(path);
     if (dir.exists() && !dir.isEmpty())
     {
         if (dir.exists("modinfo.txt"))
         {
+            if (mode == REMOVE_DEFERRED && moveToTrash(path, trashRoot))
+                return true;
+
             qCDebug(fileutils).noquote() << "Deleting existing" << path;
             dir.removeRecursively();
         }
@@ -34,6 +140,99 @@ bool FileUtils::removeModDir(const QString &path, QString *errorInfo)
     return true;
 }
 
+void FileUtils::reapTrash(const QString &trashRoot)
+{
+    if (trashRoot.isEmpty())
+        return;
+
+    // Staging folders are in use while a download is extracted, possibly by another process.
+    // Only those untouched for a day are considered abandoned.
+    const QDir stagingDir(QDir(trashRoot).absoluteFilePath(stagingDirName));
+    const QDateTime abandonedTime = QDateTime::currentDateTimeUtc().addDays(-1);
+    for (const QFileInfo &entry : stagingDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden))
+        if (entry.lastModified().toUTC() < abandonedTime)
+            discardStagingDir(entry.absoluteFilePath(), trashRoot);
+
+    const QString trashPath = QDir(trashRoot).absoluteFilePath(trashDirName);
+    if (QFileInfo(trashPath).isDir())
+        startReaper(trashPath);
+}
+
+QString FileUtils::createStagingDir(const QString &root, QString *errorInfo)
+{
+    const QString stagingPath = QDir(root).absoluteFilePath(stagingDirName);
+    QTemporaryDir entryDir(QDir(stagingPath).filePath(QStringLiteral("XXXXXX")));
+    if (!QDir().mkpath(stagingPath) || !entryDir.isValid())
+    {
+        QString msg = QStringLiteral("Failed to create staging folder in %1").arg(stagingPath);
+        qCCritical(fileutils).noquote() << msg;
+        if (errorInfo)
+            *errorInfo = msg;
+        return QString();
+    }
+    entryDir.setAutoRemove(false);
+    return entryDir.path();
+}
+
+void FileUtils::discardStagingDir(const QString &path, const QString &trashRoot)
+{
+    if (!QFileInfo(path).isDir())
+        return;
+    if (!moveToTrash(path, trashRoot))
+    {
+        qCDebug(fileutils).noquote() << "Deleting staging folder" << path;
+        QDir(path).removeRecursively();
+    }
+    // Only succeeds if no other staging folders are in use.
+    QDir().rmdir(QFileInfo(path).absolutePath());
+}
+
+void FileUtils::reapPartialDownloads(const QString &root)
+{
+    if (root.isEmpty())
+        return;
+
+    const QDir partialDir(QDir(root).absoluteFilePath(partialDirName));
+    const QDateTime abandonedTime = QDateTime::currentDateTimeUtc().addDays(-7);
+    for (const QFileInfo &entry : partialDir.entryInfoList(QDir::Files | QDir::Hidden))
+    {
+        if (entry.lastModified().toUTC() < abandonedTime)
+        {
+            qCDebug(fileutils).noquote() << "Deleting abandoned partial download" << entry.absoluteFilePath();
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
+
+QString FileUtils::cleanArchivePath(const QString &name)
+{
+    static const QRegularExpression driveRe(QStringLiteral("^[A-Za-z]:"));
+    if (name.startsWith('/') || name.startsWith('\\') || driveRe.match(name).hasMatch())
+        return QString();
+
+    QStringList parts;
+    const QStringList rawParts = QString(name).replace('\\', '/').split('/', Qt::SkipEmptyParts);
+    for (const QString &part : rawParts)
+    {
+        if (part == QLatin1String("."))
+            continue;
+        if (part == QLatin1String(".."))
+            return QString();
+        parts.append(part);
+    }
+    return parts.join('/');
+}
+
+bool FileUtils::isWritableArchivePath(const QString &path)
+{
+#ifdef Q_OS_WIN
+    return !path.contains(':');
+#else
+    Q_UNUSED(path);
+    return true;
+#endif
+}
+
 bool FileUtils::copyRecursively(const QString &srcPath, const QString &destPath, QString *errorInfo)
 {
     QDir srcDir(srcPath);
@@ -61,6 +260,7 @@ bool FileUtils::copyRecursively(const QString &srcPath, const QString &destPath,
     {
         if (entry == "modman.json")
             continue;
+        IIMODMAN_TRACE_SCOPE_DETAIL("files", "file.copy", srcDir.filePath(entry));
         if (!QFile::copy(srcDir.filePath(entry), destDir.filePath(entry)))
         {
             if (errorInfo)
@@ -72,6 +272,57 @@ bool FileUtils::copyRecursively(const QString &srcPath, const QString &destPath,
     return true;
 }
 
+//! Creates a hard link to an existing file. Fails if the paths are on different filesystems.
+static bool hardLink(const QString &srcPath, const QString &destPath)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(destPath).utf16()),
+                           reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(srcPath).utf16()), nullptr);
+#else
+    return ::link(QFile::encodeName(srcPath).constData(), QFile::encodeName(destPath).constData()) == 0;
+#endif
+}
+
+bool FileUtils::linkRecursively(const QString &srcPath, const QString &destPath, QString *errorInfo)
+{
+    QDir srcDir(srcPath);
+    QDir destDir(destPath);
+    if (!srcDir.exists())
+    {
+        if (errorInfo)
+            *errorInfo = QStringLiteral("Missing source dir: %1").arg(srcPath);
+        return false;
+    }
+    if (!destDir.mkpath(destPath))
+    {
+        if (errorInfo)
+            *errorInfo = QStringLiteral("Failed to create destination dir: %1").arg(destPath);
+        return false;
+    }
+
+    for (auto entry : srcDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden))
+    {
+        if (!linkRecursively(srcDir.filePath(entry), destDir.filePath(entry), errorInfo))
+            return false;
+    }
+    for (auto entry : srcDir.entryList(QDir::Files | QDir::Hidden))
+    {
+        if (entry == "modman.json")
+            continue;
+        const QString srcFile = srcDir.filePath(entry);
+        const QString destFile = destDir.filePath(entry);
+        IIMODMAN_TRACE_SCOPE_DETAIL("files", "file.link", srcFile);
+        if (!hardLink(srcFile, destFile) && !QFile::copy(srcFile, destFile))
+        {
+            if (errorInfo)
+                *errorInfo = QStringLiteral("Failed to link mod file: %1 to %2/").arg(srcFile, destPath);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 const QJsonObject FileUtils::readJSON(const QString &filePath, QString *errorInfo)
 {
     QFile file(filePath);
@@ -4,14 +4,55 @@
 #include "iimodman-lib_global.h"
 
 class QJsonObject;
+class QString;
 
 
 namespace iimodmanager {
 
 namespace FileUtils
 {
-    bool removeModDir(const QString &path, QString *errorInfo = nullptr);
+    //! How removeModDir disposes of a mod folder.
+    enum RemoveMode
+    {
+        //! Delete the folder before returning.
+        REMOVE_NOW,
+        //! Rename the folder into the trash directory of the trash root, and delete it on a low-priority background thread.
+        //! Falls back to REMOVE_NOW if the rename fails, such as if the trash root is on a different filesystem.
+        REMOVE_DEFERRED,
+    };
+    //! Name of the trash directory within a trash root.
+    //! Trashed folders are nested one level deeper, so the trash directory never looks like a mod folder itself.
+    extern const QString trashDirName;
+    //! Name of the staging directory within a root, where downloads are extracted before being moved into place.
+    extern const QString stagingDirName;
+    //! Name of the directory within a root where interrupted downloads are kept for resuming.
+    extern const QString partialDirName;
+
+    //! Removes the mod folder at the given path, if it exists. Refuses to remove non-empty folders that aren't mods.
+    //! A deferred removal uses the trash directory of the given root, or of the folder's parent if no root is specified.
+    bool removeModDir(const QString &path, QString *errorInfo = nullptr, RemoveMode mode = REMOVE_NOW, const QString &trashRoot = QString());
+    //! Deletes the contents of the trash directory of the given root on a low-priority background thread.
+    //! Called on startup to reclaim folders left behind if a previous run exited before its deletions completed.
+    //! Also discards staging folders abandoned more than a day ago.
+    void reapTrash(const QString &trashRoot);
+    //! Creates a new empty folder in the staging directory of the given root.
+    //! Returns its path, or a null string on failure.
+    QString createStagingDir(const QString &root, QString *errorInfo = nullptr);
+    //! Removes a staging folder and its contents, using the trash directory of the given root if possible.
+    void discardStagingDir(const QString &path, const QString &trashRoot);
+    //! Deletes partial downloads in the given root that haven't been resumed for a week.
+    void reapPartialDownloads(const QString &root);
+    //! Normalizes a zip entry name to a relative path with forward slashes.
+    //! Some mods are zipped with Windows separators. Returns a null string if the path would escape the output folder:
+    //! absolute paths, drive letters, and ".." parts.
+    QString cleanArchivePath(const QString &name);
+    //! False if a cleaned zip entry path can't be written on this platform, so the entry should be skipped.
+    //! On Windows, a ':' would write to an alternate data stream instead of the named file.
+    bool isWritableArchivePath(const QString &path);
     bool copyRecursively(const QString &srcPath, const QString &destPath, QString *errorInfo = nullptr);
+    //! Like copyRecursively, but hard links each file instead where the filesystem allows.
+    //! Only suitable for folders whose files are never modified in place, like cached mod versions.
+    bool linkRecursively(const QString &srcPath, const QString &destPath, QString *errorInfo = nullptr);
 
     const QJsonObject readJSON(const QString &filePath, QString *errorInfo = nullptr);
     bool writeJSON(const QString &filePath, const QJsonObject &root, QString *errorInfo = nullptr);
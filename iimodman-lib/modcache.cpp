@@ -4,15 +4,20 @@
 #include "modinfo.h"
 #include "modsignature.h"
 #include "modspec.h"
+#include "modversion.h"
+#include "tracing.h"
+#include "zipextractor.h"
 
-#include <JlCompress.h>
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFileDevice>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QList>
 #include <QMap>
+#include <QSet>
 
 namespace iimodmanager {
 
@@ -24,6 +29,13 @@ enum OperationContext
     PARTIAL_OP,
 };
 
+//! Identifies the Steam zip a version was extracted from.
+struct SteamContent
+{
+    QString handle;
+    qint64 fileSize = -1;
+};
+
 //! Private implementation of ModCache.
 //! Additionally exposes methods to the CachedMod/CachedVersion children defined in this file.
 class ModCache::Impl
@@ -40,15 +52,28 @@ public:
     CachedMod *mod(const QString &id, int *modIdx = nullptr);
 
     CachedMod *addUnloaded(const SteamModInfo &steamInfo, OperationContext context, int *modIdx = nullptr);
-    const CachedVersion *addZipVersion(const SteamModInfo &steamInfo, QIODevice &zipFile, QString *errorInfo = nullptr);
+    QString prepareZipVersion(const SteamModInfo &steamInfo, QString *errorInfo = nullptr);
+    const CachedVersion *addExtractedVersion(const SteamModInfo &steamInfo, QString *errorInfo = nullptr);
+    const CachedVersion *addStagedVersion(const SteamModInfo &steamInfo, const QString &stagingPath, QString *errorInfo = nullptr,
+                                          const QString &hash = QString(), const ModSignature::Stats *stats = nullptr);
     const CachedVersion *addModVersion(const QString &modId, const QString &versionId, const QString &folderPath, QString *errorInfo = nullptr);
-    void refresh(RefreshLevel = FULL);
+    void refresh(RefreshLevel = FULL, const std::function<void(const CachedMod &)> &modLoaded = nullptr);
+    void refreshMod(const QString &modId, RefreshLevel level);
     inline void save();
 
 // file-visibility:
     ModCache *q;
     inline QString modPath(const QString &modId) const;
     inline QString modVersionPath(const QString &modId, const QString &versionId) const;
+    const ModSignature::Stats *versionStats(const QString &modId, const QString &versionId) const;
+    void setVersionStats(const QString &modId, const QString &versionId, const ModSignature::Stats &stats) const;
+    void clearVersionStats(const QString &modId, const QString &versionId) const;
+    const SteamContent *versionContent(const QString &modId, const QString &versionId) const;
+    void setVersionContent(const QString &modId, const QString &versionId, const SteamContent &content) const;
+    void clearVersionContent(const QString &modId, const QString &versionId) const;
+    const CachedVersion *versionWithContent(const SteamModInfo &steamInfo) const;
+    void recordThroughput(ModCache::ThroughputKind kind, qint64 bytes, qint64 msecs) const;
+    qint64 throughput(ModCache::ThroughputKind kind) const;
 
 private:
     const ModManConfig &config_;
@@ -56,6 +81,14 @@ private:
     QList<CachedMod> mods_;
     //! Index of mods by mod ID.
     QHash<QString, qsizetype> modIds_;
+    //! Known file totals of each version, keyed by "{modId}/{versionId}".
+    //! Kept outside of the CachedVersion objects, so that they survive refreshes.
+    mutable QHash<QString, ModSignature::Stats> versionStats_;
+    //! Steam content each downloaded version was extracted from, keyed like versionStats_.
+    mutable QHash<QString, SteamContent> versionContents_;
+    //! Smoothed bytes per second of each ThroughputKind.
+    mutable qint64 copyThroughput_;
+    mutable qint64 hashThroughput_;
 
     void sortMods();
     void refreshIndex();
@@ -122,6 +155,9 @@ public:
     inline const std::optional<QString> version() const { return version_; };
     inline bool installed() const { return installed_; };
     const QString &hash() const;
+    inline bool isHashed() const { return !hash_.isEmpty(); };
+    const ModSignature::Stats &stats() const;
+    inline const ModSignature::Stats *knownStats() const { return cache.versionStats(modId_, id_); }
 
     const SpecMod asSpec() const;
 
@@ -130,6 +166,8 @@ public:
 // file-visibility:
     inline void setInstalled(bool value) { installed_ = value; };
     inline void refreshSpecMod() const { specMod.reset(); };
+    //! Sets a hash that was computed elsewhere for the same contents. Cleared by the next refresh.
+    inline void presetHash(const QString &hash) const { hash_ = hash; };
     bool refresh(ModCache::RefreshLevel = ModCache::FULL, QString *errorInfo = nullptr) const;
 
 private:
@@ -146,16 +184,7 @@ private:
 };
 
 // Folder Structure: {cachePath}/workshop-{steamId}/{versionTime}/
-// Time format is ISO8601, but with ':' replaced with '_' to be a valid folder name on Windows.
-static const QString formatVersionTime(const QDateTime &versionTime)
-{
-    return versionTime.toString(Qt::ISODate).replace(':', '_');
-}
-
-static const QDateTime parseVersionTime(const QString &versionId)
-{
-    return QDateTime::fromString(QString(versionId).left(20).replace('_', ':'), Qt::ISODate);
-}
+// See formatVersionTime() for the time format.
 
 static bool compareModIds(const CachedMod &a, const CachedMod &b)
 {
@@ -167,44 +196,6 @@ static bool compareVersionIds(const CachedVersion &a, const CachedVersion &b)
     return a.id() > b.id();
 }
 
-/**
- * @brief Fix extracted file names containing '\' separators that should be sub folders.
- * @param cacheDir The root directory of the cache. Used for log and error statements.
- * @param dir The directory into which files were extracted.
- * @param fileNames The absolute paths of the extracted files.
- *
- * The Mod Uploader creates non-conforming ZIP files using the local path separator, but QuaZip::QuaZip explicitly does not support such files.
- * In that case, on non-Windows systems, files were incorrectly extracted with "path\filename".
- */
-static bool fixFileNames(const QDir &cacheDir, const QDir &dir, const QStringList &filePaths, QString *errorInfo = nullptr)
-{
-    for (const QString &absolutePath : filePaths)
-    {
-        QFileInfo info(absolutePath);
-        QString name = info.fileName();
-
-        if (dir.absoluteFilePath(name) == absolutePath && name.contains('\\'))
-        {
-            QFile file(absolutePath);
-            QString newPath = dir.absoluteFilePath(name.replace('\\', '/'));
-
-            if (QDir().mkpath(QFileInfo(newPath).absolutePath()) && file.rename(newPath))
-            {
-                qCWarning(modcache).noquote() << QStringLiteral("Renamed %1 to %2").arg(cacheDir.relativeFilePath(absolutePath), cacheDir.relativeFilePath(newPath));
-            }
-            else
-            {
-                QString msg = QStringLiteral("Failed to rename %1 to %2").arg(cacheDir.relativeFilePath(absolutePath).toUtf8().constData(), cacheDir.relativeFilePath(newPath).toUtf8().constData());
-                qCCritical(modcache).noquote() << msg;
-                if (errorInfo)
-                    *errorInfo = msg;
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
 ModCache::ModCache(const ModManConfig &config, QObject *parent)
     : QObject(parent), impl{std::make_unique<Impl>(config)}
 {
@@ -238,7 +229,52 @@ const CachedMod *ModCache::addUnloaded(const SteamModInfo &steamInfo)
 
 const CachedVersion *ModCache::addZipVersion(const SteamModInfo &steamInfo, QIODevice &zipFile, QString *errorInfo)
 {
-    return impl->addZipVersion(steamInfo, zipFile, errorInfo);
+    const QString outputPath = impl->prepareZipVersion(steamInfo, errorInfo);
+    if (outputPath.isNull() || !extractZip(zipFile, outputPath, errorInfo))
+        return nullptr;
+    return impl->addExtractedVersion(steamInfo, errorInfo);
+}
+
+QString ModCache::prepareZipVersion(const SteamModInfo &steamInfo, QString *errorInfo)
+{
+    return impl->prepareZipVersion(steamInfo, errorInfo);
+}
+
+bool ModCache::extractZip(QIODevice &zipFile, const QString &outputPath, QString *errorInfo)
+{
+    IIMODMAN_TRACE_SCOPE_DETAIL("modcache", "zip.extract", outputPath);
+    qCDebug(modcache).noquote() << "Unzip Start" << outputPath;
+    bool ok;
+    QFileDevice *file = qobject_cast<QFileDevice *>(&zipFile);
+    if (file && !file->fileName().isEmpty())
+    {
+        // Workers open their own handles on the file, so make sure everything written so far is on disk.
+        file->flush();
+        ok = ZipExtractor::extractFile(file->fileName(), outputPath, errorInfo);
+    }
+    else
+    {
+        zipFile.seek(0);
+        ok = ZipExtractor::extractDevice(zipFile, outputPath, errorInfo);
+    }
+    qCDebug(modcache).noquote() << "Unzip End" << outputPath;
+    return ok;
+}
+
+const CachedVersion *ModCache::addExtractedVersion(const SteamModInfo &steamInfo, QString *errorInfo)
+{
+    return impl->addExtractedVersion(steamInfo, errorInfo);
+}
+
+const CachedVersion *ModCache::versionWithContent(const SteamModInfo &steamInfo) const
+{
+    return impl->versionWithContent(steamInfo);
+}
+
+const CachedVersion *ModCache::addStagedVersion(const SteamModInfo &steamInfo, const QString &stagingPath, QString *errorInfo,
+                                                const QString &hash, const ModSignature::Stats *stats)
+{
+    return impl->addStagedVersion(steamInfo, stagingPath, errorInfo, hash, stats);
 }
 
 const CachedVersion *ModCache::addModVersion(const QString &modId, const QString &versionId, const QString &folderPath, QString *errorInfo)
@@ -251,6 +287,16 @@ void ModCache::refresh(ModCache::RefreshLevel level)
     impl->refresh(level);
 }
 
+void ModCache::refresh(ModCache::RefreshLevel level, const std::function<void(const CachedMod &)> &modLoaded)
+{
+    impl->refresh(level, modLoaded);
+}
+
+void ModCache::refreshMod(const QString &modId, ModCache::RefreshLevel level)
+{
+    impl->refreshMod(modId, level);
+}
+
 const CachedVersion *ModCache::refreshVersion(const QString &modId, const QString &versionId, ModCache::RefreshLevel level)
 {
     int modIdx;
@@ -340,11 +386,24 @@ void ModCache::clearAvailableVersion(const QString &modId)
     }
 }
 
+void ModCache::recordThroughput(ThroughputKind kind, qint64 bytes, qint64 msecs)
+{
+    impl->recordThroughput(kind, bytes, msecs);
+}
+
+qint64 ModCache::throughput(ThroughputKind kind) const
+{
+    return impl->throughput(kind);
+}
+
 ModCache::~ModCache() = default;
 
 ModCache::Impl::Impl(const ModManConfig &config)
-    : config_(config)
-{}
+    : config_(config), copyThroughput_(0), hashThroughput_(0)
+{
+    FileUtils::reapTrash(config_.cachePath());
+    FileUtils::reapPartialDownloads(config_.cachePath());
+}
 
 bool ModCache::Impl::contains(const QString &id) const
 {
@@ -408,15 +467,32 @@ CachedMod *ModCache::Impl::addUnloaded(const SteamModInfo &steamInfo, OperationC
     return nullptr;
 }
 
-const CachedVersion *ModCache::Impl::addZipVersion(const SteamModInfo &steamInfo, QIODevice &zipFile, QString *errorInfo)
+QString ModCache::Impl::prepareZipVersion(const SteamModInfo &steamInfo, QString *errorInfo)
 {
     if (steamInfo.id.isEmpty())
-        return nullptr;
+    {
+        if (errorInfo)
+            *errorInfo = "Missing workshop ID";
+        return QString();
+    }
 
     const QString modId = steamInfo.modId();
     const QString versionId = formatVersionTime(steamInfo.lastUpdated);
-    const QDir cacheDir(config_.cachePath());
     QString outputPath = modVersionPath(modId, versionId);
+    if (!FileUtils::removeModDir(outputPath, errorInfo, FileUtils::REMOVE_DEFERRED, config_.cachePath()))
+        return QString();
+    clearVersionStats(modId, versionId);
+    clearVersionContent(modId, versionId);
+    return outputPath;
+}
+
+const CachedVersion *ModCache::Impl::addExtractedVersion(const SteamModInfo &steamInfo, QString *errorInfo)
+{
+    if (steamInfo.id.isEmpty())
+        return nullptr;
+
+    const QString modId = steamInfo.modId();
+    const QString versionId = formatVersionTime(steamInfo.lastUpdated);
 
     int modIdx;
     CachedMod *m = mod(modId, &modIdx);
@@ -431,18 +507,11 @@ const CachedVersion *ModCache::Impl::addZipVersion(const SteamModInfo &steamInfo
         return nullptr;
     }
 
-    if (!FileUtils::removeModDir(outputPath, errorInfo))
-        return nullptr;
-
-    qCDebug(modcache).noquote() << modId << "Unzip Start" << outputPath;
-    QStringList files = JlCompress::extractDir(&zipFile, outputPath);
-    bool ok = fixFileNames(cacheDir, QDir(outputPath), files, errorInfo);
-    qCDebug(modcache).noquote() << modId << "Unzip End";
-    if (!ok) return nullptr;
-
     if (!isNewMod)
         emit q->aboutToRefresh({modId}, {modIdx}, ModCache::VERSION_ONLY_HINT);
     const CachedVersion *v = m->impl()->refreshVersion(versionId, ModCache::FULL, errorInfo);
+    if (v && !steamInfo.contentHandle.isEmpty())
+        setVersionContent(modId, versionId, {steamInfo.contentHandle, steamInfo.fileSize});
     if (isNewMod)
         emit q->appendedMods();
     else
@@ -450,6 +519,52 @@ const CachedVersion *ModCache::Impl::addZipVersion(const SteamModInfo &steamInfo
     return v;
 }
 
+const CachedVersion *ModCache::Impl::versionWithContent(const SteamModInfo &steamInfo) const
+{
+    // "0" is sent for items without a file.
+    if (steamInfo.contentHandle.isEmpty() || steamInfo.contentHandle == QLatin1String("0") || steamInfo.fileSize < 0)
+        return nullptr;
+    const CachedMod *m = mod(steamInfo.modId());
+    if (!m)
+        return nullptr;
+
+    const QString versionId = formatVersionTime(steamInfo.lastUpdated);
+    for (const CachedVersion &v : m->versions())
+    {
+        if (v.id() == versionId)
+            continue;
+        const SteamContent *content = versionContent(m->id(), v.id());
+        if (content && content->handle == steamInfo.contentHandle && content->fileSize == steamInfo.fileSize)
+            return &v;
+    }
+    return nullptr;
+}
+
+const CachedVersion *ModCache::Impl::addStagedVersion(const SteamModInfo &steamInfo, const QString &stagingPath, QString *errorInfo,
+                                                      const QString &hash, const ModSignature::Stats *stats)
+{
+    const QString outputPath = prepareZipVersion(steamInfo, errorInfo);
+    if (outputPath.isNull())
+        return nullptr;
+
+    if (!QDir().mkpath(QFileInfo(outputPath).absolutePath()) || !QDir().rename(stagingPath, outputPath))
+    {
+        QString msg = QStringLiteral("Failed to move extracted mod into the cache: %1").arg(outputPath);
+        qCCritical(modcache).noquote() << msg;
+        if (errorInfo)
+            *errorInfo = msg;
+        return nullptr;
+    }
+    const CachedVersion *v = addExtractedVersion(steamInfo, errorInfo);
+    if (v && !hash.isEmpty() && stats)
+    {
+        // Moving the folder didn't change its contents.
+        v->impl()->presetHash(hash);
+        setVersionStats(v->modId(), v->id(), *stats);
+    }
+    return v;
+}
+
 const CachedVersion *ModCache::Impl::addModVersion(const QString &modId, const QString &versionId, const QString &folderPath, QString *errorInfo)
 {
     QDir sourceDir(folderPath);
@@ -462,8 +577,9 @@ const CachedVersion *ModCache::Impl::addModVersion(const QString &modId, const Q
     }
 
     QString outputPath = modVersionPath(modId, versionId);
-    if (!FileUtils::removeModDir(outputPath, errorInfo))
+    if (!FileUtils::removeModDir(outputPath, errorInfo, FileUtils::REMOVE_DEFERRED, config_.cachePath()))
         return nullptr;
+    clearVersionStats(modId, versionId);
     qCDebug(modcache) << "Copying" << folderPath << "to" << outputPath;
     if (!FileUtils::copyRecursively(folderPath, outputPath, errorInfo))
     {
@@ -508,9 +624,10 @@ const QHash<QString, QString> ModCache::Impl::saveInstalledVersionIds() const
     return map;
 }
 
-void ModCache::Impl::refresh(RefreshLevel level)
+void ModCache::Impl::refresh(RefreshLevel level, const std::function<void(const CachedMod &)> &modLoaded)
 {
     QDir cacheDir(config_.cachePath());
+    IIMODMAN_TRACE_SCOPE_DETAIL("modcache", "cache.refresh", cacheDir.path());
     qCDebug(modcache).noquote() << "cache:refresh() Start" << cacheDir.path();
 
     emit q->aboutToRefresh();
@@ -524,21 +641,37 @@ void ModCache::Impl::refresh(RefreshLevel level)
 
     cacheDir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
     cacheDir.setSorting(QDir::Name);
-    const QStringList modIds = cacheDir.entryList();
+    QStringList modIds = cacheDir.entryList();
+    modIds.removeAll(FileUtils::trashDirName);
+    modIds.removeAll(FileUtils::stagingDirName);
+    modIds.removeAll(FileUtils::partialDirName);
     mods_.reserve(mods_.size() + modIds.size());
     for (const auto &modId : modIds)
     {
         if (CachedMod *m = mod(modId))
         {
             m->impl()->refresh(level, installedVersionIds.value(modId));
+            if (modLoaded)
+                modLoaded(*m);
         }
         else
         {
             CachedMod newMod(*this, modId);
             if (newMod.impl()->refresh(level, installedVersionIds.value(modId)))
+            {
                 mods_.append(newMod);
+                if (modLoaded)
+                    modLoaded(newMod);
+            }
         }
     }
+    if (modLoaded)
+    {
+        const QSet<QString> folderModIds(modIds.begin(), modIds.end());
+        for (const CachedMod &m : qAsConst(mods_))
+            if (!folderModIds.contains(m.id()))
+                modLoaded(m);
+    }
 
     sortMods(); // Automatically refreshes the index.
 
@@ -546,8 +679,31 @@ void ModCache::Impl::refresh(RefreshLevel level)
     emit q->refreshed();
 }
 
+void ModCache::Impl::refreshMod(const QString &modId, RefreshLevel level)
+{
+    IIMODMAN_TRACE_SCOPE_DETAIL("modcache", "cache.refreshMod", modId);
+    int modIdx;
+    if (CachedMod *m = mod(modId, &modIdx))
+    {
+        // Kept even without versions, like a mod only known from the metadata file.
+        emit q->aboutToRefresh({modId}, {modIdx}, ModCache::VERSION_ONLY_HINT);
+        m->impl()->refresh(level);
+        emit q->refreshed({modId}, {modIdx}, ModCache::VERSION_ONLY_HINT);
+        return;
+    }
+
+    CachedMod newMod(*this, modId);
+    if (!newMod.impl()->refresh(level))
+        return;
+    emit q->aboutToAppendMods({modId});
+    mods_.append(newMod);
+    refreshIndex();
+    emit q->appendedMods();
+}
+
 void ModCache::Impl::save()
 {
+    IIMODMAN_TRACE_SCOPE("modcache", "cache.saveMetadata");
     emit q->aboutToRefresh(QStringList(), QList<int>(), ModCache::SORT_ONLY_HINT);
     sortMods();
     emit q->refreshed(QStringList(), QList<int>(), ModCache::SORT_ONLY_HINT);
@@ -567,6 +723,60 @@ QString ModCache::Impl::modVersionPath(const QString &modId, const QString &vers
     return modDir.absoluteFilePath(versionId);
 }
 
+static inline QString versionStatsKey(const QString &modId, const QString &versionId)
+{
+    return modId + '/' + versionId;
+}
+
+const ModSignature::Stats *ModCache::Impl::versionStats(const QString &modId, const QString &versionId) const
+{
+    auto it = versionStats_.constFind(versionStatsKey(modId, versionId));
+    return it != versionStats_.constEnd() ? &*it : nullptr;
+}
+
+void ModCache::Impl::setVersionStats(const QString &modId, const QString &versionId, const ModSignature::Stats &stats) const
+{
+    versionStats_.insert(versionStatsKey(modId, versionId), stats);
+}
+
+void ModCache::Impl::clearVersionStats(const QString &modId, const QString &versionId) const
+{
+    versionStats_.remove(versionStatsKey(modId, versionId));
+}
+
+const SteamContent *ModCache::Impl::versionContent(const QString &modId, const QString &versionId) const
+{
+    auto it = versionContents_.constFind(versionStatsKey(modId, versionId));
+    return it != versionContents_.constEnd() ? &*it : nullptr;
+}
+
+void ModCache::Impl::setVersionContent(const QString &modId, const QString &versionId, const SteamContent &content) const
+{
+    versionContents_.insert(versionStatsKey(modId, versionId), content);
+}
+
+void ModCache::Impl::clearVersionContent(const QString &modId, const QString &versionId) const
+{
+    versionContents_.remove(versionStatsKey(modId, versionId));
+}
+
+void ModCache::Impl::recordThroughput(ModCache::ThroughputKind kind, qint64 bytes, qint64 msecs) const
+{
+    // Very short operations are dominated by overhead, and would skew the estimate.
+    if (msecs < 10 || bytes <= 0)
+        return;
+
+    qint64 &value = kind == ModCache::COPY_THROUGHPUT ? copyThroughput_ : hashThroughput_;
+    const qint64 sample = bytes * 1000 / msecs;
+    // Exponential moving average, to smooth out differences between warm and cold disk caches.
+    value = value > 0 ? (3 * value + sample) / 4 : sample;
+}
+
+qint64 ModCache::Impl::throughput(ModCache::ThroughputKind kind) const
+{
+    return kind == ModCache::COPY_THROUGHPUT ? copyThroughput_ : hashThroughput_;
+}
+
 void ModCache::Impl::sortMods()
 {
     std::sort(mods_.begin(), mods_.end(), compareModIds);
@@ -591,6 +801,16 @@ bool ModCache::Impl::readModManDb()
     if (root.isEmpty())
         return false;
 
+    // Prefer any values measured by this process.
+    if (root.contains("throughput") && root["throughput"].isObject())
+    {
+        const QJsonObject throughputObject = root["throughput"].toObject();
+        if (copyThroughput_ <= 0)
+            copyThroughput_ = throughputObject["copy"].toVariant().toLongLong();
+        if (hashThroughput_ <= 0)
+            hashThroughput_ = throughputObject["hash"].toVariant().toLongLong();
+    }
+
     if (root.contains("mods") && root["mods"].isArray())
     {
         const QJsonArray modsArray = root["mods"].toArray();
@@ -619,6 +839,14 @@ bool ModCache::Impl::writeModManDb()
     }
     root["mods"] = modsArray;
 
+    if (copyThroughput_ > 0 || hashThroughput_ > 0)
+    {
+        QJsonObject throughputObject;
+        throughputObject["copy"] = copyThroughput_;
+        throughputObject["hash"] = hashThroughput_;
+        root["throughput"] = throughputObject;
+    }
+
     QDir cacheDir(config_.cachePath());
     return FileUtils::writeJSON(cacheDir.filePath("modmandb.json"), root);
 }
@@ -860,6 +1088,30 @@ bool CachedMod::Impl::readDb(const QJsonObject &modObject)
         defaultAlias_ = modObject["defaultAlias"].toString();
     if (modObject.contains("availableVersion") && modObject["availableVersion"].isString())
         availableVersion_ = QDateTime::fromString(modObject["availableVersion"].toString(), Qt::ISODate);
+    if (!id_.isEmpty() && modObject.contains("versions") && modObject["versions"].isArray())
+    {
+        for (const QJsonValue &v : modObject["versions"].toArray())
+        {
+            const QJsonObject versionObject = v.toObject();
+            const QString versionId = versionObject["versionId"].toString();
+            if (versionId.isEmpty())
+                continue;
+            if (versionObject.contains("contentHandle") && !cache.versionContent(id_, versionId))
+            {
+                SteamContent content;
+                content.handle = versionObject["contentHandle"].toString();
+                content.fileSize = versionObject["zipSize"].toVariant().toLongLong();
+                cache.setVersionContent(id_, versionId, content);
+            }
+            // Don't replace values measured by this process.
+            if (!versionObject.contains("size") || cache.versionStats(id_, versionId))
+                continue;
+            ModSignature::Stats stats;
+            stats.bytes = versionObject["size"].toVariant().toLongLong();
+            stats.files = versionObject["files"].toInt();
+            cache.setVersionStats(id_, versionId, stats);
+        }
+    }
 
     if (!id_.isEmpty() && !name.isEmpty())
     {
@@ -877,6 +1129,31 @@ void CachedMod::Impl::writeDb(QJsonObject &modObject) const
         modObject["defaultAlias"] = defaultAlias();
     if (availableVersion())
         modObject["availableVersion"] = availableVersion()->toString(Qt::ISODate);
+
+    QJsonArray versionsArray;
+    for (const CachedVersion &cv : versions_)
+    {
+        const ModSignature::Stats *stats = cache.versionStats(id_, cv.id());
+        const SteamContent *content = cache.versionContent(id_, cv.id());
+        if (!stats && !content)
+            continue;
+
+        QJsonObject versionObject;
+        versionObject["versionId"] = cv.id();
+        if (stats)
+        {
+            versionObject["size"] = stats->bytes;
+            versionObject["files"] = stats->files;
+        }
+        if (content)
+        {
+            versionObject["contentHandle"] = content->handle;
+            versionObject["zipSize"] = content->fileSize;
+        }
+        versionsArray.append(versionObject);
+    }
+    if (!versionsArray.isEmpty())
+        modObject["versions"] = versionsArray;
 }
 
 const CachedVersion *CachedMod::Impl::versionFromHash(const QString &hash, const QString &expectedVersionId) const
@@ -964,6 +1241,33 @@ const QString &CachedVersion::hash() const
     return impl()->hash();
 }
 
+bool CachedVersion::isHashed() const
+{
+    return impl()->isHashed();
+}
+
+qint64 CachedVersion::size() const
+{
+    return impl()->stats().bytes;
+}
+
+int CachedVersion::fileCount() const
+{
+    return impl()->stats().files;
+}
+
+qint64 CachedVersion::knownSize() const
+{
+    const ModSignature::Stats *stats = impl()->knownStats();
+    return stats ? stats->bytes : -1;
+}
+
+int CachedVersion::knownFileCount() const
+{
+    const ModSignature::Stats *stats = impl()->knownStats();
+    return stats ? stats->files : -1;
+}
+
 const QString CachedVersion::toString(StringFormat format) const
 {
     if (auto version = impl()->version())
@@ -997,10 +1301,26 @@ CachedVersion::Impl::Impl(const ModCache::Impl &cache, const QString &modId, con
 const QString &CachedVersion::Impl::hash() const
 {
     if (hash_.isEmpty())
-        hash_ = ModSignature::hashModPath(cache.modVersionPath(modId_, id_));
+    {
+        ModSignature::Stats stats;
+        QElapsedTimer timer;
+        timer.start();
+        hash_ = ModSignature::hashModPath(cache.modVersionPath(modId_, id_), &stats);
+        cache.recordThroughput(ModCache::HASH_THROUGHPUT, stats.bytes, timer.elapsed());
+        cache.setVersionStats(modId_, id_, stats);
+    }
     return hash_;
 }
 
+const ModSignature::Stats &CachedVersion::Impl::stats() const
+{
+    if (const ModSignature::Stats *stats = cache.versionStats(modId_, id_))
+        return *stats;
+
+    cache.setVersionStats(modId_, id_, ModSignature::statModPath(cache.modVersionPath(modId_, id_)));
+    return *cache.versionStats(modId_, id_);
+}
+
 const SpecMod CachedVersion::Impl::asSpec() const
 {
     if (!specMod)
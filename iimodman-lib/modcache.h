@@ -7,6 +7,7 @@
 
 #include <QLoggingCategory>
 #include <QObject>
+#include <functional>
 #include <memory>
 #include <optional>
 
@@ -20,6 +21,7 @@ class ModInfo;
 class ModManConfig;
 class SpecMod;
 struct SteamModInfo;
+namespace ModSignature { struct Stats; }
 
 
 Q_DECLARE_LOGGING_CATEGORY(modcache)
@@ -61,6 +63,14 @@ public:
         //! Only metadata and versions will change. No mods will be added or removed.
         VERSION_ONLY_HINT,
     };
+    //! Kinds of disk operations with measured throughput.
+    enum ThroughputKind
+    {
+        //! Copying mod folders between the cache and the install.
+        COPY_THROUGHPUT,
+        //! Reading mod folders to compute their signature.
+        HASH_THROUGHPUT,
+    };
 
     ModCache(const ModManConfig &config, QObject *parent = nullptr);
 
@@ -77,10 +87,32 @@ public:
     const CachedMod *addUnloaded(const SteamModInfo &steamInfo);
     //! Extracts the zip contents into a new or existing CachedVersion
     const CachedVersion *addZipVersion(const SteamModInfo &steamInfo, QIODevice &zipFile, QString *errorInfo = nullptr);
+    //! First step of adding a zip version in separate steps: clears the version's folder and returns its path.
+    //! Returns a null string on failure.
+    QString prepareZipVersion(const SteamModInfo &steamInfo, QString *errorInfo = nullptr);
+    //! Second step of adding a zip version: extracts the zip contents into the prepared folder.
+    //! Zips saved to a file are extracted on several threads at once.
+    //! Only touches the filesystem, so may be called on a worker thread.
+    static bool extractZip(QIODevice &zipFile, const QString &outputPath, QString *errorInfo = nullptr);
+    //! Final step of adding a zip version: registers the extracted folder as a new or existing CachedVersion.
+    const CachedVersion *addExtractedVersion(const SteamModInfo &steamInfo, QString *errorInfo = nullptr);
+    //! Another cached version of the same mod that was extracted from identical Steam content, if any.
+    //! Lets a version whose timestamp changed without a new zip be linked from the existing files instead of downloaded.
+    const CachedVersion *versionWithContent(const SteamModInfo &steamInfo) const;
+    //! Moves a folder extracted elsewhere on the cache's filesystem into a new or existing CachedVersion.
+    //! If the folder was already hashed where it was staged, pass the hash and file totals so that they needn't be read again.
+    const CachedVersion *addStagedVersion(const SteamModInfo &steamInfo, const QString &stagingPath, QString *errorInfo = nullptr,
+                                          const QString &hash = QString(), const ModSignature::Stats *stats = nullptr);
     //! Copies the given folder's contents into a new or existing CachedVersion
     const CachedVersion *addModVersion(const QString &modId, const QString &versionId, const QString &folderPath, QString *errorInfo = nullptr);
     //! Refreshes all mods from disk to the specified level.
     void refresh(RefreshLevel level = FULL);
+    //! Like refresh, but calls modLoaded for each mod as soon as it's loaded: mods with a folder in folder order,
+    //! then mods only known from the metadata. The cache is only consistent again once this returns.
+    void refresh(RefreshLevel level, const std::function<void(const CachedMod &)> &modLoaded);
+    //! Refreshes a single mod's versions from disk to the specified level, such as after a version was added or removed.
+    //! A mod folder that isn't in the cache yet is added, if it has any versions.
+    void refreshMod(const QString &modId, RefreshLevel level = FULL);
     //! Refreshes and returns the specific mod version from disk. Nullptr if not present.
     const CachedVersion *refreshVersion(const QString &modId, const QString &versionId, RefreshLevel level = FULL);
     //! Re-sorts the cache and persists metadata to disk.
@@ -99,6 +131,12 @@ public:
     //! Remove any marked available versions.
     void clearAvailableVersion(const QString &modId);
 
+    //! Records the measured speed of a disk operation, for estimating the duration of future operations.
+    //! Persisted with the other metadata.
+    void recordThroughput(ThroughputKind kind, qint64 bytes, qint64 msecs);
+    //! Smoothed throughput in bytes per second, or 0 if it hasn't been measured yet.
+    qint64 throughput(ThroughputKind kind) const;
+
     ~ModCache();
 
 signals:
@@ -178,6 +216,17 @@ public:
     const std::optional<QString> version() const;
     bool installed() const;
     const QString &hash() const;
+    //! True if the hash has already been computed.
+    bool isHashed() const;
+    //! Total size in bytes of the version's files.
+    //! Persisted with the cache metadata, so only the first call on a new version needs to scan its folder.
+    qint64 size() const;
+    //! Number of files in the version. Persisted like size().
+    int fileCount() const;
+    //! Total size in bytes of the version's files, if known without scanning its folder. Otherwise -1.
+    qint64 knownSize() const;
+    //! Number of files in the version, if known without scanning its folder. Otherwise -1.
+    int knownFileCount() const;
 
     const QString toString(StringFormat format = FORMAT_SHORT) const;
     const SpecMod asSpec() const;
@@ -1,11 +1,22 @@
+#include "fileutils.h"
 #include "moddownloader.h"
 #include "modcache.h"
+#include "modsignature.h"
+#include "steaminfocache.h"
+#include "tracing.h"
+#include "zipstreamextractor.h"
 
+#include <QCryptographicHash>
+#include <QDir>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkReply>
-#include <QTemporaryFile>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTimer>
+#include <QUrl>
+#include <QtMath>
 
 namespace iimodmanager {
 
@@ -13,45 +24,260 @@ Q_LOGGING_CATEGORY(steamAPI, "steamapi", QtWarningMsg)
 
 
 ModDownloader::ModDownloader(const ModManConfig &config, QObject *parent)
-    : QObject(parent), config_(config)
-{}
+    : QObject(parent), config_(config), scheduler_(config, qnam_), infoCache_(std::make_unique<SteamInfoCache>(config))
+{
+    extractPool_.setMaxThreadCount(1);
+}
+
+ModDownloader::~ModDownloader() = default;
 
 ModInfoCall *ModDownloader::fetchModInfo(const QString &id)
 {
-    ModInfoCall *call = new ModInfoCall(config_, qnam_, this);
+    ModInfoCall *call = new ModInfoCall(config_, scheduler_, this);
     call->start(id);
     return call;
 }
 
 ModInfoCall *ModDownloader::modInfoCall()
 {
-    ModInfoCall *call = new ModInfoCall(config_, qnam_, this);
+    ModInfoCall *call = new ModInfoCall(config_, scheduler_, this);
+    return call;
+}
+
+ModInfoBatchCall *ModDownloader::modInfoBatchCall()
+{
+    ModInfoBatchCall *call = new ModInfoBatchCall(config_, scheduler_, *infoCache_, this);
     return call;
 }
 
 ModDownloadCall *ModDownloader::downloadModVersion(ModCache &cache, const SteamModInfo &info)
 {
-    ModDownloadCall *call = new ModDownloadCall(config_, qnam_, cache, this);
+    ModDownloadCall *call = new ModDownloadCall(config_, scheduler_, extractPool_, cache, this);
     call->start(info);
     return call;
 }
 
 ModDownloadCall *ModDownloader::modDownloadCall(ModCache &cache)
 {
-    ModDownloadCall *call = new ModDownloadCall(config_, qnam_, cache, this);
+    ModDownloadCall *call = new ModDownloadCall(config_, scheduler_, extractPool_, cache, this);
     return call;
 }
 
+ModDownloadQueue *ModDownloader::downloadQueue(ModCache &cache)
+{
+    ModDownloadQueue *queue = new ModDownloadQueue(*this, cache, this);
+    return queue;
+}
+
 ApplicationVersionCall *ModDownloader::appVersionCall()
 {
     ApplicationVersionCall *call = new ApplicationVersionCall(qnam_, this);
     return call;
 }
 
-static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &debugContext, QString *errorInfo = nullptr)
+static bool isTransientError(QNetworkReply::NetworkError error)
 {
-    SteamModInfo result;
+    switch (error)
+    {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::InternalServerError:
+    case QNetworkReply::ServiceUnavailableError:
+    case QNetworkReply::UnknownServerError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//! Set on replies that the scheduler aborted for stalling.
+static const char *const timedOutProperty = "iimodmanTimedOut";
+//! Upper bound on the backoff between retries, before jitter.
+static const int maxRetryDelayMs = 60 * 1000;
+//! Upper bound on a server's requested Retry-After delay.
+static const int maxRetryAfterMs = 5 * 60 * 1000;
+
+RequestScheduler::Stats RequestScheduler::Stats::operator-(const Stats &other) const
+{
+    Stats result;
+    result.requests = requests - other.requests;
+    result.retries = retries - other.retries;
+    result.timeouts = timeouts - other.timeouts;
+    result.throttled = throttled - other.throttled;
+    return result;
+}
+
+QString RequestScheduler::Stats::toString() const
+{
+    return QStringLiteral("%1 requests, %2 retries, %3 timeouts, %4 throttled").arg(requests).arg(retries).arg(timeouts).arg(throttled);
+}
+
+RequestScheduler::RequestScheduler(const ModManConfig &config, QNetworkAccessManager &qnam, QObject *parent)
+    : QObject(parent), config_(config), qnam_(qnam), tokens_(0)
+{
+    releaseTimer_.setSingleShot(true);
+    connect(&releaseTimer_, &QTimer::timeout, this, &RequestScheduler::releasePending);
+}
+
+void RequestScheduler::send(Operation op, const QNetworkRequest &request, const QByteArray &data, QObject *context, std::function<void(QNetworkReply *)> sent)
+{
+    pending_.append({op, request, data, context, std::move(sent)});
+    releasePending();
+    if (!pending_.isEmpty())
+        ++stats_.throttled;
+}
+
+void RequestScheduler::sendWithRetry(Operation op, const QNetworkRequest &request, const QByteArray &data, QObject *context, std::function<void(QNetworkReply *)> finished)
+{
+    attempt(op, request, data, context, std::move(finished), 0);
+}
+
+void RequestScheduler::attempt(Operation op, const QNetworkRequest &request, const QByteArray &data, QPointer<QObject> context, std::function<void(QNetworkReply *)> finished, int retry)
+{
+    send(op, request, data, context, [this, op, request, data, context, finished, retry](QNetworkReply *reply)
+    {
+        connect(reply, &QNetworkReply::finished, this, [this, op, request, data, context, finished, retry, reply]
+        {
+            reply->deleteLater();
+            if (!context)
+                return;
+            if (retry < maxRetries() && isRetryable(reply))
+            {
+                const int delay = retryDelay(retry + 1, reply);
+                qCWarning(steamAPI).noquote() << request.url().toString() << "Request failed, retrying in" << delay << "ms:" << reply->errorString();
+                recordRetry();
+                QTimer::singleShot(delay, context, [this, op, request, data, context, finished, retry]
+                {
+                    attempt(op, request, data, context, finished, retry + 1);
+                });
+                return;
+            }
+            finished(reply);
+        });
+    });
+}
+
+bool RequestScheduler::isRetryable(QNetworkReply *reply) const
+{
+    if (reply->property(timedOutProperty).toBool())
+        return true;
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    switch (status)
+    {
+    case 429:
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+        return true;
+    case 0:
+        return isTransientError(reply->error());
+    default:
+        return false;
+    }
+}
+
+int RequestScheduler::maxRetries() const
+{
+    return qMax(0, config_.maxRetries());
+}
+
+int RequestScheduler::retryDelay(int retry, QNetworkReply *reply) const
+{
+    if (reply && reply->hasRawHeader("Retry-After"))
+    {
+        // Either a number of seconds or an HTTP date.
+        const QByteArray retryAfter = reply->rawHeader("Retry-After").trimmed();
+        bool ok;
+        qint64 delayMs = retryAfter.toLongLong(&ok) * 1000;
+        if (!ok)
+        {
+            const QDateTime time = QDateTime::fromString(QString::fromLatin1(retryAfter), Qt::RFC2822Date);
+            ok = time.isValid();
+            delayMs = QDateTime::currentDateTimeUtc().msecsTo(time);
+        }
+        if (ok)
+            return static_cast<int>(qBound<qint64>(0, delayMs, maxRetryAfterMs));
+    }
+
+    // Exponential backoff, with jitter over the upper half so that simultaneous failures don't retry in lockstep.
+    const qint64 baseMs = qMax(0, config_.retryDelay());
+    const qint64 delayMs = qMin<qint64>(baseMs << qBound(0, retry - 1, 16), maxRetryDelayMs);
+    const qint64 halfMs = delayMs / 2;
+    return static_cast<int>(delayMs - halfMs + QRandomGenerator::global()->bounded(halfMs + 1));
+}
+
+void RequestScheduler::releasePending()
+{
+    const int rate = config_.requestRate();
+    if (rate > 0)
+    {
+        // Allow a burst of up to one second's worth of requests.
+        if (!tokenClock_.isValid())
+        {
+            tokens_ = rate;
+            tokenClock_.start();
+        }
+        else
+            tokens_ = qMin<double>(rate, tokens_ + tokenClock_.restart() * rate / 1000.0);
+    }
+
+    while (!pending_.isEmpty() && (rate <= 0 || tokens_ >= 1))
+    {
+        const Pending pending = pending_.takeFirst();
+        if (!pending.context)
+            continue;
+        if (rate > 0)
+            tokens_ -= 1;
+        QNetworkReply *reply = dispatch(pending);
+        pending.sent(reply);
+    }
+
+    if (!pending_.isEmpty() && !releaseTimer_.isActive())
+        releaseTimer_.start(qCeil((1 - tokens_) * 1000 / rate));
+}
+
+QNetworkReply *RequestScheduler::dispatch(const Pending &pending)
+{
+    ++stats_.requests;
+    QNetworkReply *reply;
+    if (pending.op == POST_OP)
+        reply = qnam_.post(pending.request, pending.data);
+    else
+        reply = qnam_.get(pending.request);
+    watchTimeout(reply);
+    return reply;
+}
+
+void RequestScheduler::watchTimeout(QNetworkReply *reply)
+{
+    const int timeout = config_.requestTimeout();
+    if (timeout <= 0)
+        return;
 
+    // Measured from the last activity, so that large downloads aren't cut off while still progressing.
+    QTimer *timer = new QTimer(reply);
+    timer->setSingleShot(true);
+    timer->start(timeout * 1000);
+    connect(reply, &QNetworkReply::downloadProgress, timer, [timer] { timer->start(); });
+    connect(reply, &QNetworkReply::uploadProgress, timer, [timer] { timer->start(); });
+    connect(reply, &QNetworkReply::finished, timer, &QTimer::stop);
+    connect(timer, &QTimer::timeout, this, [this, reply, timeout]
+    {
+        qCWarning(steamAPI).noquote() << reply->url().toString() << "Request timed out after" << timeout << "seconds without data";
+        ++stats_.timeouts;
+        reply->setProperty(timedOutProperty, true);
+        reply->abort();
+    });
+}
+
+//! Validates the outer structure of a GetPublishedFileDetails response and returns its publishedfiledetails entries.
+static bool parseFileDetailsResponse(const QByteArray rawData, const QString &debugContext, QJsonArray *fileDetails, QString *errorInfo = nullptr)
+{
     QJsonParseError errors;
     const QJsonDocument json = QJsonDocument::fromJson(rawData, &errors);
 
@@ -60,14 +286,14 @@ static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &d
         qCWarning(steamAPI).noquote() << debugContext << "Invalid response from Steam API:" << errors.errorString();
         if (errorInfo)
             *errorInfo = QStringLiteral("Invalid response from Steam API: %1").arg(errors.errorString());
-        return result;
+        return false;
     }
     if (!json.object().contains("response") && !json.object().value("response").isObject())
     {
         qCWarning(steamAPI).noquote() << debugContext << "Invalid response from Steam API: Not a JSON object.";
         if (errorInfo)
             *errorInfo = QStringLiteral("Invalid response from Steam API: Not a JSON object.");
-        return result;
+        return false;
     }
 
     const QJsonObject response = json.object().value("response").toObject();
@@ -76,11 +302,28 @@ static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &d
         qCWarning(steamAPI).noquote() << debugContext << "Steam API: No results.";
         if (errorInfo)
             *errorInfo = QStringLiteral("No results from Steam API.");
-        return result;
+        return false;
     }
-    assert(response.value("resultcount").toInt(0) >= 1);
-    const QJsonObject fileDetail = response.value("publishedfiledetails").toArray().at(0).toObject();
+    *fileDetails = response.value("publishedfiledetails").toArray();
+    return true;
+}
+
+//! Parses a single entry of a GetPublishedFileDetails response.
+static SteamModInfo parseFileDetail(const QJsonObject &fileDetail, const QString &debugContext, QString *errorInfo = nullptr)
+{
+    SteamModInfo result;
 
+    // Steam reports per-item failures (such as a deleted or private item) with a result code other than 1 (OK).
+    int resultCode = fileDetail.value("result").toInt(1);
+    if (resultCode != 1)
+    {
+        qCWarning(steamAPI).noquote() << debugContext << "Steam API: Item lookup failed with result" << resultCode;
+        if (errorInfo)
+            *errorInfo = resultCode == 9
+                    ? QStringLiteral("Mod not found on the Steam Workshop")
+                    : QStringLiteral("Steam API lookup failed: result %1").arg(resultCode);
+        return result;
+    }
     int appId = fileDetail.value("consumer_app_id").toInt();
     if (appId != 243970)
     {
@@ -103,6 +346,10 @@ static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &d
     QString description = fileDetail.value("description").toString();
     QString downloadUrl = fileDetail.value("file_url").toString();
     QDateTime lastUpdated = QDateTime::fromSecsSinceEpoch(fileDetail.value("time_updated").toInt(), Qt::UTC);
+    // 64-bit values are sent as strings.
+    bool hasFileSize;
+    qint64 fileSize = fileDetail.value("file_size").toVariant().toLongLong(&hasFileSize);
+    QString contentHandle = fileDetail.value("hcontent_file").toVariant().toString();
 
     if (workshopId.isEmpty())
     {
@@ -124,11 +371,35 @@ static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &d
     result.description = description;
     result.downloadUrl = downloadUrl;
     result.lastUpdated = lastUpdated;
+    result.fileSize = hasFileSize && fileSize > 0 ? fileSize : -1;
+    result.contentHandle = contentHandle;
     return result;
 }
 
-ModInfoCall::ModInfoCall(const ModManConfig &config, QNetworkAccessManager &qnam, QObject *parent)
-    : QObject(parent), config_(config), qnam_(qnam)
+static SteamModInfo parseSteamModInfo(const QByteArray rawData, const QString &debugContext, QString *errorInfo = nullptr)
+{
+    QJsonArray fileDetails;
+    if (!parseFileDetailsResponse(rawData, debugContext, &fileDetails, errorInfo))
+        return SteamModInfo();
+    return parseFileDetail(fileDetails.at(0).toObject(), debugContext, errorInfo);
+}
+
+static const QString getPublishedFileDetails = QStringLiteral("https://api.steampowered.com/ISteamRemoteStorage/GetPublishedFileDetails/v1/");
+
+static QNetworkRequest fileDetailsRequest(const QStringList &ids, QByteArray *postData)
+{
+    QNetworkRequest request(getPublishedFileDetails);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    QString data;
+    data.append(QStringLiteral("itemcount=%1").arg(ids.size()));
+    for (qsizetype i = 0; i < ids.size(); ++i)
+        data.append(QStringLiteral("&publishedfileids[%1]=%2").arg(i).arg(ids.at(i)));
+    *postData = data.toUtf8();
+    return request;
+}
+
+ModInfoCall::ModInfoCall(const ModManConfig &config, RequestScheduler &scheduler, QObject *parent)
+    : QObject(parent), config_(config), scheduler_(scheduler)
 {}
 
 void ModInfoCall::start(const QString &id)
@@ -136,66 +407,929 @@ void ModInfoCall::start(const QString &id)
     const QString callDebugInfo = QString("ModInfo(%1)").arg(id);
     id_ = id;
 
-    static const QString getPublishedFileDetails = QStringLiteral("https://api.steampowered.com/ISteamRemoteStorage/GetPublishedFileDetails/v1/");
-    QNetworkRequest request(getPublishedFileDetails);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-    QString postData;
-    postData.append("itemcount=1&");
-    postData.append("publishedfileids[0]=").append(id);
+    QByteArray postData;
+    QNetworkRequest request = fileDetailsRequest({id}, &postData);
 
     qCDebug(steamAPI).noquote() << callDebugInfo << "Request Start";
-    QNetworkReply *reply = qnam_.post(request, postData.toUtf8());
-    connect(reply, &QNetworkReply::finished, this, [this, callDebugInfo, reply]
+    scheduler_.sendWithRetry(RequestScheduler::POST_OP, request, postData, this, [this, callDebugInfo](QNetworkReply *reply)
     {
         qCDebug(steamAPI).noquote() << callDebugInfo << "Request End";
         result_ = parseSteamModInfo(reply->readAll(), callDebugInfo, &errorDetail_);
-        reply->deleteLater();
         emit finished();
     });
 }
 
-ModDownloadCall::ModDownloadCall(const ModManConfig &config, QNetworkAccessManager &qnam, ModCache &cache, QObject *parent)
-    : QObject(parent), config_(config), qnam_(qnam), cache_(cache)
+ModInfoBatchCall::ModInfoBatchCall(const ModManConfig &config, RequestScheduler &scheduler, SteamInfoCache &infoCache, QObject *parent)
+    : QObject(parent), config_(config), scheduler_(scheduler), infoCache_(infoCache), nextIndex_(0), doneCount_(0)
 {}
 
+void ModInfoBatchCall::start(const QStringList &ids)
+{
+    ids_ = ids;
+    results_ = QList<SteamModInfo>();
+    results_.reserve(ids.size());
+    errorDetails_ = QStringList();
+    errorDetails_.reserve(ids.size());
+    pendingIndexes_.clear();
+    for (qsizetype i = 0; i < ids.size(); ++i)
+    {
+        bool fresh;
+        SteamModInfo cached = infoCache_.get(ids.at(i), &fresh);
+        if (!fresh)
+        {
+            pendingIndexes_.append(i);
+            cached = SteamModInfo();
+        }
+        results_.append(cached);
+        errorDetails_.append(QString());
+    }
+    nextIndex_ = 0;
+    doneCount_ = ids.size() - pendingIndexes_.size();
+    qCDebug(steamAPI).noquote() << QString("ModInfoBatch(%1)").arg(ids.size()) << "Reused" << doneCount_ << "cached results";
+
+    if (pendingIndexes_.isEmpty())
+    {
+        QTimer::singleShot(0, this, [this]
+        {
+            emit progress(static_cast<int>(doneCount_));
+            emit finished();
+        });
+        return;
+    }
+    startBatch();
+}
+
+void ModInfoBatchCall::startBatch()
+{
+    const QList<qsizetype> batchIndexes = pendingIndexes_.mid(nextIndex_, qMax(1, config_.infoBatchSize()));
+    const QString callDebugInfo = QString("ModInfoBatch(%1-%2/%3)").arg(nextIndex_).arg(nextIndex_ + batchIndexes.size()).arg(pendingIndexes_.size());
+    nextIndex_ += batchIndexes.size();
+    QStringList batchIds;
+    batchIds.reserve(batchIndexes.size());
+    for (qsizetype index : batchIndexes)
+        batchIds.append(ids_.at(index));
+
+    QByteArray postData;
+    QNetworkRequest request = fileDetailsRequest(batchIds, &postData);
+    // Revalidate if an identical request was answered with validators before.
+    const QByteArray requestKey = QCryptographicHash::hash(postData, QCryptographicHash::Sha1).toHex();
+    QByteArray etag, lastModified;
+    if (infoCache_.requestValidators(requestKey, &etag, &lastModified))
+    {
+        if (!etag.isEmpty())
+            request.setRawHeader("If-None-Match", etag);
+        if (!lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", lastModified);
+    }
+
+    qCDebug(steamAPI).noquote() << callDebugInfo << "Request Start";
+    scheduler_.sendWithRetry(RequestScheduler::POST_OP, request, postData, this, [this, callDebugInfo, requestKey, batchIndexes](QNetworkReply *reply)
+    {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        qCDebug(steamAPI).noquote() << callDebugInfo << "Request End" << status;
+        if (status == 304)
+        {
+            // Unchanged since the cached results. Reuse them as if just fetched.
+            for (qsizetype index : batchIndexes)
+            {
+                infoCache_.touch(ids_.at(index));
+                results_[index] = infoCache_.get(ids_.at(index));
+                if (!results_.at(index).valid())
+                    errorDetails_[index] = QStringLiteral("No results from Steam API.");
+            }
+            batchFinished(batchIndexes.size());
+            return;
+        }
+
+        QJsonArray fileDetails;
+        QString batchError;
+        bool ok = false;
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            qCWarning(steamAPI).noquote() << callDebugInfo << "Request failed:" << reply->errorString();
+            batchError = QStringLiteral("Steam API request failed: %1").arg(reply->errorString());
+        }
+        else
+        {
+            ok = parseFileDetailsResponse(reply->readAll(), callDebugInfo, &fileDetails, &batchError);
+            if (ok)
+                infoCache_.setRequestValidators(requestKey, reply->rawHeader("ETag"), reply->rawHeader("Last-Modified"));
+        }
+
+        // Match entries by ID rather than relying on the response order.
+        QHash<QString, QJsonObject> detailsById;
+        for (const QJsonValue &value : qAsConst(fileDetails))
+        {
+            const QJsonObject fileDetail = value.toObject();
+            detailsById.insert(fileDetail.value("publishedfileid").toString(), fileDetail);
+        }
+        for (qsizetype index : batchIndexes)
+        {
+            const QString &id = ids_.at(index);
+            QString &errorDetail = errorDetails_[index];
+            auto it = detailsById.constFind(id);
+            if (it != detailsById.constEnd())
+            {
+                results_[index] = parseFileDetail(*it, QString("ModInfo(%1)").arg(id), &errorDetail);
+                infoCache_.insert(results_.at(index));
+            }
+            else if (!ok && infoCache_.get(id).valid())
+            {
+                // Steam couldn't be reached. The last known details are better than nothing.
+                qCDebug(steamAPI).noquote() << callDebugInfo << "Using stale cached result for" << id;
+                results_[index] = infoCache_.get(id);
+            }
+            else if (!batchError.isEmpty())
+                errorDetail = batchError;
+            else
+                errorDetail = QStringLiteral("No results from Steam API.");
+        }
+        batchFinished(batchIndexes.size());
+    });
+}
+
+void ModInfoBatchCall::batchFinished(qsizetype count)
+{
+    doneCount_ += count;
+    emit progress(static_cast<int>(doneCount_));
+    if (nextIndex_ < pendingIndexes_.size())
+        startBatch();
+    else
+    {
+        infoCache_.save();
+        emit finished();
+    }
+}
+
+qint64 DownloadMetrics::bytesPerSecond() const
+{
+    return transferMs > 0 ? bytes * 1000 / transferMs : 0;
+}
+
+QJsonObject DownloadMetrics::toJson() const
+{
+    QJsonObject json;
+    json["ok"] = ok;
+    json["linked"] = linked;
+    json["bytes"] = bytes;
+    json["firstByteMs"] = firstByteMs;
+    json["transferMs"] = transferMs;
+    json["bytesPerSecond"] = bytesPerSecond();
+    json["retries"] = retries;
+    json["extractMs"] = extractMs;
+    json["hashMs"] = hashMs;
+    return json;
+}
+
+void DownloadSummary::add(const DownloadMetrics &metrics)
+{
+    if (!metrics.ok)
+        ++failed;
+    else if (metrics.linked)
+        ++linked;
+    else
+        ++downloaded;
+    bytes += metrics.bytes;
+    retries += metrics.retries;
+    extractMs += metrics.extractMs;
+    hashMs += metrics.hashMs;
+}
+
+qint64 DownloadSummary::bytesPerSecond() const
+{
+    return elapsedMs > 0 ? bytes * 1000 / elapsedMs : 0;
+}
+
+QJsonObject DownloadSummary::toJson() const
+{
+    QJsonObject json;
+    json["downloaded"] = downloaded;
+    json["linked"] = linked;
+    json["failed"] = failed;
+    json["bytes"] = bytes;
+    json["elapsedMs"] = elapsedMs;
+    json["bytesPerSecond"] = bytesPerSecond();
+    json["retries"] = retries;
+    json["extractMs"] = extractMs;
+    json["hashMs"] = hashMs;
+    return json;
+}
+
+QString DownloadSummary::toString() const
+{
+    return QStringLiteral("%1 downloaded, %2 linked, %3 failed; %4 KiB in %5 s (%6 KiB/s); %7 retries; extract %8 ms, hash %9 ms")
+            .arg(downloaded).arg(linked).arg(failed)
+            .arg(bytes / 1024).arg(elapsedMs / 1000.0, 0, 'f', 1).arg(bytesPerSecond() / 1024)
+            .arg(retries).arg(extractMs).arg(hashMs);
+}
+
+//! Streamed bytes that may wait for the extraction thread before reading from the network pauses.
+static const qint64 maxQueuedStreamBytes = 8 * 1024 * 1024;
+//! Bytes a streamed reply may buffer while reading is paused.
+static const qint64 streamReadBufferSize = 1024 * 1024;
+
+ModDownloadCall::ModDownloadCall(const ModManConfig &config, RequestScheduler &scheduler, QThreadPool &extractPool, ModCache &cache, QObject *parent)
+    : QObject(parent), config_(config), scheduler_(scheduler), extractPool_(extractPool), cache_(cache),
+      sourceIndex_(0), active_(false), requestSerial_(0), reply_(nullptr), responseChecked_(false), streaming_(false), received_(0), expectedSize_(-1), retries_(0),
+      partialFile_(nullptr), queuedStreamBytes_(0), extractNsecs_(0), traceSpan_(std::make_unique<Tracing::Span>())
+{}
+
+ModDownloadCall::~ModDownloadCall() = default;
+
+static QString downloadDebugInfo(const SteamModInfo &info)
+{
+    return QString("ModDownload(%1,%2)").arg(info.id, info.lastUpdated.toString(Qt::ISODate));
+}
+
+//! Parses a "bytes first-last/total" Content-Range header. Total is -1 if the server didn't report it.
+static bool parseContentRange(const QByteArray &header, qint64 *first, qint64 *total)
+{
+    static const QRegularExpression re(QStringLiteral("^bytes (\\d+)-(\\d+)/(\\d+|\\*)$"));
+    const QRegularExpressionMatch match = re.match(QString::fromLatin1(header.trimmed()));
+    if (!match.hasMatch())
+        return false;
+    *first = match.captured(1).toLongLong();
+    *total = match.captured(3) == QLatin1String("*") ? -1 : match.captured(3).toLongLong();
+    return true;
+}
+
+//! Parses the "bytes */total" Content-Range header of a 416 response. Returns -1 if it's missing or malformed.
+static qint64 parseUnsatisfiedRange(const QByteArray &header)
+{
+    static const QRegularExpression re(QStringLiteral("^bytes \\*/(\\d+)$"));
+    const QRegularExpressionMatch match = re.match(QString::fromLatin1(header.trimmed()));
+    return match.hasMatch() ? match.captured(1).toLongLong() : -1;
+}
+
+//! Validator for an If-Range header, which only accepts strong ETags and dates.
+static QByteArray rangeValidator(QNetworkReply *reply)
+{
+    const QByteArray etag = reply->rawHeader("ETag");
+    if (!etag.isEmpty() && !etag.startsWith("W/"))
+        return etag;
+    return reply->rawHeader("Last-Modified");
+}
+
+//! Where a mirror keeps the zip for the given mod version: {mirror}/{workshopId}-{timeUpdated}.zip
+//! Mirrors may be local folders or HTTP(S) base URLs.
+static QUrl mirrorUrl(const QString &mirror, const SteamModInfo &info)
+{
+    const QString fileName = QStringLiteral("%1-%2.zip").arg(info.id).arg(info.lastUpdated.toSecsSinceEpoch());
+    if (QDir::isAbsolutePath(mirror))
+        return QUrl::fromLocalFile(QDir(mirror).filePath(fileName));
+
+    QUrl url(mirror);
+    QString path = url.path();
+    if (!path.endsWith('/'))
+        path.append('/');
+    url.setPath(path + fileName);
+    return url;
+}
+
+QList<QUrl> ModDownloadCall::sources(const ModManConfig &config, const SteamModInfo &info, QStringList *invalidMirrors)
+{
+    // Configured mirrors first, then Steam.
+    QList<QUrl> result;
+    if (info.lastUpdated.isValid())
+    {
+        const QStringList mirrors = config.downloadMirrors();
+        for (const QString &mirror : mirrors)
+        {
+            const QUrl url = mirrorUrl(mirror, info);
+            if (url.isValid())
+                result.append(url);
+            else if (invalidMirrors)
+                invalidMirrors->append(mirror);
+        }
+    }
+    result.append(QUrl(info.downloadUrl));
+    return result;
+}
+
 void ModDownloadCall::start(const SteamModInfo &info)
 {
-    const QString callDebugInfo = QString("ModDownload(%1,%2)").arg(info.id, info.lastUpdated.toString(Qt::ISODate));
     info_ = info;
+    resultVersionId_.clear();
+    errorDetail_.clear();
+    retries_ = 0;
+    active_ = true;
+    metrics_ = DownloadMetrics();
+    extractNsecs_ = 0;
+    metricsTimer_.start();
+    if (Tracing::enabled)
+        traceSpan_->begin("steamapi", "download", downloadDebugInfo(info_), Tracing::Span::ASYNC);
+
+    QStringList invalidMirrors;
+    sources_ = sources(config_, info_, &invalidMirrors);
+    for (const QString &mirror : qAsConst(invalidMirrors))
+        qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << "Ignoring invalid mirror:" << mirror;
+    sourceIndex_ = 0;
+    rangeValidator_.clear();
 
-    QTemporaryFile *zipFile = new QTemporaryFile(this);
-    if (!zipFile->open())
+    if (const CachedVersion *existing = cache_.versionWithContent(info_))
+        startLinked(existing->path());
+    else
+        startDownload();
+}
+
+void ModDownloadCall::startDownload()
+{
+    // Streaming starts from zero, so continue a zip left partly downloaded by an earlier session from the file instead.
+    const QFileInfo partialInfo(partialFilePath());
+    if (config_.downloadStreaming() && !(partialInfo.isFile() && partialInfo.size() > 0))
+        startStreamed();
+    else
+        startSpooled();
+}
+
+void ModDownloadCall::startLinked(const QString &sourcePath)
+{
+    // The timestamp changed, but the zip didn't. Reuse the files already extracted from it.
+    qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Content unchanged. Linking from" << sourcePath;
+    streaming_ = false;
+    metrics_.linked = true;
+    stagingPath_ = FileUtils::createStagingDir(config_.cachePath(), &errorDetail_);
+    if (stagingPath_.isNull())
     {
-        qFatal("%s Failed to create temporary file", callDebugInfo.toUtf8().constData());
+        active_ = false;
+        finishMetrics(false);
+        QTimer::singleShot(0, this, &ModDownloadCall::finished);
+        return;
     }
 
-    qCDebug(steamAPI).noquote() << callDebugInfo << "Request Start";
-    QNetworkRequest request(info.downloadUrl);
-    QNetworkReply *reply = qnam_.get(request);
-    connect(reply, &QIODevice::readyRead, this, [zipFile, callDebugInfo, reply]
+    extractPool_.start([this, sourcePath, stagingPath = stagingPath_]
     {
-        QByteArray data = reply->readAll();
-        qCDebug(steamAPI).noquote() << callDebugInfo << "Chunk Update" << data.size() << "bytes";
-        zipFile->write(data);
+        ExtractResult result;
+        QElapsedTimer timer;
+        timer.start();
+        result.ok = FileUtils::linkRecursively(sourcePath, stagingPath, &result.errorInfo);
+        extractNsecs_ += timer.nsecsElapsed();
+        if (result.ok)
+            hashExtracted(stagingPath, &result);
+        QMetaObject::invokeMethod(this, [this, result]
+        {
+            if (result.ok)
+            {
+                extractFinished(result);
+                return;
+            }
+            qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << "Linking failed, downloading instead:" << result.errorInfo;
+            metrics_.linked = false;
+            discardStaging();
+            startDownload();
+        }, Qt::QueuedConnection);
     });
+}
 
-    connect(reply, &QNetworkReply::finished, this, [this, info, zipFile, callDebugInfo, reply]
+QString ModDownloadCall::partialFilePath() const
+{
+    const QString fileName = QStringLiteral("%1-%2.zip.part").arg(info_.id).arg(info_.lastUpdated.toSecsSinceEpoch());
+    return QDir(config_.cachePath()).filePath(FileUtils::partialDirName + '/' + fileName);
+}
+
+void ModDownloadCall::startStreamed()
+{
+    streaming_ = true;
+    stagingPath_ = FileUtils::createStagingDir(config_.cachePath(), &errorDetail_);
+    if (stagingPath_.isNull())
     {
-        QByteArray data = reply->readAll();
-        qCDebug(steamAPI).noquote() << callDebugInfo << "Request End" << data.size() << "bytes";
-        zipFile->write(reply->readAll());
-        reply->deleteLater();
+        active_ = false;
+        finishMetrics(false);
+        QTimer::singleShot(0, this, &ModDownloadCall::finished);
+        return;
+    }
+
+    // Chunks are extracted in the order they arrive, as the extraction pool has a single thread.
+    extractor_ = std::make_shared<ZipStreamExtractor>(stagingPath_);
+    received_ = 0;
+    expectedSize_ = -1;
+
+    // Also saved, so that the download can continue from the file if the zip turns out not to be streamable.
+    delete partialFile_;
+    const QString partialPath = partialFilePath();
+    partialFile_ = new QFile(partialPath);
+    if (!QDir().mkpath(QFileInfo(partialPath).absolutePath()) || !partialFile_->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Not saving streamed download:" << partialFile_->errorString();
+        delete partialFile_;
+        partialFile_ = nullptr;
+    }
+    sendRequest();
+}
+
+void ModDownloadCall::startSpooled()
+{
+    streaming_ = false;
+    stagingPath_ = FileUtils::createStagingDir(config_.cachePath(), &errorDetail_);
+    if (stagingPath_.isNull())
+    {
+        active_ = false;
+        finishMetrics(false);
+        QTimer::singleShot(0, this, &ModDownloadCall::finished);
+        return;
+    }
+
+    const QString partialPath = partialFilePath();
+    partialFile_ = new QFile(partialPath);
+    if (!QDir().mkpath(QFileInfo(partialPath).absolutePath()) || !partialFile_->open(QIODevice::ReadWrite))
+    {
+        const QString errorInfo = QStringLiteral("Failed to open %1: %2").arg(partialPath, partialFile_->errorString());
+        qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << errorInfo;
+        QTimer::singleShot(0, this, [this, errorInfo] { finishWithError(errorInfo); });
+        return;
+    }
+
+    // Continue where an earlier attempt left off, possibly in a previous session.
+    received_ = partialFile_->size();
+    partialFile_->seek(received_);
+    expectedSize_ = -1;
+    if (received_ > 0)
+        qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Resuming partial download at" << received_ << "bytes";
+    sendRequest();
+}
+
+void ModDownloadCall::sendRequest()
+{
+    const QString callDebugInfo = downloadDebugInfo(info_);
+    const QUrl &source = sources_.at(sourceIndex_);
+    qCDebug(steamAPI).noquote() << callDebugInfo << "Request Start" << (streaming_ ? "(streamed)" : "(to file)") << source.toString() << "from" << received_;
+
+    QNetworkRequest request(source);
+    if (received_ > 0)
+    {
+        request.setRawHeader("Range", QByteArray("bytes=") + QByteArray::number(received_) + '-');
+        // If the zip changed since, the server sends all of it instead, and checkResponse starts over.
+        if (!rangeValidator_.isEmpty())
+            request.setRawHeader("If-Range", rangeValidator_);
+    }
+    const quint64 serial = ++requestSerial_;
+    reply_ = nullptr;
+    responseChecked_ = false;
+    scheduler_.send(RequestScheduler::GET_OP, request, QByteArray(), this, [this, serial](QNetworkReply *reply)
+    {
+        connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+        if (requestSerial_ != serial || !active_)
+        {
+            // Abandoned while waiting to be sent.
+            reply->abort();
+            return;
+        }
+
+        reply_ = reply;
+        if (streaming_)
+        {
+            // Bounds what the reply buffers while reading is paused for the extraction thread.
+            reply->setReadBufferSize(streamReadBufferSize);
+        }
+        connect(reply, &QIODevice::readyRead, this, [this, reply]
+        {
+            if (reply_ == reply)
+                receive(reply);
+        });
+        connect(reply, &QNetworkReply::finished, this, [this, reply]
+        {
+            if (reply_ == reply)
+                receive(reply, true);
+            // Receiving may have replaced or aborted the request.
+            if (reply_ == reply)
+            {
+                reply_ = nullptr;
+                requestFinished(reply);
+            }
+        });
+    });
+}
+
+bool ModDownloadCall::checkResponse(QNetworkReply *reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status >= 300 || (status == 0 && reply->error() != QNetworkReply::NoError))
+        return false;  // Handled once the request finishes.
 
-        zipFile->seek(0);
-        const CachedVersion *v = cache_.addZipVersion(info_, *zipFile, &errorDetail_);
-        if (v)
-            resultVersionId_ = v->id();
+    if (status == 206)
+    {
+        qint64 first, total;
+        if (parseContentRange(reply->rawHeader("Content-Range"), &first, &total) && first == received_)
+        {
+            expectedSize_ = total;
+            return true;
+        }
+        qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << "Unexpected range in response:" << reply->rawHeader("Content-Range");
+    }
+    else
+    {
+        bool ok;
+        const qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+        expectedSize_ = ok ? length : -1;
+        if (received_ == 0)
+            return true;
+    }
+
+    // The server sent something other than the requested range, so start again from the beginning.
+    qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Server didn't resume the download. Restarting.";
+    if (!streaming_)
+    {
+        partialFile_->resize(0);
+        partialFile_->seek(0);
+        received_ = 0;
+        if (status != 206)
+            return true;
+
+        abortRequest();
+        if (++retries_ > scheduler_.maxRetries())
+            finishWithError(QStringLiteral("Server responded with an unexpected range."));
         else
-            resultVersionId_.clear();
-        zipFile->deleteLater();
+        {
+            scheduler_.recordRetry();
+            ++metrics_.retries;
+            sendRequest();
+        }
+        return false;
+    }
 
-        emit finished();
+    // Extraction has already consumed the earlier data, so the stream can't start over.
+    abortRequest();
+    discardStaging();
+    if (++retries_ > scheduler_.maxRetries())
+        finishWithError(QStringLiteral("Download was interrupted, and the server doesn't support resuming."));
+    else
+    {
+        scheduler_.recordRetry();
+        ++metrics_.retries;
+        startStreamed();
+    }
+    return false;
+}
+
+void ModDownloadCall::receive(QNetworkReply *reply, bool isFinished)
+{
+    if (!responseChecked_)
+    {
+        if (!checkResponse(reply) || !checkListedSize())
+        {
+            // Discard the body of an error response, or of an abandoned request.
+            reply->readAll();
+            return;
+        }
+        responseChecked_ = true;
+        rangeValidator_ = rangeValidator(reply);
+    }
+    // Resumed once the extraction thread catches up. Meanwhile the reply's limited buffer pauses the transfer.
+    if (streaming_ && !isFinished && queuedStreamBytes_ >= maxQueuedStreamBytes)
+        return;
+
+    const QByteArray data = reply->readAll();
+    if (data.isEmpty())
+        return;
+    qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Chunk Update" << data.size() << "bytes";
+    if (metrics_.firstByteMs < 0)
+        metrics_.firstByteMs = metricsTimer_.elapsed();
+    metrics_.bytes += data.size();
+    received_ += data.size();
+    const qint64 total = expectedTotal();
+    if (total >= 0 && received_ > total)
+    {
+        const QString errorInfo = QStringLiteral("Download is larger than expected: %1 of %2 bytes").arg(received_).arg(total);
+        qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << errorInfo;
+        abortRequest();
+        sourceFailed(errorInfo, true);
+        return;
+    }
+    emit progress(received_, total);
+
+    if (streaming_)
+    {
+        streamChunk(extractor_, data);
+        if (partialFile_ && partialFile_->write(data) != data.size())
+        {
+            // Only needed if streaming fails, so carry on without it.
+            qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Not saving streamed download:" << partialFile_->errorString();
+            partialFile_->remove();
+            delete partialFile_;
+            partialFile_ = nullptr;
+        }
+    }
+    else if (partialFile_->write(data) != data.size())
+    {
+        const QString errorInfo = QStringLiteral("Failed to write %1: %2").arg(partialFile_->fileName(), partialFile_->errorString());
+        abortRequest();
+        finishWithError(errorInfo);
+    }
+}
+
+void ModDownloadCall::requestFinished(QNetworkReply *reply)
+{
+    const QString callDebugInfo = downloadDebugInfo(info_);
+    qCDebug(steamAPI).noquote() << callDebugInfo << "Request End" << received_ << "bytes";
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // A saved download that already has every byte, such as one interrupted just before it was extracted.
+    const bool alreadyComplete = status == 416 && !streaming_ && received_ > 0
+            && parseUnsatisfiedRange(reply->rawHeader("Content-Range")) == received_
+            && (info_.fileSize < 0 || info_.fileSize == received_);
+    if (alreadyComplete)
+    {
+        qCDebug(steamAPI).noquote() << callDebugInfo << "Partial download was already complete";
+        expectedSize_ = received_;
+    }
+    else if (reply->error() != QNetworkReply::NoError)
+    {
+        const bool staleRange = status == 416 && !streaming_ && received_ > 0;
+        if ((staleRange || scheduler_.isRetryable(reply)) && retries_ < scheduler_.maxRetries())
+        {
+            ++retries_;
+            scheduler_.recordRetry();
+            ++metrics_.retries;
+            if (staleRange)
+            {
+                // The saved partial download doesn't match what the server has.
+                qCWarning(steamAPI).noquote() << callDebugInfo << "Discarding partial download that the server can't resume";
+                partialFile_->resize(0);
+                partialFile_->seek(0);
+                received_ = 0;
+            }
+            else
+                qCWarning(steamAPI).noquote() << callDebugInfo << "Request interrupted at" << received_ << "bytes, resuming:" << reply->errorString();
+            const quint64 serial = requestSerial_;
+            QTimer::singleShot(scheduler_.retryDelay(retries_, reply), this, [this, serial]
+            {
+                if (active_ && requestSerial_ == serial)
+                    sendRequest();
+            });
+            return;
+        }
+
+        qCWarning(steamAPI).noquote() << callDebugInfo << "Request Failed:" << sources_.at(sourceIndex_).toString() << reply->errorString();
+        // Kept on disk for a later session to resume. The next source starts from the beginning.
+        sourceFailed(reply->errorString(), false);
+        return;
+    }
+
+    // Rejects a truncated download before it's extracted.
+    if (expectedTotal() >= 0 && received_ != expectedTotal())
+    {
+        const QString errorInfo = QStringLiteral("Download size mismatch: received %1 of %2 bytes").arg(received_).arg(expectedTotal());
+        qCWarning(steamAPI).noquote() << callDebugInfo << errorInfo;
+        sourceFailed(errorInfo, true);
+        return;
+    }
+
+    metrics_.transferMs = metricsTimer_.elapsed();
+    if (streaming_)
+    {
+        // The saved copy is only needed if streaming fails partway.
+        if (partialFile_)
+        {
+            partialFile_->remove();
+            delete partialFile_;
+            partialFile_ = nullptr;
+        }
+        auto extractor = extractor_;
+        extractPool_.start([this, extractor, stagingPath = stagingPath_]
+        {
+            ExtractResult result;
+            QElapsedTimer timer;
+            timer.start();
+            result.ok = extractor->finish(&result.errorInfo);
+            extractNsecs_ += timer.nsecsElapsed();
+            if (result.ok)
+                hashExtracted(stagingPath, &result);
+            QMetaObject::invokeMethod(this, [this, extractor, result]
+            {
+                // Ignore if an interruption already replaced this attempt.
+                if (extractor_ == extractor)
+                    extractFinished(result);
+            }, Qt::QueuedConnection);
+        });
+        return;
+    }
+
+    // Extract on the worker thread, so that other transfers can continue meanwhile.
+    QFile *zipFile = partialFile_;
+    partialFile_ = nullptr;
+    const QString stagingPath = stagingPath_;
+    extractPool_.start([this, zipFile, stagingPath]
+    {
+        ExtractResult result;
+        QElapsedTimer timer;
+        timer.start();
+        result.ok = ModCache::extractZip(*zipFile, stagingPath, &result.errorInfo);
+        extractNsecs_ += timer.nsecsElapsed();
+        // Either extracted, or corrupt and not worth resuming.
+        zipFile->remove();
+        delete zipFile;
+        if (result.ok)
+            hashExtracted(stagingPath, &result);
+        QMetaObject::invokeMethod(this, [this, result] { extractFinished(result); }, Qt::QueuedConnection);
+    });
+}
+
+qint64 ModDownloadCall::expectedTotal() const
+{
+    return expectedSize_ >= 0 ? expectedSize_ : info_.fileSize;
+}
+
+bool ModDownloadCall::checkListedSize()
+{
+    if (info_.fileSize < 0 || expectedSize_ < 0 || expectedSize_ == info_.fileSize)
+        return true;
+
+    const QString errorInfo = QStringLiteral("Server is sending %1 bytes, but Steam lists %2 bytes").arg(expectedSize_).arg(info_.fileSize);
+    qCWarning(steamAPI).noquote() << downloadDebugInfo(info_) << errorInfo << "from" << sources_.at(sourceIndex_).toString();
+    abortRequest();
+    sourceFailed(errorInfo, true);
+    return false;
+}
+
+void ModDownloadCall::sourceFailed(const QString &errorInfo, bool discardReceived)
+{
+    if (sourceIndex_ + 1 >= sources_.size())
+    {
+        if (discardReceived && partialFile_)
+            partialFile_->remove();
+        finishWithError(errorInfo);
+        return;
+    }
+
+    ++sourceIndex_;
+    retries_ = 0;
+    expectedSize_ = -1;
+    rangeValidator_.clear();
+    emit sourceChanged(sources_.at(sourceIndex_));
+    // Sources may hold different builds of the same version, so only a complete zip from one source is trusted.
+    if (received_ == 0)
+        sendRequest();
+    else if (streaming_)
+    {
+        discardStaging();
+        startStreamed();
+    }
+    else
+    {
+        partialFile_->resize(0);
+        partialFile_->seek(0);
+        received_ = 0;
+        sendRequest();
+    }
+}
+
+void ModDownloadCall::abortRequest()
+{
+    // Also abandons a request still waiting to be sent.
+    ++requestSerial_;
+    if (reply_)
+    {
+        QNetworkReply *reply = reply_;
+        reply_ = nullptr;
+        reply->abort();
+    }
+}
+
+void ModDownloadCall::streamChunk(const std::shared_ptr<ZipStreamExtractor> &extractor, const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+    queuedStreamBytes_ += data.size();
+    extractPool_.start([this, extractor, data]
+    {
+        // Once stopped, the rest of the download is ignored. Only the chunk that stopped it reports back.
+        if (extractor->state() == ZipStreamExtractor::READING)
+        {
+            QElapsedTimer timer;
+            timer.start();
+            ZipStreamExtractor::State state = extractor->write(data);
+            extractNsecs_ += timer.nsecsElapsed();
+            if (state == ZipStreamExtractor::UNSUPPORTED || state == ZipStreamExtractor::FAILED)
+            {
+                const bool unsupported = state == ZipStreamExtractor::UNSUPPORTED;
+                const QString errorInfo = extractor->errorDetail();
+                QMetaObject::invokeMethod(this, [this, extractor, unsupported, errorInfo]
+                {
+                    streamInterrupted(extractor, unsupported, errorInfo);
+                }, Qt::QueuedConnection);
+            }
+        }
+
+        const qint64 queued = queuedStreamBytes_ -= data.size();
+        if (queued < maxQueuedStreamBytes && queued + data.size() >= maxQueuedStreamBytes)
+        {
+            QMetaObject::invokeMethod(this, [this]
+            {
+                if (reply_)
+                    receive(reply_);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void ModDownloadCall::streamInterrupted(const std::shared_ptr<ZipStreamExtractor> &extractor, bool unsupported, const QString &errorInfo)
+{
+    if (extractor_ != extractor)
+        return;
+
+    abortRequest();
+
+    if (unsupported)
+    {
+        // The zip needs random access. Finish downloading it to a file instead, continuing from the saved bytes.
+        qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Streaming not possible:" << errorInfo;
+        discardStaging();
+        delete partialFile_;
+        partialFile_ = nullptr;
+        startSpooled();
+    }
+    else
+        finishWithError(errorInfo);
+}
+
+void ModDownloadCall::discardStaging()
+{
+    extractor_.reset();
+    if (stagingPath_.isNull())
+        return;
+
+    // Queued behind any extraction still writing to the folder.
+    extractPool_.start([stagingPath = stagingPath_, trashRoot = config_.cachePath()]
+    {
+        FileUtils::discardStagingDir(stagingPath, trashRoot);
     });
+    stagingPath_.clear();
+}
+
+void ModDownloadCall::finishWithError(const QString &errorInfo)
+{
+    active_ = false;
+    errorDetail_ = errorInfo;
+    resultVersionId_.clear();
+    discardStaging();
+    // Keep any partial download on disk, so that a later attempt can resume it.
+    delete partialFile_;
+    partialFile_ = nullptr;
+
+    // Report once the extraction thread is done with this call's earlier tasks, which refer back to it.
+    extractPool_.start([this]
+    {
+        QMetaObject::invokeMethod(this, [this]
+        {
+            finishMetrics(false);
+            emit finished();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ModDownloadCall::hashExtracted(const QString &stagingPath, ExtractResult *result)
+{
+    ModSignature::Stats stats;
+    QElapsedTimer timer;
+    timer.start();
+    result->hash = ModSignature::hashModPath(stagingPath, &stats);
+    result->hashMs = timer.elapsed();
+    result->hashBytes = stats.bytes;
+    result->hashFiles = stats.files;
+}
+
+void ModDownloadCall::extractFinished(const ExtractResult &result)
+{
+    active_ = false;
+    metrics_.hashMs = result.hashMs;
+    const CachedVersion *v = nullptr;
+    if (result.ok)
+    {
+        ModSignature::Stats stats;
+        stats.bytes = result.hashBytes;
+        stats.files = result.hashFiles;
+        v = cache_.addStagedVersion(info_, stagingPath_, &errorDetail_, result.hash, &stats);
+        if (!result.hash.isEmpty())
+            cache_.recordThroughput(ModCache::HASH_THROUGHPUT, result.hashBytes, result.hashMs);
+    }
+    else
+        errorDetail_ = result.errorInfo;
+
+    if (v)
+    {
+        resultVersionId_ = v->id();
+        extractor_.reset();
+        stagingPath_.clear();
+    }
+    else
+    {
+        resultVersionId_.clear();
+        discardStaging();
+    }
+
+    finishMetrics(v != nullptr);
+    emit finished();
+}
+
+void ModDownloadCall::finishMetrics(bool ok)
+{
+    metrics_.ok = ok;
+    if (!ok)
+        metrics_.transferMs = metricsTimer_.elapsed();
+    metrics_.extractMs = extractNsecs_ / 1000000;
+    traceSpan_->end();
+    qCDebug(steamAPI).noquote() << downloadDebugInfo(info_) << "Metrics"
+                                << QJsonDocument(metrics_.toJson()).toJson(QJsonDocument::Compact);
 }
 
 const CachedVersion *ModDownloadCall::resultVersion() const
@@ -206,6 +1340,117 @@ const CachedVersion *ModDownloadCall::resultVersion() const
    return nullptr;
 }
 
+//! Groups sources for the per-host limit. Local mirror folders share a group of their own.
+static QString hostKey(const QUrl &url)
+{
+    return url.isLocalFile() ? QStringLiteral("file://") : url.host();
+}
+
+ModDownloadQueue::ModDownloadQueue(ModDownloader &downloader, ModCache &cache, QObject *parent)
+    : QObject(parent), downloader_(downloader), cache_(cache), nextReport_(0), activeCount_(0)
+{}
+
+void ModDownloadQueue::start(const QList<SteamModInfo> &infos)
+{
+    results_.clear();
+    results_.reserve(infos.size());
+    pending_.clear();
+    pending_.reserve(infos.size());
+    nextReport_ = 0;
+    summary_ = DownloadSummary();
+    timer_.start();
+    for (const SteamModInfo &info : infos)
+    {
+        pending_.append(results_.size());
+        Result result;
+        result.info = info;
+        result.host = hostKey(ModDownloadCall::sources(downloader_.config(), info).first());
+        results_.append(result);
+    }
+
+    if (results_.isEmpty())
+    {
+        // Use a single-shot timer in case the event loop hasn't started yet.
+        QTimer::singleShot(0, this, &ModDownloadQueue::finished);
+        return;
+    }
+    startPending();
+}
+
+const CachedVersion *ModDownloadQueue::resultVersion(int index) const
+{
+    const Result &result = results_.at(index);
+    const CachedMod *m = cache_.mod(result.info.modId());
+    if (m && !result.versionId.isEmpty())
+        return m->version(result.versionId);
+    return nullptr;
+}
+
+void ModDownloadQueue::startPending()
+{
+    const int maxActive = qMax(1, downloader_.config().downloadConcurrency());
+    const int maxPerHost = qMax(1, downloader_.config().downloadHostConcurrency());
+
+    auto it = pending_.begin();
+    while (it != pending_.end() && activeCount_ < maxActive)
+    {
+        const int index = *it;
+        const QString &host = results_.at(index).host;
+        if (activeHostCounts_.value(host) >= maxPerHost)
+        {
+            // Leave it queued, but let mods from other hosts go ahead.
+            ++it;
+            continue;
+        }
+        it = pending_.erase(it);
+
+        ++activeCount_;
+        ++activeHostCounts_[host];
+        ModDownloadCall *call = downloader_.modDownloadCall(cache_);
+        call->setParent(this);
+        connect(call, &ModDownloadCall::finished, this, [this, call, index] { callFinished(call, index); });
+        connect(call, &ModDownloadCall::progress, this, [this, index](qint64 received, qint64 total) { emit downloadProgress(index, received, total); });
+        connect(call, &ModDownloadCall::sourceChanged, this, [this, index](const QUrl &source) {
+            // Counts against the new host from now on, even if that's already at its limit.
+            Result &result = results_[index];
+            releaseHost(result.host);
+            result.host = hostKey(source);
+            ++activeHostCounts_[result.host];
+        });
+        call->start(results_.at(index).info);
+    }
+}
+
+void ModDownloadQueue::releaseHost(const QString &host)
+{
+    if (--activeHostCounts_[host] <= 0)
+        activeHostCounts_.remove(host);
+}
+
+void ModDownloadQueue::callFinished(ModDownloadCall *call, int index)
+{
+    Result &result = results_[index];
+    result.versionId = call->resultVersionId();
+    result.errorDetail = call->errorDetail();
+    result.metrics = call->metrics();
+    result.done = true;
+    summary_.add(result.metrics);
+    summary_.elapsedMs = timer_.elapsed();
+    call->deleteLater();
+
+    --activeCount_;
+    releaseHost(result.host);
+
+    startPending();
+    emit summaryChanged();
+    emit downloadCompleted(index);
+
+    while (nextReport_ < results_.size() && results_.at(nextReport_).done)
+        emit downloadFinished(nextReport_++);
+    if (nextReport_ >= results_.size())
+        emit finished();
+}
+
 ApplicationVersionCall::ApplicationVersionCall(QNetworkAccessManager &qnam, QObject *parent)
     : QObject(parent), qnam_(qnam)
 {}
@@ -7,13 +7,30 @@
 #include <QLoggingCategory>
 #include <QObject>
 #include <QNetworkAccessManager>
+#include <QNetworkRequest>
 #include <QDateTime>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <atomic>
+#include <functional>
+#include <memory>
 
 
 namespace iimodmanager {
 
 class CachedVersion;
 class ModCache;
+class SteamInfoCache;
+namespace Tracing {
+class Span;
+}
+class ZipStreamExtractor;
 
 Q_DECLARE_LOGGING_CATEGORY(steamAPI)
 
@@ -25,31 +42,165 @@ struct IIMODMANLIBSHARED_EXPORT SteamModInfo
     QString description;
     QString downloadUrl;
     QDateTime lastUpdated;
+    //! Size of the zip in bytes, or -1 if unknown.
+    qint64 fileSize = -1;
+    //! Steam's handle for the zip's content. Changes whenever the zip does.
+    QString contentHandle;
 
     inline const QString modId() const { return QStringLiteral("workshop-%1").arg(id); };
     inline bool valid() const { return !id.isEmpty(); };
 };
 
+//! Measurements of a single mod download, from the first request until the version is in the cache.
+struct IIMODMANLIBSHARED_EXPORT DownloadMetrics
+{
+    //! Milliseconds from starting the download until the first byte of the zip arrived, or -1 if none did.
+    qint64 firstByteMs = -1;
+    //! Milliseconds from starting the download until the last byte of the zip arrived, including retries.
+    qint64 transferMs = 0;
+    //! Bytes of zip data received, including any that were discarded and received again.
+    qint64 bytes = 0;
+    int retries = 0;
+    //! Milliseconds spent extracting, or linking the files of an identical version.
+    //! Streamed extraction overlaps the transfer, so this is the time the extraction thread was busy.
+    qint64 extractMs = 0;
+    //! Milliseconds spent hashing the extracted files.
+    qint64 hashMs = 0;
+    //! Set if the files were linked from an identical version instead of downloaded.
+    bool linked = false;
+    bool ok = false;
+
+    //! Transfer rate, or 0 if nothing was received.
+    qint64 bytesPerSecond() const;
+    QJsonObject toJson() const;
+};
+
+//! Totals across the downloads of a ModDownloadQueue.
+struct IIMODMANLIBSHARED_EXPORT DownloadSummary
+{
+    int downloaded = 0;
+    int linked = 0;
+    int failed = 0;
+    qint64 bytes = 0;
+    int retries = 0;
+    //! Milliseconds from starting the queue until the latest download finished.
+    //! Transfers run concurrently, so this may be less than the sum of their times.
+    qint64 elapsedMs = 0;
+    qint64 extractMs = 0;
+    qint64 hashMs = 0;
+
+    void add(const DownloadMetrics &metrics);
+    //! Overall transfer rate across the elapsed time, or 0 if nothing was received.
+    qint64 bytesPerSecond() const;
+    QJsonObject toJson() const;
+    QString toString() const;
+};
+
 class ModInfoCall;
+class ModInfoBatchCall;
 class ModDownloadCall;
+class ModDownloadQueue;
 class ApplicationVersionCall;
 
+//! Sends the network requests of ModDownloader's calls.
+//! Limits the overall request rate, aborts requests that stall, and retries transient failures with
+//! exponential backoff, as configured in ModManConfig.
+class IIMODMANLIBSHARED_EXPORT RequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation
+    {
+        GET_OP,
+        POST_OP,
+    };
+    //! Totals since the scheduler was created.
+    struct Stats
+    {
+        int requests = 0;
+        int retries = 0;
+        int timeouts = 0;
+        //! Requests that had to wait for the rate limit.
+        int throttled = 0;
+
+        Stats operator-(const Stats &other) const;
+        QString toString() const;
+    };
+
+    RequestScheduler(const ModManConfig &config, QNetworkAccessManager &qnam, QObject *parent = nullptr);
+
+    //! Sends a single attempt once the rate limit allows, and passes the new reply to the callback.
+    //! The callback is skipped if the context is destroyed first. The caller is responsible for deleting the reply.
+    void send(Operation op, const QNetworkRequest &request, const QByteArray &data, QObject *context, std::function<void(QNetworkReply *)> sent);
+    //! Sends a request, retrying transient failures. Passes the final reply to the callback once it's finished.
+    //! The reply is deleted after the callback returns.
+    void sendWithRetry(Operation op, const QNetworkRequest &request, const QByteArray &data, QObject *context, std::function<void(QNetworkReply *)> finished);
+
+    //! True if the finished reply failed in a way that may succeed if retried.
+    bool isRetryable(QNetworkReply *reply) const;
+    int maxRetries() const;
+    //! Milliseconds to wait before the given retry, counting from 1. Respects the reply's Retry-After header, if any.
+    int retryDelay(int retry, QNetworkReply *reply = nullptr) const;
+    //! Counts a retry made by a caller that handles its own retries.
+    inline void recordRetry() { ++stats_.retries; };
+
+    inline const Stats &stats() const { return stats_; };
+
+private:
+    struct Pending
+    {
+        Operation op;
+        QNetworkRequest request;
+        QByteArray data;
+        QPointer<QObject> context;
+        std::function<void(QNetworkReply *)> sent;
+    };
+
+    const ModManConfig &config_;
+    QNetworkAccessManager &qnam_;
+    //! Requests waiting for the rate limit, in order.
+    QList<Pending> pending_;
+    QTimer releaseTimer_;
+    //! Token bucket for the rate limit. Refilled continuously up to one second's worth of requests.
+    double tokens_;
+    QElapsedTimer tokenClock_;
+    Stats stats_;
+
+    void releasePending();
+    QNetworkReply *dispatch(const Pending &pending);
+    void watchTimeout(QNetworkReply *reply);
+    void attempt(Operation op, const QNetworkRequest &request, const QByteArray &data, QPointer<QObject> context, std::function<void(QNetworkReply *)> finished, int retry);
+};
+
 class IIMODMANLIBSHARED_EXPORT ModDownloader : public QObject
 {
     Q_OBJECT
 
 public:
     ModDownloader(const ModManConfig &config, QObject *parent = nullptr);
+    ~ModDownloader();
 
     ModInfoCall *fetchModInfo(const QString& id);
     ModInfoCall *modInfoCall();
+    //! Creates a call for looking up many mods at once.
+    ModInfoBatchCall *modInfoBatchCall();
     ModDownloadCall *downloadModVersion(ModCache &cache, const SteamModInfo& info);
     ModDownloadCall *modDownloadCall(ModCache &cache);
+    //! Creates a queue for downloading multiple mods concurrently.
+    ModDownloadQueue *downloadQueue(ModCache &cache);
     ApplicationVersionCall *appVersionCall();
 
+    inline const ModManConfig &config() const { return config_; };
+    inline const RequestScheduler::Stats &requestStats() const { return scheduler_.stats(); };
+
 private:
     const ModManConfig &config_;
     QNetworkAccessManager qnam_;
+    RequestScheduler scheduler_;
+    std::unique_ptr<SteamInfoCache> infoCache_;
+    //! Worker thread for extracting downloaded zips, so that extraction doesn't block other transfers.
+    QThreadPool extractPool_;
 };
 
 class IIMODMANLIBSHARED_EXPORT ModInfoCall : public QObject
@@ -58,7 +209,7 @@ class IIMODMANLIBSHARED_EXPORT ModInfoCall : public QObject
     friend ModDownloader;
 
 public:
-    ModInfoCall(const ModManConfig &config, QNetworkAccessManager &qnam, QObject *parent);
+    ModInfoCall(const ModManConfig &config, RequestScheduler &scheduler, QObject *parent);
 
     void start(const QString& id);
 
@@ -71,37 +222,233 @@ signals:
 
 private:
     const ModManConfig &config_;
-    QNetworkAccessManager &qnam_;
+    RequestScheduler &scheduler_;
     QString id_;
     SteamModInfo result_;
     QString errorDetail_;
 };
 
+//! Fetches details for many mods from the Steam API, looking up several mods in each request.
+//! The number of mods per request is limited as configured in ModManConfig.
+//! Results are reported per mod, in the order requested.
+//! Details looked up within the configured TTL are reused without a request. If Steam can't be reached,
+//! the last known details are returned instead of an error. Reused details have no description.
+class IIMODMANLIBSHARED_EXPORT ModInfoBatchCall : public QObject
+{
+    Q_OBJECT
+    friend ModDownloader;
+
+public:
+    ModInfoBatchCall(const ModManConfig &config, RequestScheduler &scheduler, SteamInfoCache &infoCache, QObject *parent);
+
+    void start(const QStringList &ids);
+
+    inline qsizetype size() const { return ids_.size(); };
+    inline const QString &workshopId(qsizetype index) const { return ids_.at(index); };
+    //! Details for the mod at the given index. Invalid if that lookup failed.
+    inline const SteamModInfo &result(qsizetype index) const { return results_.at(index); };
+    inline const QString &errorDetail(qsizetype index) const { return errorDetails_.at(index); };
+
+signals:
+    //! Emitted after each request completes, with the number of mods looked up so far.
+    void progress(int count);
+    void finished();
+
+private:
+    const ModManConfig &config_;
+    RequestScheduler &scheduler_;
+    SteamInfoCache &infoCache_;
+    QStringList ids_;
+    QList<SteamModInfo> results_;
+    QStringList errorDetails_;
+    //! Indexes of mods that need a request, as they weren't freshly cached.
+    QList<qsizetype> pendingIndexes_;
+    //! Position within pendingIndexes_ of the first mod in the next request.
+    qsizetype nextIndex_;
+    qsizetype doneCount_;
+
+    void startBatch();
+    void batchFinished(qsizetype count);
+};
+
 class IIMODMANLIBSHARED_EXPORT ModDownloadCall : public QObject
 {
     Q_OBJECT
     friend ModDownloader;
 
 public:
-    ModDownloadCall(const ModManConfig &config, QNetworkAccessManager &qnam, ModCache &cache, QObject *parent);
+    ModDownloadCall(const ModManConfig &config, RequestScheduler &scheduler, QThreadPool &extractPool, ModCache &cache, QObject *parent);
+    ~ModDownloadCall();
 
     void start(const SteamModInfo& info);
 
+    //! URLs to try for the mod's zip, in order: the configured mirrors, then Steam.
+    //! Mirrors that don't form a valid URL are skipped, and listed in invalidMirrors if provided.
+    static QList<QUrl> sources(const ModManConfig &config, const SteamModInfo &info, QStringList *invalidMirrors = nullptr);
+
     inline const SteamModInfo& steamInfo() const { return info_; };
     const CachedVersion *resultVersion() const;
+    inline const QString &resultVersionId() const { return resultVersionId_; };
     inline const QString &errorDetail() const { return errorDetail_; };
+    //! Measurements of the latest download. Complete once finished.
+    inline const DownloadMetrics &metrics() const { return metrics_; };
 
 signals:
+    //! Emitted as the zip arrives. Total is -1 if the size isn't known.
+    void progress(qint64 received, qint64 total);
+    //! Emitted when the download moves on to the next source, after the first one failed.
+    void sourceChanged(const QUrl &source);
     void finished();
 
 private:
+    //! Outcome of the extraction thread's last task for an attempt.
+    struct ExtractResult
+    {
+        bool ok = false;
+        QString errorInfo;
+        //! Hash and file totals of the extracted folder, computed on the extraction thread.
+        QString hash;
+        qint64 hashBytes = 0;
+        int hashFiles = 0;
+        qint64 hashMs = 0;
+    };
+
     const ModManConfig &config_;
-    QNetworkAccessManager &qnam_;
+    RequestScheduler &scheduler_;
+    QThreadPool &extractPool_;
     ModCache &cache_;
 
     SteamModInfo info_;
     QString resultVersionId_;
     QString errorDetail_;
+
+    //! URLs to try for the zip, in order: the configured mirrors, then Steam.
+    QList<QUrl> sources_;
+    int sourceIndex_;
+    //! Set while the download is in progress, including while waiting to retry.
+    bool active_;
+    //! Identifies the latest request, so that superseded requests are ignored once the scheduler sends them.
+    quint64 requestSerial_;
+    QNetworkReply *reply_;
+    //! Set once the current reply's status and headers have been checked.
+    bool responseChecked_;
+    //! True if extracting while downloading. Otherwise the download is saved to partialFile_ first.
+    //! Streamed downloads are also copied to partialFile_ where possible, so that they can continue from there if the zip can't be streamed.
+    bool streaming_;
+    //! Bytes of the zip received so far, across all requests of the current attempt.
+    qint64 received_;
+    //! Total size of the zip as reported by the server, or -1 if not reported.
+    qint64 expectedSize_;
+    //! Strong ETag or Last-Modified of the current source's response, sent as If-Range when resuming from it.
+    //! Empty if the source's response had neither, or if received_ came from somewhere else.
+    QByteArray rangeValidator_;
+    int retries_;
+    //! Folder the current attempt extracts into, before it's moved into the cache.
+    QString stagingPath_;
+    //! Extracts the current streamed attempt. Extraction tasks share ownership, and only they call into the extractor.
+    //! On this thread the pointer only identifies the current attempt, so that reports from superseded attempts are ignored.
+    std::shared_ptr<ZipStreamExtractor> extractor_;
+    //! Download saved to the cache folder, so that it can be resumed by a later attempt.
+    //! Not parented, as it's handed off to the extraction thread.
+    QFile *partialFile_;
+    //! Streamed bytes waiting for the extraction thread. Reading from the network pauses while this is over the limit.
+    std::atomic<qint64> queuedStreamBytes_;
+    DownloadMetrics metrics_;
+    QElapsedTimer metricsTimer_;
+    //! Time the extraction thread has spent on this download.
+    std::atomic<qint64> extractNsecs_;
+    //! From start() until finished, across retries and sources.
+    //! Kept out of this header, which is installed without the tracing header.
+    std::unique_ptr<Tracing::Span> traceSpan_;
+
+    QString partialFilePath() const;
+    void startDownload();
+    void startLinked(const QString &sourcePath);
+    void startStreamed();
+    void startSpooled();
+    void sendRequest();
+    bool checkResponse(QNetworkReply *reply);
+    //! Total size the download should reach, from the server if it said, or else from Steam.
+    qint64 expectedTotal() const;
+    bool checkListedSize();
+    //! Moves on to the next source from the beginning, or fails if there are none left.
+    //! If discardReceived is set, the data received so far can't be trusted, and isn't kept to resume in a later session.
+    void sourceFailed(const QString &errorInfo, bool discardReceived);
+    //! Reads the reply's data. Unless the reply has finished, reading is deferred while the extraction thread is behind.
+    void receive(QNetworkReply *reply, bool isFinished = false);
+    void requestFinished(QNetworkReply *reply);
+    void abortRequest();
+    void streamChunk(const std::shared_ptr<ZipStreamExtractor> &extractor, const QByteArray &data);
+    void streamInterrupted(const std::shared_ptr<ZipStreamExtractor> &extractor, bool unsupported, const QString &errorInfo);
+    void discardStaging();
+    void finishWithError(const QString &errorInfo);
+    //! Hashes the extracted folder. Called on the extraction thread, while it has the folder to itself.
+    static void hashExtracted(const QString &stagingPath, ExtractResult *result);
+    void extractFinished(const ExtractResult &result);
+    void finishMetrics(bool ok);
+};
+
+//! Downloads multiple mods, running several transfers at once.
+//! Limits the number of concurrent transfers in total and per host, as configured in ModManConfig.
+//! Each download is reported in the order it was queued, regardless of which transfer finishes first.
+class IIMODMANLIBSHARED_EXPORT ModDownloadQueue : public QObject
+{
+    Q_OBJECT
+    friend ModDownloader;
+
+public:
+    ModDownloadQueue(ModDownloader &downloader, ModCache &cache, QObject *parent);
+
+    void start(const QList<SteamModInfo> &infos);
+
+    inline int size() const { return results_.size(); };
+    inline const SteamModInfo &steamInfo(int index) const { return results_.at(index).info; };
+    const CachedVersion *resultVersion(int index) const;
+    inline const QString &errorDetail(int index) const { return results_.at(index).errorDetail; };
+    //! Measurements of the download at the given index, once it's finished.
+    inline const DownloadMetrics &metrics(int index) const { return results_.at(index).metrics; };
+    //! Totals of the downloads finished so far.
+    inline const DownloadSummary &summary() const { return summary_; };
+
+signals:
+    //! Emitted as each mod's zip arrives, in any order. Total is -1 if the size isn't known.
+    void downloadProgress(int index, qint64 received, qint64 total);
+    //! Emitted whenever a download finishes and the summary changes, in any order.
+    void summaryChanged();
+    //! Emitted as soon as each queued mod finishes, in any order, so that it can be used while others are still downloading.
+    void downloadCompleted(int index);
+    //! Emitted once for each queued mod, in queue order.
+    void downloadFinished(int index);
+    //! Emitted after all queued mods have been reported.
+    void finished();
+
+private:
+    struct Result
+    {
+        SteamModInfo info;
+        //! Host of the source being downloaded from, which the per-host limit applies to.
+        QString host;
+        QString versionId;
+        QString errorDetail;
+        DownloadMetrics metrics;
+        bool done = false;
+    };
+
+    ModDownloader &downloader_;
+    ModCache &cache_;
+    QList<Result> results_;
+    DownloadSummary summary_;
+    QElapsedTimer timer_;
+    //! Indexes of results that haven't started yet, in queue order.
+    QList<int> pending_;
+    //! Index of the next result to report.
+    int nextReport_;
+    int activeCount_;
+    QHash<QString, int> activeHostCounts_;
+
+    void startPending();
+    void releaseHost(const QString &host);
+    void callFinished(ModDownloadCall *call, int index);
 };
 
 //! Fetches details on the latest release of this mod manager application.
@@ -4,11 +4,17 @@
 #include "modlist.h"
 #include "modmanconfig.h"
 #include "modspec.h"
+#include "tracing.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QJsonObject>
 #include <QList>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
 #include <optional>
 #include <modsignature.h>
 
@@ -30,7 +36,8 @@ public:
     InstalledMod *mod(const QString &id);
     const InstalledMod *mod(const QString &id) const;
 
-    void refresh(RefreshLevel level = FULL);
+    void refresh(RefreshLevel level = FULL, const std::function<void(const InstalledMod &)> &modRefreshed = nullptr);
+    void refreshMod(const QString &installedId, RefreshLevel level);
     const InstalledMod *installMod(const SpecMod &specMod, QString *errorInfo = nullptr);
     bool removeMod(const QString &modId, QString *errorInfo = nullptr);
 
@@ -64,6 +71,10 @@ public:
     inline const QString &alias() const { return alias_; };
     inline const QString &installedId() const { return alias_.isEmpty() ? id_ : alias_; }
     const QString &hash() const;
+    inline bool isHashed() const { return !hash_.isEmpty(); };
+    qint64 knownSize() const;
+    qint64 size() const;
+    int knownFileCount() const;
 
     const CachedVersion *cacheVersion() const;
     const CachedVersion *alternateCacheVersion(const QString &cacheId) const;
@@ -77,6 +88,12 @@ public:
     inline void overrideId(const QString &newId) { id_ = newId; }
     inline void setAlias(const QString &newAlias) { alias_ = newAlias; }
     bool refresh(ModList::RefreshLevel level = ModList::FULL, const QString &expectedCacheVersionId = QString(), ModInfo::IDStatus idStatus = ModInfo::ID_LOCKED);
+    //! Filesystem portion of a refresh: reads metadata and hashes the contents if the cache may need it.
+    //! Only modifies this mod and only reads from the parent, so separate mods may be scanned concurrently.
+    bool scan(const QString &modPath, ModList::RefreshLevel level, ModInfo::IDStatus idStatus);
+    //! Cache portion of a refresh: marks the matching cache version as installed.
+    //! Must be called on the thread that owns the cache, after a successful scan.
+    void merge(ModList::RefreshLevel level, const QString &expectedCacheVersionId);
 
 private:
     ModList::Impl &parent_;
@@ -86,6 +103,8 @@ private:
 
     mutable QString cacheVersionId_;
     mutable QString hash_;
+    //! File totals, collected while hashing, or on their own by size().
+    mutable std::optional<ModSignature::Stats> stats_;
     mutable std::optional<SpecMod> specMod;
 
     inline const ModList::Impl &parent() const { return parent_; }
@@ -96,6 +115,7 @@ static bool writeMetadata(const QString &installedPath, const CachedMod *cm, con
 {
     if (!cm)
         return false;
+    IIMODMAN_TRACE_SCOPE_DETAIL("modlist", "modlist.saveMetadata", cm->id());
 
     QJsonObject root;
     root["modId"] = cm->id();
@@ -139,6 +159,16 @@ void ModList::refresh(ModList::RefreshLevel level)
     impl->refresh(level);
 }
 
+void ModList::refresh(ModList::RefreshLevel level, const std::function<void(const InstalledMod &)> &modRefreshed)
+{
+    impl->refresh(level, modRefreshed);
+}
+
+void ModList::refreshMod(const QString &installedId, ModList::RefreshLevel level)
+{
+    impl->refreshMod(installedId, level);
+}
+
 const InstalledMod *ModList::installMod(const SpecMod &specMod, QString *errorInfo)
 {
     return impl->installMod(specMod, errorInfo);
@@ -153,7 +183,10 @@ ModList::~ModList() = default;
 
 ModList::Impl::Impl(const ModManConfig &config, ModCache *cache)
     : config_(config), cache_(cache)
-{}
+{
+    if (config_.hasValidPaths())
+        FileUtils::reapTrash(config_.modPath());
+}
 
 bool ModList::Impl::contains(const QString &id) const
 {
@@ -187,9 +220,10 @@ const QHash<QString, QString> ModList::Impl::saveCacheVersionIds() const
     return map;
 }
 
-void ModList::Impl::refresh(ModList::RefreshLevel level)
+void ModList::Impl::refresh(ModList::RefreshLevel level, const std::function<void(const InstalledMod &)> &modRefreshed)
 {
     QDir installDir(config_.modPath());
+    IIMODMAN_TRACE_SCOPE_DETAIL("modlist", "modlist.refresh", installDir.path());
     qCDebug(modlist).noquote() << "installed:refresh() Start" << installDir.path();
 
     const QHash<QString, QString> cacheVersionIds = saveCacheVersionIds();
@@ -206,13 +240,51 @@ void ModList::Impl::refresh(ModList::RefreshLevel level)
 
     installDir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
     installDir.setSorting(QDir::Name);
-    const QStringList modIds = installDir.entryList();
-    mods_.reserve(modIds.size());
-    for (const auto &modId : modIds)
+    QStringList modIds = installDir.entryList();
+    modIds.removeAll(FileUtils::trashDirName);
+
+    // Reading and hashing each folder is independent, so scan them concurrently.
+    // Cache updates are merged on this thread in folder order, matching a sequential refresh,
+    // as soon as each folder and those before it have been scanned.
+    QList<InstalledMod> scannedMods;
+    scannedMods.reserve(modIds.size());
+    QVector<bool> scanResults(modIds.size(), false);
+    QVector<bool> scanFinished(modIds.size(), false);
+    QMutex scanMutex;
+    QWaitCondition scanCondition;
     {
-        InstalledMod mod(*this, modId);
-        if (mod.impl()->refresh(level, cacheVersionIds.value(modId), ModInfo::ID_TENTATIVE))
+        QThreadPool scanPool;
+        for (qsizetype i = 0; i < modIds.size(); ++i)
+        {
+            const QString &modId = modIds.at(i);
+            scannedMods.append(InstalledMod(*this, modId));
+            InstalledMod::Impl *modImpl = scannedMods.last().impl();
+            const QString path = installDir.absoluteFilePath(modId);
+            scanPool.start([modImpl, path, level, i, &scanResults, &scanFinished, &scanMutex, &scanCondition] {
+                const bool result = modImpl->scan(path, level, ModInfo::ID_TENTATIVE);
+                QMutexLocker locker(&scanMutex);
+                scanResults[i] = result;
+                scanFinished[i] = true;
+                scanCondition.wakeAll();
+            });
+        }
+
+        mods_.reserve(modIds.size());
+        for (qsizetype i = 0; i < modIds.size(); ++i)
+        {
+            {
+                QMutexLocker locker(&scanMutex);
+                while (!scanFinished.at(i))
+                    scanCondition.wait(&scanMutex);
+                if (!scanResults.at(i))
+                    continue;
+            }
+            InstalledMod &mod = scannedMods[i];
+            mod.impl()->merge(level, cacheVersionIds.value(modIds.at(i)));
             mods_.append(mod);
+            if (modRefreshed)
+                modRefreshed(mods_.last());
+        }
     }
 
     refreshIndex();
@@ -228,6 +300,43 @@ void ModList::Impl::refresh(ModList::RefreshLevel level)
     emit q->refreshed();
 }
 
+void ModList::Impl::refreshMod(const QString &installedId, ModList::RefreshLevel level)
+{
+    IIMODMAN_TRACE_SCOPE_DETAIL("modlist", "modlist.refreshMod", installedId);
+    if (!config_.hasValidPaths())
+        return;
+
+    qsizetype index = -1;
+    for (qsizetype i = 0; i < mods_.size(); ++i)
+    {
+        if (mods_.at(i).installedId() == installedId)
+        {
+            index = i;
+            break;
+        }
+    }
+    const QString previousId = index >= 0 ? mods_.at(index).id() : QString();
+    const QString previousVersionId = index >= 0 ? mods_.at(index).impl()->cacheVersionId() : QString();
+
+    emit q->aboutToRefresh();
+    // Read from scratch, as in a full refresh, in case modman.json changed the mod's ID.
+    InstalledMod mod(*this, installedId);
+    if (mod.impl()->refresh(level, previousVersionId, ModInfo::ID_TENTATIVE))
+    {
+        if (index >= 0)
+            mods_[index] = mod;
+        else
+            mods_.append(mod);
+    }
+    else if (index >= 0)
+        mods_.removeAt(index);
+    refreshIndex();
+
+    if (!previousId.isEmpty() && !modIds_.contains(previousId))
+        cache()->unmarkInstalledMod(previousId);
+    emit q->refreshed();
+}
+
 const InstalledMod *ModList::Impl::installMod(const SpecMod &specMod, QString *errorInfo)
 {
     if (!config_.hasValidPaths())
@@ -279,21 +388,24 @@ const InstalledMod *ModList::Impl::installMod(const SpecMod &specMod, QString *e
     }
     const QString inputPath = cv->path();
     const QString outputPath = modPath(useAlias ? alias : modId);
-    if (!FileUtils::removeModDir(outputPath, errorInfo))
+    if (!FileUtils::removeModDir(outputPath, errorInfo, FileUtils::REMOVE_DEFERRED, config_.modPath()))
         return nullptr;
     if (im && im->alias() != alias)
     {
         // Also uninstall the existing install of this mod with a different folder.
         const QString aliasPath = modPath(im->impl()->installedId());
-        if (!FileUtils::removeModDir(aliasPath, errorInfo))
+        if (!FileUtils::removeModDir(aliasPath, errorInfo, FileUtils::REMOVE_DEFERRED, config_.modPath()))
             return nullptr;
     }
     qCDebug(modlist) << "Copying" << inputPath << "to" << outputPath;
+    QElapsedTimer copyTimer;
+    copyTimer.start();
     if (!FileUtils::copyRecursively(inputPath, outputPath, errorInfo))
     {
         qCWarning(modlist).noquote() << "Failed to copy" << inputPath << "to" << outputPath;
         return nullptr;
     }
+    cache()->recordThroughput(ModCache::COPY_THROUGHPUT, cv->size(), copyTimer.elapsed());
 
     bool writeOk = writeMetadata(outputPath, cm, cv);
     Q_UNUSED(writeOk); // Continue even on failure. The metadata isn't critical.
@@ -331,7 +443,7 @@ bool ModList::Impl::removeMod(const QString &modId, QString *errorInfo)
     if (im)
     {
         const QString outputPath = modPath(im->impl()->installedId());
-        if (!FileUtils::removeModDir(outputPath, errorInfo))
+        if (!FileUtils::removeModDir(outputPath, errorInfo, FileUtils::REMOVE_DEFERRED, config_.modPath()))
             return false;
     }
     else if (errorInfo)
@@ -404,6 +516,26 @@ const QString &InstalledMod::hash() const
     return impl()->hash();
 }
 
+bool InstalledMod::isHashed() const
+{
+    return impl()->isHashed();
+}
+
+qint64 InstalledMod::knownSize() const
+{
+    return impl()->knownSize();
+}
+
+qint64 InstalledMod::size() const
+{
+    return impl()->size();
+}
+
+int InstalledMod::knownFileCount() const
+{
+    return impl()->knownFileCount();
+}
+
 bool InstalledMod::hasCacheVersion() const
 {
     return impl()->cacheVersion();
@@ -452,10 +584,31 @@ InstalledMod::Impl::Impl(ModList::Impl &parent, const QString &id)
 const QString &InstalledMod::Impl::hash() const
 {
     if (hash_.isEmpty())
-        hash_ = ModSignature::hashModPath(parent().modPath(installedId()));
+    {
+        ModSignature::Stats stats;
+        hash_ = ModSignature::hashModPath(parent().modPath(installedId()), &stats);
+        stats_ = stats;
+    }
     return hash_;
 }
 
+qint64 InstalledMod::Impl::knownSize() const
+{
+    return stats_ ? stats_->bytes : -1;
+}
+
+qint64 InstalledMod::Impl::size() const
+{
+    if (!stats_)
+        stats_ = ModSignature::statModPath(parent().modPath(installedId()));
+    return stats_->bytes;
+}
+
+int InstalledMod::Impl::knownFileCount() const
+{
+    return stats_ ? stats_->files : -1;
+}
+
 const CachedVersion *InstalledMod::Impl::cacheVersion() const
 {
     if (cacheVersionId_.isEmpty())
@@ -511,7 +664,15 @@ bool InstalledMod::Impl::writeMetadataClaim(const QString &cacheId, const QStrin
 
 bool InstalledMod::Impl::refresh(ModList::RefreshLevel level, const QString &expectedCacheVersionId, ModInfo::IDStatus idStatus)
 {
-    QDir modDir(parent().modPath(installedId()));
+    if (!scan(parent().modPath(installedId()), level, idStatus))
+        return false;
+    merge(level, expectedCacheVersionId);
+    return true;
+}
+
+bool InstalledMod::Impl::scan(const QString &modPath, ModList::RefreshLevel level, ModInfo::IDStatus idStatus)
+{
+    QDir modDir(modPath);
     if (!modDir.exists("modinfo.txt"))
     {
         qCDebug(modlist).noquote() << QString("installedmod:refresh(%1)").arg(id_) << "skipped: No modinfo.txt";
@@ -520,6 +681,7 @@ bool InstalledMod::Impl::refresh(ModList::RefreshLevel level, const QString &exp
     qCDebug(modlist).noquote().nospace() << QString("installedmod:refresh(%1)").arg(id_);
 
     hash_.clear();
+    stats_.reset();
     specMod.reset();
 
     const QJsonObject savedMetadata = FileUtils::readJSON(modDir.filePath("modman.json"));
@@ -552,13 +714,29 @@ bool InstalledMod::Impl::refresh(ModList::RefreshLevel level, const QString &exp
     if (level == ModList::CONTENT_ONLY)
         return true;
 
+    const ModCache *cache = parent().cache();
+    assert(cache);
+    if (cache->contains(id_))
+    {
+        ModSignature::Stats stats;
+        hash_ = ModSignature::hashModPath(modDir.path(), &stats);
+        stats_ = stats;
+    }
+
+    return true;
+}
+
+void InstalledMod::Impl::merge(ModList::RefreshLevel level, const QString &expectedCacheVersionId)
+{
+    if (level != ModList::FULL)
+        return;
+
     ModCache *cache = parent_.cache();
     assert(cache);
     if (cache->contains(id_))
     {
-        hash_ = ModSignature::hashModPath(modDir.path());
         const CachedVersion *version = cache->markInstalledVersion(
-                id_, hash_,
+                id_, hash(),
                 expectedCacheVersionId.isNull() ? cacheVersionId_ : expectedCacheVersionId);
         if (version)
             cacheVersionId_ = version->id();
@@ -567,9 +745,6 @@ bool InstalledMod::Impl::refresh(ModList::RefreshLevel level, const QString &exp
     }
     else
         cacheVersionId_.clear();
-
-
-    return true;
 }
 
 }  // namespace iimodmanager
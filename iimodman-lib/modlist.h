@@ -6,6 +6,7 @@
 #include <experimental/propagate_const>
 
 #include <QObject>
+#include <functional>
 #include <memory>
 
 template <typename T> class QList;
@@ -49,6 +50,12 @@ public:
 
 
     void refresh(RefreshLevel level = FULL);
+    //! Like refresh, but calls modRefreshed for each mod in folder order as soon as it's been read,
+    //! while later folders are still being read. The list is only consistent again once this returns.
+    void refresh(RefreshLevel level, const std::function<void(const InstalledMod &)> &modRefreshed);
+    //! Refreshes a single installed folder to the specified level, such as after its files changed.
+    //! Drops the mod if the folder is no longer a mod, and appends it if the folder is new.
+    void refreshMod(const QString &installedId, RefreshLevel level = FULL);
     //! Installs the specified mod from the cache.
     //! Does not re-sort the mods list.
     const InstalledMod *installMod(const SpecMod &specMod, QString *errorInfo = nullptr);
@@ -83,6 +90,15 @@ public:
     const QString &installedId() const { return alias().isEmpty() ? id() : alias(); }
     const ModInfo &info() const;
     const QString &hash() const;
+    //! True if the installed files have already been hashed.
+    bool isHashed() const;
+    //! Total size in bytes of the installed files, if known without scanning the folder. Otherwise -1.
+    //! Known once the mod has been hashed, which a FULL refresh does for all mods in the cache.
+    qint64 knownSize() const;
+    //! Total size in bytes of the installed files. If not already known, lists the folder's files without reading them.
+    qint64 size() const;
+    //! Number of installed files, if known without scanning the folder. Otherwise -1.
+    int knownFileCount() const;
 
     bool hasCacheVersion() const;
     //! The cached version matching the currently installed mod, or nullptr if there is no match.
@@ -11,6 +11,16 @@ const QString ModManConfig::organizationName = QStringLiteral("QoalatyEngineerin
 static const QString cachePathKey = QStringLiteral("core/cachePath");
 static const QString installPathKey = QStringLiteral("core/installPath");
 static const QString localPathKey = QStringLiteral("core/localPath");
+static const QString downloadConcurrencyKey = QStringLiteral("download/concurrency");
+static const QString downloadHostConcurrencyKey = QStringLiteral("download/hostConcurrency");
+static const QString infoBatchSizeKey = QStringLiteral("download/infoBatchSize");
+static const QString infoCacheTtlKey = QStringLiteral("download/infoCacheTtl");
+static const QString downloadStreamingKey = QStringLiteral("download/streaming");
+static const QString downloadMirrorsKey = QStringLiteral("download/mirrors");
+static const QString requestRateKey = QStringLiteral("network/requestRate");
+static const QString requestTimeoutKey = QStringLiteral("network/timeout");
+static const QString maxRetriesKey = QStringLiteral("network/maxRetries");
+static const QString retryDelayKey = QStringLiteral("network/retryDelay");
 
 ModManConfig::ModManConfig()
 #ifdef Q_OS_WIN
@@ -20,6 +30,10 @@ ModManConfig::ModManConfig()
 #endif
 {}
 
+ModManConfig::ModManConfig(const QString &settingsPath)
+    : settings_(settingsPath, QSettings::IniFormat)
+{}
+
 bool ModManConfig::isValidInstallPath(const QString &path)
 {
     QDir installDir(path);
@@ -56,6 +70,106 @@ void ModManConfig::setLocalPath(const QString &value)
     this->settings_.setValue(localPathKey, value);
 }
 
+int ModManConfig::downloadConcurrency() const
+{
+    return this->settings_.value(downloadConcurrencyKey, 4).toInt();
+}
+
+void ModManConfig::setDownloadConcurrency(int value)
+{
+    this->settings_.setValue(downloadConcurrencyKey, value);
+}
+
+int ModManConfig::downloadHostConcurrency() const
+{
+    return this->settings_.value(downloadHostConcurrencyKey, 2).toInt();
+}
+
+void ModManConfig::setDownloadHostConcurrency(int value)
+{
+    this->settings_.setValue(downloadHostConcurrencyKey, value);
+}
+
+int ModManConfig::infoBatchSize() const
+{
+    return this->settings_.value(infoBatchSizeKey, 100).toInt();
+}
+
+void ModManConfig::setInfoBatchSize(int value)
+{
+    this->settings_.setValue(infoBatchSizeKey, value);
+}
+
+int ModManConfig::infoCacheTtl() const
+{
+    return this->settings_.value(infoCacheTtlKey, 600).toInt();
+}
+
+void ModManConfig::setInfoCacheTtl(int value)
+{
+    this->settings_.setValue(infoCacheTtlKey, value);
+}
+
+bool ModManConfig::downloadStreaming() const
+{
+    return this->settings_.value(downloadStreamingKey, true).toBool();
+}
+
+void ModManConfig::setDownloadStreaming(bool value)
+{
+    this->settings_.setValue(downloadStreamingKey, value);
+}
+
+QStringList ModManConfig::downloadMirrors() const
+{
+    return this->settings_.value(downloadMirrorsKey).toStringList();
+}
+
+void ModManConfig::setDownloadMirrors(const QStringList &value)
+{
+    this->settings_.setValue(downloadMirrorsKey, value);
+}
+
+int ModManConfig::requestRate() const
+{
+    return this->settings_.value(requestRateKey, 10).toInt();
+}
+
+void ModManConfig::setRequestRate(int value)
+{
+    this->settings_.setValue(requestRateKey, value);
+}
+
+int ModManConfig::requestTimeout() const
+{
+    return this->settings_.value(requestTimeoutKey, 30).toInt();
+}
+
+void ModManConfig::setRequestTimeout(int value)
+{
+    this->settings_.setValue(requestTimeoutKey, value);
+}
+
+int ModManConfig::maxRetries() const
+{
+    return this->settings_.value(maxRetriesKey, 3).toInt();
+}
+
+void ModManConfig::setMaxRetries(int value)
+{
+    this->settings_.setValue(maxRetriesKey, value);
+}
+
+int ModManConfig::retryDelay() const
+{
+    return this->settings_.value(retryDelayKey, 1000).toInt();
+}
+
+void ModManConfig::setRetryDelay(int value)
+{
+    this->settings_.setValue(retryDelayKey, value);
+}
+
 const QString ModManConfig::modPath() const
 {
     return installPath() + "/mods";
@@ -3,6 +3,7 @@
 
 #include "iimodman-lib_global.h"
 #include <QSettings>
+#include <QStringList>
 
 
 namespace iimodmanager {
@@ -16,6 +17,8 @@ public:
     static bool isValidInstallPath(const QString&);
 
     ModManConfig();
+    //! Reads and writes settings in the given INI file instead of the user's settings, such as for a scratch configuration.
+    explicit ModManConfig(const QString &settingsPath);
 
     // Configurable paths
     const QString cachePath() const;
@@ -25,6 +28,40 @@ public:
     const QString localPath() const;
     void setLocalPath(const QString&);
 
+    // Downloads
+    //! Maximum number of mod downloads to run at once.
+    int downloadConcurrency() const;
+    void setDownloadConcurrency(int);
+    //! Maximum number of mod downloads to run at once from the same host.
+    int downloadHostConcurrency() const;
+    void setDownloadHostConcurrency(int);
+    //! Maximum number of mods to look up in a single Steam API request.
+    int infoBatchSize() const;
+    void setInfoBatchSize(int);
+    //! Seconds to reuse looked-up mod details before checking Steam again. 0 to always check.
+    int infoCacheTtl() const;
+    void setInfoCacheTtl(int);
+    //! Whether to extract mods while they download. Otherwise downloads are saved first, and can be resumed by a later run.
+    bool downloadStreaming() const;
+    void setDownloadStreaming(bool);
+    //! Local folders or HTTP(S) URLs to try before Steam. Each holds zips named {workshopId}-{timeUpdated}.zip.
+    QStringList downloadMirrors() const;
+    void setDownloadMirrors(const QStringList&);
+
+    // Network
+    //! Maximum number of requests to start per second. 0 for no limit.
+    int requestRate() const;
+    void setRequestRate(int);
+    //! Seconds without any data before a request is abandoned. 0 to wait indefinitely.
+    int requestTimeout() const;
+    void setRequestTimeout(int);
+    //! Maximum number of times a failed request is retried.
+    int maxRetries() const;
+    void setMaxRetries(int);
+    //! Milliseconds before the first retry. Doubled for each further retry.
+    int retryDelay() const;
+    void setRetryDelay(int);
+
     // Derived paths
     const QString modPath() const;
     const QString savePath() const;
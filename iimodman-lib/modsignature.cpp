@@ -1,4 +1,5 @@
 #include "modsignature.h"
+#include "tracing.h"
 
 #include <QCryptographicHash>
 #include <QDir>
@@ -10,7 +11,7 @@ namespace iimodmanager {
 Q_DECLARE_LOGGING_CATEGORY(modsig)
 Q_LOGGING_CATEGORY(modsig, "modsignature", QtWarningMsg)
 
-static void addFile(QCryptographicHash &hash, const QDir &rootDir, QString filePath)
+static void addFile(QCryptographicHash &hash, const QDir &rootDir, QString filePath, ModSignature::Stats *stats)
 {
     QString localPath = rootDir.relativeFilePath(filePath);
     qCDebug(modsig) << "Hashing" << localPath;
@@ -21,6 +22,11 @@ static void addFile(QCryptographicHash &hash, const QDir &rootDir, QString fileP
     {
         if (!hash.addData(&file))
             qCWarning(modsig) << "Failed to hash" << filePath;
+        if (stats)
+        {
+            stats->bytes += file.size();
+            stats->files += 1;
+        }
     }
     else
     {
@@ -28,7 +34,7 @@ static void addFile(QCryptographicHash &hash, const QDir &rootDir, QString fileP
     }
 }
 
-static void addDir(QCryptographicHash &hash, const QDir &rootDir, QString dirPath)
+static void addDir(QCryptographicHash &hash, const QDir &rootDir, QString dirPath, ModSignature::Stats *stats)
 {
     QDir dir(dirPath);
 
@@ -37,21 +43,48 @@ static void addDir(QCryptographicHash &hash, const QDir &rootDir, QString dirPat
     for (auto entry : dir.entryInfoList())
     {
         if (entry.isDir())
-            addDir(hash, rootDir, entry.filePath());
+            addDir(hash, rootDir, entry.filePath(), stats);
         else if (entry.isFile() and entry.fileName() != "modman.json")
-            addFile(hash, rootDir, entry.filePath());
+            addFile(hash, rootDir, entry.filePath(), stats);
     }
 }
 
-QString ModSignature::hashModPath(const QString &dirPath)
+static void statDir(ModSignature::Stats &stats, QString dirPath)
 {
+    QDir dir(dirPath);
+
+    dir.setFilter(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    for (auto entry : dir.entryInfoList())
+    {
+        if (entry.isDir())
+            statDir(stats, entry.filePath());
+        else if (entry.isFile() and entry.fileName() != "modman.json")
+        {
+            stats.bytes += entry.size();
+            stats.files += 1;
+        }
+    }
+}
+
+QString ModSignature::hashModPath(const QString &dirPath, Stats *stats)
+{
+    IIMODMAN_TRACE_SCOPE_DETAIL("modsignature", "hash", dirPath);
     QCryptographicHash hash(QCryptographicHash::Md5);
 
     qCDebug(modsig) << "Begin Hashing" << dirPath;
     const QDir modDir(dirPath);
-    addDir(hash, modDir, modDir.path());
+    if (stats)
+        *stats = Stats();
+    addDir(hash, modDir, modDir.path(), stats);
 
     return hash.result().toHex();
 }
 
+ModSignature::Stats ModSignature::statModPath(const QString &dirPath)
+{
+    Stats stats;
+    statDir(stats, dirPath);
+    return stats;
+}
+
 } // namespace iimodmanager
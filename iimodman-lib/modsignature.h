@@ -1,6 +1,10 @@
 #ifndef IIMODMANAGER_MODSIGNATURE_H
 #define IIMODMANAGER_MODSIGNATURE_H
 
+#include "iimodman-lib_global.h"
+
+#include <QtGlobal>
+
 class QString;
 
 
@@ -8,7 +12,19 @@ namespace iimodmanager {
 
 namespace ModSignature {
 
-QString hashModPath(const QString &dirPath);
+//! File totals of a mod folder. Excludes modman.json, like the hash.
+struct Stats
+{
+    qint64 bytes = 0;
+    int files = 0;
+};
+
+// Exported for benchmarking, but not part of the installed headers.
+
+//! Hashes the contents of a mod folder. If provided, also fills in the folder's file totals.
+IIMODMANLIBSHARED_EXPORT QString hashModPath(const QString &dirPath, Stats *stats = nullptr);
+//! Counts a mod folder's files without reading their contents.
+IIMODMANLIBSHARED_EXPORT Stats statModPath(const QString &dirPath);
 
 } // namespace ModSignature
 
@@ -1,22 +1,24 @@
 #include "modspec.h"
 
 #include <QDebug>
+#include <QHash>
 #include <QList>
 #include <QIODevice>
-#include <QMap>
 #include <QString>
+#include <cstring>
 #include <stdexcept>
 
 namespace iimodmanager {
 
-// {cacheModId}:{installedModId}:{cacheVersionId}:{unused}:{free text}
+// {cacheModId}:{installedModId}:{cacheVersionId}:{lock}:{free text}
 // free text: human readable text with the mod name (and version specifier if versioned and available)
-// unused: In the future, could add a single-line json string or other format for additional fields.
+// lock: Empty, or {hash}/{size} with the version's content signature and size in bytes.
 const QString specLineFormat = QStringLiteral("%1:%2:%3::%4");
+const QString specLockedLineFormat = QStringLiteral("%1:%2:%3:%4/%5:%6");
 const qsizetype specLineModId = 0;
 const qsizetype specLineAlias = 1;
 const qsizetype specLineVersionId = 2;
-// unused: 3
+const qsizetype specLineLock = 3;
 const qsizetype specLineNameStart = 4;
 const qsizetype specLineSectionLength = 5;
 
@@ -27,31 +29,36 @@ public:
 
     QList<SpecMod> mods;
     //! Index of mods by mod ID.
-    QMap<QString, qsizetype> modIds;
+    QHash<QString, qsizetype> modIds;
 
-    bool appendFromFile(QTextStream &in, const QString &debugRef);
+    bool appendFromContent(const QByteArray &content, const QString &debugRef);
+    void appendLine(const char *begin, const char *end, const QString &debugRef, qsizetype lineNo);
 };
 
 class SpecMod::Impl
 {
 public:
-    Impl(const QString &id, const QString &versionId, const QString &alias, const QString &name, const QString &versionName);
+    Impl(const QString &id, const QString &versionId, const QString &alias, const QString &name, const QString &versionName,
+         const QString &hash = QString(), qint64 size = -1);
 
     const QString id;
     const QString versionId;
     const QString alias;
     const QString name;
     const QString versionName;
+    const QString hash;
+    const qint64 size;
 
     QString asSpecString() const;
     QString asVersionedSpecString() const;
+    QString asLockedSpecString() const;
 };
 
 ModSpec::ModSpec(QObject *parent)
     : QObject(parent), impl{std::make_unique<Impl>()}
 {}
 
-const QList<SpecMod> ModSpec::mods() const
+const QList<SpecMod> &ModSpec::mods() const
 {
     return impl->mods;
 }
@@ -64,11 +71,13 @@ bool ModSpec::contains(QString modId) const
 void ModSpec::clear()
 {
     impl->mods.clear();
+    impl->modIds.clear();
 }
 
 void ModSpec::reserve(qsizetype size)
 {
     impl->mods.reserve(size);
+    impl->modIds.reserve(size);
 }
 
 void ModSpec::append(const SpecMod &specMod)
@@ -79,18 +88,15 @@ void ModSpec::append(const SpecMod &specMod)
 
 bool ModSpec::appendFromFile(QIODevice &file, const QString &debugRef)
 {
-    if (file.isOpen() || file.open(QIODevice::ReadOnly|QIODevice::Text))
-    {
-        QTextStream in(&file);
-        return impl->appendFromFile(in, debugRef);
-    }
+    // Line endings are handled while parsing, so text mode isn't needed.
+    if (file.isOpen() || file.open(QIODevice::ReadOnly))
+        return impl->appendFromContent(file.readAll(), debugRef);
     return false;
 }
 
 bool ModSpec::appendFromFile(const QByteArray &content, const QString &debugRef)
 {
-    QTextStream in(content);
-    return impl->appendFromFile(in, debugRef);
+    return impl->appendFromContent(content, debugRef);
 }
 
 ModSpec::~ModSpec() = default;
@@ -98,27 +104,70 @@ ModSpec::~ModSpec() = default;
 ModSpec::Impl::Impl()
 {}
 
-bool ModSpec::Impl::appendFromFile(QTextStream &in, const QString &debugRef)
+//! True if QString::simplified() wouldn't change the line, and it can be decoded as Latin-1.
+//! That is, plain ASCII with no control characters, no leading or trailing spaces, and no runs of spaces.
+static bool isSimpleLine(const char *begin, const char *end)
 {
+    if (begin == end)
+        return true;
+    if (*begin == ' ' || end[-1] == ' ')
+        return false;
+    char prev = 0;
+    for (const char *p = begin; p != end; ++p)
+    {
+        const char c = *p;
+        if (static_cast<unsigned char>(c) >= 0x80 || c < ' ' || (c == ' ' && prev == ' '))
+            return false;
+        prev = c;
+    }
+    return true;
+}
+
+bool ModSpec::Impl::appendFromContent(const QByteArray &content, const QString &debugRef)
+{
+    const char *p = content.constData();
+    const char *end = p + content.size();
+    // Skip a UTF-8 byte order mark.
+    if (content.startsWith("\xEF\xBB\xBF"))
+        p += 3;
+
+    const qsizetype lineCount = content.count('\n') + 1;
+    mods.reserve(mods.size() + lineCount);
+    modIds.reserve(modIds.size() + lineCount);
+
     qsizetype lineNo = 0;
-    while (!in.atEnd())
+    while (p < end)
     {
-        QString line = in.readLine().simplified();
-        ++lineNo;
-        // skip blank lines and comment lines
-        if (line.isEmpty() || line.startsWith('#'))
-            continue;
-
-        std::optional<SpecMod> sm = SpecMod::fromSpecString(line, debugRef, lineNo);
-        if (sm)
-        {
-            modIds[sm->id()] = mods.size();
-            mods.append(*sm);
-        }
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!lineEnd)
+            lineEnd = end;
+        appendLine(p, lineEnd, debugRef, ++lineNo);
+        p = lineEnd + 1;
     }
     return true;
 }
 
+void ModSpec::Impl::appendLine(const char *begin, const char *end, const QString &debugRef, qsizetype lineNo)
+{
+    if (begin != end && end[-1] == '\r')
+        --end;
+
+    // Most lines are plain ASCII, and are decoded directly. Anything else is decoded and simplified in full.
+    const QString line = isSimpleLine(begin, end)
+            ? QString::fromLatin1(begin, end - begin)
+            : QString::fromUtf8(begin, end - begin).simplified();
+    // skip blank lines and comment lines
+    if (line.isEmpty() || line.startsWith('#'))
+        return;
+
+    std::optional<SpecMod> sm = SpecMod::fromSpecString(line, debugRef, lineNo);
+    if (sm)
+    {
+        modIds[sm->id()] = mods.size();
+        mods.append(*sm);
+    }
+}
+
 SpecMod::SpecMod(const QString &id, const QString &name)
     : SpecMod(id, QString(), QString(), name, QString())
 {}
@@ -134,21 +183,41 @@ SpecMod::SpecMod(const QString &id, const QString &versionId, const QString &ali
 
 std::optional<SpecMod> SpecMod::fromSpecString(const QString &line, const QString &debugRef, qsizetype debugLineNo)
 {
-    const QStringList list = line.split(':');
-    if (list.length() < specLineSectionLength)
+    // Find the separators in a single pass. The free text may contain further separators.
+    qsizetype fieldStarts[specLineSectionLength];
+    fieldStarts[0] = 0;
+    for (qsizetype i = 1; i < specLineSectionLength; ++i)
     {
-        const QString ref = debugLineNo >= 0 ? QStringLiteral(" (%1:%2)").arg(debugRef, debugLineNo): QString();
-        qWarning() << "Couldn't parse spec line" << ref << ": Too few separators. \"" << line << '"';
-        return {};
+        const qsizetype separator = line.indexOf(':', fieldStarts[i - 1]);
+        if (separator < 0)
+        {
+            const QString ref = debugLineNo >= 0 ? QStringLiteral(" (%1:%2)").arg(debugRef).arg(debugLineNo) : QString();
+            qWarning() << "Couldn't parse spec line" << ref << ": Too few separators. \"" << line << '"';
+            return {};
+        }
+        fieldStarts[i] = separator + 1;
     }
-
-    const QString &modId = list[specLineModId];
-    const QString &alias = list[specLineAlias];
-    const QString &versionId = list[specLineVersionId];
-
-    const QString name = line.section(':', specLineNameStart);
-
-    return SpecMod(modId, versionId, alias, name, QString());
+    const auto field = [&line, &fieldStarts](qsizetype i)
+    {
+        return line.mid(fieldStarts[i], fieldStarts[i + 1] - fieldStarts[i] - 1);
+    };
+
+    SpecMod result(field(specLineModId), field(specLineVersionId), field(specLineAlias),
+                   line.mid(fieldStarts[specLineNameStart]), QString());
+
+    const QString lock = field(specLineLock);
+    if (lock.isEmpty())
+        return result;
+    const qsizetype slash = lock.indexOf('/');
+    bool ok = slash > 0;
+    const qint64 size = ok ? lock.mid(slash + 1).toLongLong(&ok) : -1;
+    if (!ok || result.versionId().isEmpty())
+    {
+        const QString ref = debugLineNo >= 0 ? QStringLiteral(" (%1:%2)").arg(debugRef).arg(debugLineNo) : QString();
+        qWarning() << "Ignoring invalid lock in spec line" << ref << ": \"" << line << '"';
+        return result;
+    }
+    return result.withLock(lock.left(slash), size);
 }
 
 QString SpecMod::id() const
@@ -176,6 +245,16 @@ QString SpecMod::versionName() const
     return impl->versionName;
 }
 
+QString SpecMod::hash() const
+{
+    return impl->hash;
+}
+
+qint64 SpecMod::size() const
+{
+    return impl->size;
+}
+
 SpecMod SpecMod::withoutVersion() const
 {
     return SpecMod(impl->id, /* versionId= */ QString(), impl->alias, impl->name, /* versionName= */ QString());
@@ -183,7 +262,16 @@ SpecMod SpecMod::withoutVersion() const
 
 SpecMod SpecMod::withAlias(const QString &newAlias) const
 {
-    return SpecMod(impl->id, impl->versionId, newAlias, impl->name, impl->versionName);
+    SpecMod result(*this);
+    result.impl = std::make_shared<Impl>(impl->id, impl->versionId, newAlias, impl->name, impl->versionName, impl->hash, impl->size);
+    return result;
+}
+
+SpecMod SpecMod::withLock(const QString &hash, qint64 size) const
+{
+    SpecMod result(*this);
+    result.impl = std::make_shared<Impl>(impl->id, impl->versionId, impl->alias, impl->name, impl->versionName, hash, size);
+    return result;
 }
 
 QString SpecMod::asSpecString() const
@@ -196,8 +284,14 @@ QString SpecMod::asVersionedSpecString() const
     return impl->asVersionedSpecString();
 }
 
-SpecMod::Impl::Impl(const QString &id, const QString &versionId, const QString &alias, const QString &name, const QString &versionName)
-    : id(id), versionId(versionId), alias(alias), name(name), versionName(versionName)
+QString SpecMod::asLockedSpecString() const
+{
+    return impl->asLockedSpecString();
+}
+
+SpecMod::Impl::Impl(const QString &id, const QString &versionId, const QString &alias, const QString &name, const QString &versionName,
+                    const QString &hash, qint64 size)
+    : id(id), versionId(versionId), alias(alias), name(name), versionName(versionName), hash(hash), size(size)
 {}
 
 QString SpecMod::Impl::asSpecString() const
@@ -211,4 +305,12 @@ QString SpecMod::Impl::asVersionedSpecString() const
     return specLineFormat.arg(id, alias, versionId, desc);
 }
 
+QString SpecMod::Impl::asLockedSpecString() const
+{
+    if (hash.isEmpty())
+        return asVersionedSpecString();
+    const QString desc = versionName.isEmpty() ? name : QStringLiteral("%1 [%2]").arg(name, versionName);
+    return specLockedLineFormat.arg(id, alias, versionId, hash).arg(size).arg(desc);
+}
+
 } // namespace iimodmanager
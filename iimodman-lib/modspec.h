@@ -24,13 +24,14 @@ class IIMODMANLIBSHARED_EXPORT ModSpec : public QObject
 public:
     ModSpec(QObject *parent = nullptr);
 
-    const QList<SpecMod> mods() const;
+    const QList<SpecMod> &mods() const;
     bool contains(QString modId) const;
 
     void clear();
     void reserve(qsizetype);
     void append(const SpecMod &specMod);
 
+    //! Parses spec lines from the whole file or buffer in one pass.
     bool appendFromFile(QIODevice &file, const QString &debugRef = QString());
     bool appendFromFile(const QByteArray &content, const QString &debugRef = QString());
 
@@ -54,12 +55,21 @@ public:
     QString alias() const;
     QString name() const;
     QString versionName() const;
+    //! Content signature the version is locked to, or empty if the spec line isn't locked.
+    QString hash() const;
+    //! Size in bytes of the locked version's files, or -1 if unknown.
+    qint64 size() const;
+    inline bool isLocked() const { return !hash().isEmpty(); };
 
     SpecMod withoutVersion() const;
     SpecMod withAlias(const QString &alias) const;
+    //! Locks the version to the given content signature and size, as written by asLockedSpecString.
+    SpecMod withLock(const QString &hash, qint64 size) const;
 
     QString asSpecString() const;
     QString asVersionedSpecString() const;
+    //! Versioned spec line that also records the content signature and size, so that an install can be verified against it.
+    QString asLockedSpecString() const;
 
 
 private:
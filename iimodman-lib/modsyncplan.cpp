@@ -0,0 +1,349 @@
+#include "modcache.h"
+#include "modinfo.h"
+#include "modlist.h"
+#include "modspec.h"
+#include "modsyncplan.h"
+
+#include <QHash>
+#include <QList>
+#include <QLocale>
+#include <QStringList>
+
+namespace iimodmanager {
+
+//! Keeps the installed version, under the requested alias.
+static ModChange pinCurrent(const InstalledMod &im, const QString &alias, int issues)
+{
+    ModChange change(im.id());
+    change.modName = im.info().name();
+    change.alias = alias;
+    const CachedVersion *iv = im.cacheVersion();
+    if (iv)
+        change.versionId = iv->id();
+    change.versionPin = ModChange::CURRENT;
+    change.type = alias == im.alias() ? ModChange::PIN_CURRENT : ModChange::RE_ALIAS;
+    change.issues = issues;
+    return change;
+}
+
+//! Uses the latest cached version, or else keeps the installed version.
+static ModChange useLatest(const CachedMod *cm, const InstalledMod *im, const QString &alias, int issues)
+{
+    const CachedVersion *lv = cm ? cm->latestVersion() : nullptr;
+    if (!lv)
+    {
+        if (cm)
+            issues |= ModChange::NOT_DOWNLOADED;
+        if (im)
+            return pinCurrent(*im, alias, issues);
+
+        ModChange change(cm->id());
+        change.modName = cm->info().name();
+        change.issues = issues;
+        return change;
+    }
+
+    ModChange change(cm->id());
+    change.modName = cm->info().name();
+    change.alias = alias;
+    change.versionId = lv->id();
+    change.versionPin = ModChange::LATEST;
+    change.issues = issues;
+    if (!im)
+        change.type = ModChange::INSTALL;
+    else if (alias != im->alias())
+        change.type = ModChange::RE_ALIAS;
+    else if (lv == cm->installedVersion())
+        change.type = ModChange::PIN_LATEST;
+    else
+        change.type = ModChange::UPDATE;
+    return change;
+}
+
+//! Uses the specified cached version.
+static ModChange pinVersion(const CachedMod &cm, const CachedVersion &tv, const InstalledMod *im, const QString &alias)
+{
+    ModChange change(cm.id());
+    change.modName = cm.info().name();
+    change.alias = alias;
+    change.versionId = tv.id();
+    change.versionPin = ModChange::PINNED;
+    if (!im)
+        change.type = ModChange::INSTALL;
+    else if (change.alias != im->alias())
+        change.type = ModChange::RE_ALIAS;
+    else if (&tv == cm.installedVersion())
+        change.type = ModChange::PIN_CURRENT;
+    else
+        change.type = ModChange::UPDATE;
+    return change;
+}
+
+ModChange ModChange::plan(const ModCache &cache, const ModList &modList, const SpecMod &sm)
+{
+    const CachedMod *cm = cache.mod(sm.id());
+    const InstalledMod *im = modList.mod(sm.id());
+    if (!cm && !im)
+    {
+        ModChange change(sm.id());
+        change.modName = sm.name();
+        change.issues = NOT_FOUND;
+        return change;
+    }
+
+    if (sm.isLocked())
+    {
+        // Sizes are compared first, so that only a mod with the locked size is hashed.
+        const bool isInstalledMatch = im && (sm.size() < 0 || im->size() == sm.size()) && im->hash() == sm.hash();
+        // Already installed exactly as locked, whether or not it's cached.
+        if (isInstalledMatch && im->alias() == sm.alias())
+            return pinCurrent(*im, sm.alias(), NO_ISSUE);
+
+        // Without a version ID, such as for a mod that wasn't cached when the spec was locked,
+        // only the lock says which files to keep or install.
+        if (!isInstalledMatch && (sm.versionId().isEmpty() || sm.versionId() == '-'))
+        {
+            const CachedVersion *lv = cm ? cm->versionFromHash(sm.hash()) : nullptr;
+            if (lv && (sm.size() < 0 || lv->size() == sm.size()))
+                return pinVersion(*cm, *lv, im, sm.alias());
+
+            ModChange change = im ? pinCurrent(*im, sm.alias(), LOCK_MISMATCH) : useLatest(cm, im, sm.alias(), LOCK_MISMATCH);
+            change.requestedVersionId = sm.versionId();
+            return change;
+        }
+    }
+
+    if (sm.versionId().isEmpty())
+        return useLatest(cm, im, sm.alias(), NO_ISSUE);
+    if (sm.versionId() == '-')
+    {
+        // Keep current, if possible.
+        if (im)
+            return pinCurrent(*im, sm.alias(), NO_ISSUE);
+        else
+            return useLatest(cm, im, sm.alias(), NO_ISSUE);
+    }
+
+    // A specific version ID was requested.
+    const CachedVersion *tv = cm ? cm->version(sm.versionId()) : nullptr;
+    if (!tv)
+    {
+        ModChange change = useLatest(cm, im, sm.alias(), VERSION_NOT_CACHED);
+        change.requestedVersionId = sm.versionId();
+        return change;
+    }
+    // Compare sizes first, as they're known without reading the files.
+    if (sm.isLocked() && ((sm.size() >= 0 && tv->size() != sm.size()) || tv->hash() != sm.hash()))
+    {
+        ModChange change = useLatest(cm, im, sm.alias(), LOCK_MISMATCH);
+        change.requestedVersionId = sm.versionId();
+        return change;
+    }
+
+    return pinVersion(*cm, *tv, im, sm.alias());
+}
+
+bool ModChange::collect(const ModCache &cache, const ModList &modList,
+                        QList<SpecMod> *toInstall, QList<SpecMod> *toUpdate, QList<InstalledMod> *toRemove, QString *errorInfo) const
+{
+    switch (type)
+    {
+    case RE_ALIAS:
+    case INSTALL:
+    case UPDATE:
+        {
+            const CachedMod *cm = cache.mod(modId);
+            const CachedVersion *cv = cm ? cm->version(versionId) : nullptr;
+            if (!cv)
+            {
+                if (errorInfo)
+                    *errorInfo = type == UPDATE
+                            ? QStringLiteral("Cannot update %1 to '%2': Not in cache.").arg(modId, versionId)
+                            : QStringLiteral("Cannot install %1 '%2': Not in cache.").arg(modId, versionId);
+                return false;
+            }
+            *(type == UPDATE ? toUpdate : toInstall) << cv->asSpec().withAlias(alias);
+        }
+        return true;
+    case REMOVE:
+        {
+            const InstalledMod *im = modList.mod(modId);
+            if (!im)
+            {
+                if (errorInfo)
+                    *errorInfo = QStringLiteral("Cannot remove %1: No longer installed.").arg(modId);
+                return false;
+            }
+            *toRemove << *im;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+void ModSyncPlan::refreshPinnedVersions(ModCache &cache, const QList<SpecMod> &spec)
+{
+    for (const SpecMod &sm : spec)
+    {
+        if (sm.versionId().isEmpty() || sm.versionId() == '-')
+            continue;
+        const CachedMod *cm = cache.mod(sm.id());
+        const CachedVersion *cv = cm ? cm->version(sm.versionId()) : nullptr;
+        if (cv && cv->info().isEmpty())
+            cache.refreshVersion(sm.id(), sm.versionId());
+    }
+}
+
+ModSyncPlan ModSyncPlan::build(const ModCache &cache, const ModList &modList, const QList<SpecMod> &spec, Scope scope)
+{
+    ModSyncPlan plan;
+    const QList<InstalledMod> &installed = modList.mods();
+    plan.changes.reserve(spec.size() + (scope == SYNC ? installed.size() : 0));
+    QHash<QString, qsizetype> indexes;
+    indexes.reserve(spec.size());
+
+    for (const SpecMod &sm : spec)
+    {
+        const ModChange change = ModChange::plan(cache, modList, sm);
+        auto it = indexes.find(change.modId);
+        if (it != indexes.end())
+            plan.changes[*it] = change;
+        else
+        {
+            indexes.insert(change.modId, plan.changes.size());
+            plan.changes.append(change);
+        }
+    }
+
+    if (scope == SYNC)
+    {
+        for (const InstalledMod &im : installed)
+        {
+            if (indexes.contains(im.id()))
+                continue;
+            ModChange change(im.id());
+            change.modName = im.info().name();
+            change.type = ModChange::REMOVE;
+            if (!im.hasCacheVersion())
+                change.issues = ModChange::REMOVES_UNCACHED;
+            plan.changes.append(change);
+        }
+    }
+
+    return plan;
+}
+
+bool ModSyncPlan::hasActiveChanges() const
+{
+    for (const ModChange &change : changes)
+        if (change.isActive())
+            return true;
+    return false;
+}
+
+bool ModSyncPlan::collect(const ModCache &cache, const ModList &modList,
+                          QList<SpecMod> *toInstall, QList<SpecMod> *toUpdate, QList<InstalledMod> *toRemove, QStringList *errors) const
+{
+    toInstall->reserve(toInstall->size() + changes.size());
+    toUpdate->reserve(toUpdate->size() + changes.size());
+    toRemove->reserve(toRemove->size() + changes.size());
+
+    bool success = true;
+    QString errorInfo;
+    for (const ModChange &change : changes)
+    {
+        if (!change.collect(cache, modList, toInstall, toUpdate, toRemove, &errorInfo))
+        {
+            success = false;
+            if (errors)
+                errors->append(errorInfo);
+        }
+    }
+    return success;
+}
+
+static const CachedVersion *targetVersion(const ModCache &cache, const SpecMod &sm)
+{
+    const CachedMod *cm = cache.mod(sm.id());
+    if (!cm)
+        return nullptr;
+    return sm.versionId().isEmpty() ? cm->latestVersion() : cm->version(sm.versionId());
+}
+
+static void addRemoval(SyncCost &cost, const InstalledMod &im)
+{
+    const int fileCount = im.knownFileCount();
+    if (fileCount >= 0)
+        cost.filesToDelete += fileCount;
+    else
+        cost.unknownSizeMods += 1;
+}
+
+static void addInstall(SyncCost &cost, const ModCache &cache, const ModList &modList, const SpecMod &sm)
+{
+    const CachedVersion *cv = targetVersion(cache, sm);
+    if (!cv)
+    {
+        cost.unknownSizeMods += 1;
+        return;
+    }
+
+    // The new install is always hashed, and the cached version too if it hasn't been already.
+    cost.modsToHash += 1;
+    const qint64 size = cv->knownSize();
+    if (size >= 0)
+    {
+        cost.bytesToCopy += size;
+        cost.filesToCreate += cv->knownFileCount();
+        cost.bytesToHash += cv->isHashed() ? size : 2 * size;
+    }
+    else
+        cost.unknownSizeMods += 1;
+
+    if (const InstalledMod *im = modList.mod(sm.id()))
+        addRemoval(cost, *im);
+}
+
+SyncCost SyncCost::estimate(const ModCache &cache, const ModList &modList,
+                            const QList<SpecMod> &toInstall, const QList<SpecMod> &toUpdate, const QList<InstalledMod> &toRemove)
+{
+    SyncCost cost;
+    for (const SpecMod &sm : toInstall)
+        addInstall(cost, cache, modList, sm);
+    for (const SpecMod &sm : toUpdate)
+        addInstall(cost, cache, modList, sm);
+    for (const InstalledMod &im : toRemove)
+        addRemoval(cost, im);
+
+    const qint64 copyRate = cache.throughput(ModCache::COPY_THROUGHPUT);
+    const qint64 hashRate = cache.throughput(ModCache::HASH_THROUGHPUT);
+    if ((cost.bytesToCopy == 0 || copyRate > 0) && (cost.bytesToHash == 0 || hashRate > 0))
+    {
+        cost.expectedMsecs = 0;
+        if (cost.bytesToCopy > 0)
+            cost.expectedMsecs += cost.bytesToCopy * 1000 / copyRate;
+        if (cost.bytesToHash > 0)
+            cost.expectedMsecs += cost.bytesToHash * 1000 / hashRate;
+    }
+
+    return cost;
+}
+
+QString SyncCost::toString() const
+{
+    const QLocale locale;
+    QStringList parts;
+    parts << QStringLiteral("copy %1 (%2 files)").arg(locale.formattedDataSize(bytesToCopy)).arg(filesToCreate);
+    parts << QStringLiteral("delete %1 files").arg(filesToDelete);
+    parts << QStringLiteral("hash %1 mods (%2)").arg(modsToHash).arg(locale.formattedDataSize(bytesToHash));
+    if (unknownSizeMods > 0)
+        parts << QStringLiteral("%1 mods of unknown size").arg(unknownSizeMods);
+
+    const QString duration = expectedMsecs >= 0
+            ? QStringLiteral("%1s").arg(expectedMsecs / 1000.0, 0, 'f', 1)
+            : QStringLiteral("unknown");
+    return QStringLiteral("%1. Expected time: %2").arg(parts.join(QStringLiteral(", ")), duration);
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,155 @@
+#ifndef IIMODMANAGER_MODSYNCPLAN_H
+#define IIMODMANAGER_MODSYNCPLAN_H
+
+#include "iimodman-lib_global.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+
+namespace iimodmanager {
+
+class InstalledMod;
+class ModCache;
+class ModList;
+class SpecMod;
+
+
+//! The change needed to bring a single mod to the state requested by a spec.
+struct IIMODMANLIBSHARED_EXPORT ModChange
+{
+    enum ChangeType {
+        //! No change. An uninstalled mod remains so. An installed mod remains installed.
+        //! The latter case may be further specified with PIN_CURRENT or PIN_LATEST to modify how this change reacts to cache changes.
+        NONE,
+        //! Like NONE, but specifically pinning the current installed version.
+        PIN_CURRENT,
+        //! Like NONE, but specifically pinning the latest available version.
+        //! Must have LATEST pin type.
+        PIN_LATEST,
+        INSTALL,
+        REMOVE,
+        //! Remove the currently installed mod, and re-install it with a different alias.
+        //! The installed version may change.
+        RE_ALIAS,
+        //! Install a different version of the mod (not necessarily newer).
+        //! The mod will be installed under the same alias/ID as the current installation.
+        UPDATE,
+
+        ACTIVE_CHANGE_MIN = INSTALL,
+    };
+    //! How this change specifies a version.
+    //! Controls how this pending change is affected by cache/installed updates.
+    enum VersionPinning {
+        //! Currently installed version.
+        CURRENT,
+        //! Latest available version.
+        LATEST,
+        //! Specific version.
+        PINNED,
+    };
+    //! Ways in which the spec couldn't be followed exactly. Each front end decides which of these are errors.
+    enum Issue {
+        NO_ISSUE = 0,
+        //! The mod is neither cached nor installed. The change is NONE.
+        NOT_FOUND = 0x1,
+        //! The mod has no downloaded versions. The installed version is kept, if there is one.
+        NOT_DOWNLOADED = 0x2,
+        //! The requested version isn't in the cache. The latest version is used instead.
+        VERSION_NOT_CACHED = 0x4,
+        //! The installed version that would be removed isn't saved in the cache.
+        REMOVES_UNCACHED = 0x8,
+        //! The spec is locked to a signature that the cached version doesn't have. The latest version is used instead.
+        //! For a locked line without a version ID, neither the installed mod nor any cached version has the signature,
+        //! and the installed mod is kept, or else the latest version is used.
+        LOCK_MISMATCH = 0x10,
+    };
+
+    QString modId;
+    QString modName;
+    QString alias;
+    QString versionId;
+    VersionPinning versionPin;
+    ChangeType type;
+    //! With VERSION_NOT_CACHED or LOCK_MISMATCH, the version that the spec asked for.
+    QString requestedVersionId;
+    //! Combination of Issue flags.
+    int issues;
+
+    ModChange(const QString &modId = QString())
+        : modId(modId), versionPin(CURRENT), type(NONE), issues(NO_ISSUE) {};
+
+    inline bool isValid() const { return !modId.isNull(); };
+    inline bool isNone() const { return type == NONE; };
+    inline bool isActive() const { return type >= ACTIVE_CHANGE_MIN; }
+    inline bool isUncachedMove() const { return type == RE_ALIAS && versionId.isEmpty(); }
+    inline bool hasIssue(Issue issue) const { return issues & issue; };
+
+    //! Determines the change for a single spec line.
+    //! A locked line matches the installed mod by its signature, whatever its cache version, and is only
+    //! installed from a cached version with the same signature.
+    static ModChange plan(const ModCache &cache, const ModList &modList, const SpecMod &specMod);
+
+    //! Appends the mod to the list for its kind of change, resolving the target version from the cache.
+    //! Returns false with a description if the change can no longer be applied. Inactive changes are ignored.
+    bool collect(const ModCache &cache, const ModList &modList,
+                 QList<SpecMod> *toInstall, QList<SpecMod> *toUpdate, QList<InstalledMod> *toRemove, QString *errorInfo = nullptr) const;
+};
+
+//! The changes needed to sync the installed mods to a spec, shared by the CLI and GUI front ends.
+//! Built in a single pass over the spec and the installed mods, using the cache's and mod list's indexes.
+struct IIMODMANLIBSHARED_EXPORT ModSyncPlan
+{
+    enum Scope {
+        //! Installed mods that aren't in the spec are removed.
+        SYNC,
+        //! Only mods in the spec are changed.
+        PARTIAL,
+    };
+
+    //! One change per mod: first the spec's mods in order, then any removals in install order.
+    //! If the spec lists a mod more than once, the last line wins.
+    QList<ModChange> changes;
+
+    //! Loads the details of each cached version the spec pins, where the cache only knows it by ID.
+    //! Call before planning, so that changes to non-latest versions can be described.
+    static void refreshPinnedVersions(ModCache &cache, const QList<SpecMod> &spec);
+    static ModSyncPlan build(const ModCache &cache, const ModList &modList, const QList<SpecMod> &spec, Scope scope = SYNC);
+
+    bool hasActiveChanges() const;
+    //! Collects every active change. Changes that can't be applied are described in errors.
+    bool collect(const ModCache &cache, const ModList &modList,
+                 QList<SpecMod> *toInstall, QList<SpecMod> *toUpdate, QList<InstalledMod> *toRemove, QStringList *errors = nullptr) const;
+};
+
+
+//! Estimated cost of applying a set of mod changes.
+//! Computed from cached sizes, without walking the cache or install folders.
+struct IIMODMANLIBSHARED_EXPORT SyncCost
+{
+    //! Bytes copied from the cache into the install.
+    qint64 bytesToCopy = 0;
+    int filesToCreate = 0;
+    int filesToDelete = 0;
+    //! Mods that will be hashed to match the new install with its cached version.
+    int modsToHash = 0;
+    qint64 bytesToHash = 0;
+    //! Affected mods whose size isn't known, and so aren't included in the totals.
+    int unknownSizeMods = 0;
+    //! Expected duration in milliseconds, or -1 if disk throughput hasn't been measured yet.
+    qint64 expectedMsecs = -1;
+
+    //! Estimates the cost of installing, updating, and removing the given mods.
+    //! Installing a mod that is already installed (such as under a different alias) also counts removing the current install.
+    static SyncCost estimate(const ModCache &cache, const ModList &modList,
+                             const QList<SpecMod> &toInstall, const QList<SpecMod> &toUpdate, const QList<InstalledMod> &toRemove);
+
+    //! A single-line human-readable summary.
+    QString toString() const;
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_MODSYNCPLAN_H
@@ -4,6 +4,16 @@
 
 namespace iimodmanager {
 
+QString formatVersionTime(const QDateTime &versionTime)
+{
+    return versionTime.toString(Qt::ISODate).replace(':', '_');
+}
+
+QDateTime parseVersionTime(const QString &versionId)
+{
+    return QDateTime::fromString(QString(versionId).left(20).replace('_', ':'), Qt::ISODate);
+}
+
 bool isVersionLessThan(const QString &left, const QString &right)
 {
     static const QRegularExpression versionRe(QStringLiteral("^v?(\\d+(?:\\.\\d+)*)([^\\d.]\\S*)?"));
@@ -1,11 +1,18 @@
 #ifndef MODVERSION_H
 #define MODVERSION_H
 
+#include "iimodman-lib_global.h"
+
+#include <QDateTime>
 #include <QString>
 
 namespace iimodmanager {
 
-    bool isVersionLessThan(const QString &left, const QString &right);
+    IIMODMANLIBSHARED_EXPORT bool isVersionLessThan(const QString &left, const QString &right);
+
+    //! Cache version IDs are the version's ISO8601 time, but with ':' replaced with '_' to be a valid folder name on Windows.
+    IIMODMANLIBSHARED_EXPORT QString formatVersionTime(const QDateTime &versionTime);
+    IIMODMANLIBSHARED_EXPORT QDateTime parseVersionTime(const QString &versionId);
 
 } // namespace iimodmanager
 
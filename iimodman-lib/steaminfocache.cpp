@@ -0,0 +1,172 @@
+#include "fileutils.h"
+#include "modmanconfig.h"
+#include "steaminfocache.h"
+
+#include <QDir>
+#include <QJsonObject>
+
+namespace iimodmanager {
+
+static const QString fileName = QStringLiteral("steaminfo.json");
+//! Validators are dropped after this long, as the details they validate will have long since expired.
+static const int validatorMaxAgeDays = 7;
+
+SteamInfoCache::SteamInfoCache(const ModManConfig &config)
+    : config_(config), dirty_(false)
+{}
+
+SteamModInfo SteamInfoCache::get(const QString &workshopId, bool *fresh)
+{
+    load();
+    auto it = entries_.constFind(workshopId);
+    if (it == entries_.constEnd())
+    {
+        if (fresh)
+            *fresh = false;
+        return SteamModInfo();
+    }
+
+    if (fresh)
+    {
+        const int ttl = config_.infoCacheTtl();
+        *fresh = ttl > 0 && it->fetched.secsTo(QDateTime::currentDateTimeUtc()) < ttl;
+    }
+    return it->info;
+}
+
+void SteamInfoCache::insert(const SteamModInfo &info)
+{
+    if (!info.valid())
+        return;
+    load();
+
+    Entry &entry = entries_[info.id];
+    entry.info = info;
+    entry.info.description.clear();
+    entry.fetched = QDateTime::currentDateTimeUtc();
+    dirty_ = true;
+}
+
+void SteamInfoCache::touch(const QString &workshopId)
+{
+    load();
+    auto it = entries_.find(workshopId);
+    if (it != entries_.end())
+    {
+        it->fetched = QDateTime::currentDateTimeUtc();
+        dirty_ = true;
+    }
+}
+
+bool SteamInfoCache::requestValidators(const QByteArray &requestKey, QByteArray *etag, QByteArray *lastModified)
+{
+    load();
+    auto it = validators_.constFind(requestKey);
+    if (it == validators_.constEnd())
+        return false;
+    *etag = it->etag;
+    *lastModified = it->lastModified;
+    return true;
+}
+
+void SteamInfoCache::setRequestValidators(const QByteArray &requestKey, const QByteArray &etag, const QByteArray &lastModified)
+{
+    load();
+    if (etag.isEmpty() && lastModified.isEmpty())
+    {
+        if (validators_.remove(requestKey))
+            dirty_ = true;
+        return;
+    }
+
+    validators_[requestKey] = {etag, lastModified, QDateTime::currentDateTimeUtc()};
+    dirty_ = true;
+}
+
+void SteamInfoCache::load()
+{
+    const QString cachePath = config_.cachePath();
+    if (loadedPath_ == cachePath)
+        return;
+    loadedPath_ = cachePath;
+    dirty_ = false;
+    entries_.clear();
+    validators_.clear();
+
+    const QString filePath = QDir(cachePath).filePath(fileName);
+    if (!QFileInfo::exists(filePath))
+        return;
+    const QJsonObject root = FileUtils::readJSON(filePath);
+
+    const QJsonObject mods = root.value("mods").toObject();
+    for (auto it = mods.constBegin(); it != mods.constEnd(); ++it)
+    {
+        const QJsonObject mod = it.value().toObject();
+        Entry entry;
+        entry.info.id = it.key();
+        entry.info.title = mod.value("title").toString();
+        entry.info.downloadUrl = mod.value("downloadUrl").toString();
+        entry.info.lastUpdated = QDateTime::fromSecsSinceEpoch(mod.value("timeUpdated").toVariant().toLongLong(), Qt::UTC);
+        entry.info.fileSize = mod.value("fileSize").toVariant().toLongLong();
+        entry.info.contentHandle = mod.value("contentHandle").toString();
+        if (entry.info.fileSize <= 0)
+            entry.info.fileSize = -1;
+        entry.fetched = QDateTime::fromSecsSinceEpoch(mod.value("fetched").toVariant().toLongLong(), Qt::UTC);
+        if (entry.info.downloadUrl.isEmpty())
+            continue;
+        entries_.insert(entry.info.id, entry);
+    }
+
+    const QJsonObject requests = root.value("requests").toObject();
+    for (auto it = requests.constBegin(); it != requests.constEnd(); ++it)
+    {
+        const QJsonObject request = it.value().toObject();
+        Validators validators;
+        validators.etag = request.value("etag").toString().toUtf8();
+        validators.lastModified = request.value("lastModified").toString().toUtf8();
+        validators.received = QDateTime::fromSecsSinceEpoch(request.value("received").toVariant().toLongLong(), Qt::UTC);
+        validators_.insert(it.key().toUtf8(), validators);
+    }
+}
+
+void SteamInfoCache::save()
+{
+    if (!dirty_ || loadedPath_.isEmpty())
+        return;
+
+    QJsonObject mods;
+    for (const Entry &entry : qAsConst(entries_))
+    {
+        QJsonObject mod;
+        mod.insert("title", entry.info.title);
+        mod.insert("downloadUrl", entry.info.downloadUrl);
+        mod.insert("timeUpdated", entry.info.lastUpdated.toSecsSinceEpoch());
+        if (entry.info.fileSize >= 0)
+            mod.insert("fileSize", entry.info.fileSize);
+        if (!entry.info.contentHandle.isEmpty())
+            mod.insert("contentHandle", entry.info.contentHandle);
+        mod.insert("fetched", entry.fetched.toSecsSinceEpoch());
+        mods.insert(entry.info.id, mod);
+    }
+
+    QJsonObject requests;
+    const QDateTime expiredTime = QDateTime::currentDateTimeUtc().addDays(-validatorMaxAgeDays);
+    for (auto it = validators_.constBegin(); it != validators_.constEnd(); ++it)
+    {
+        if (it->received < expiredTime)
+            continue;
+        QJsonObject request;
+        request.insert("etag", QString::fromUtf8(it->etag));
+        request.insert("lastModified", QString::fromUtf8(it->lastModified));
+        request.insert("received", it->received.toSecsSinceEpoch());
+        requests.insert(QString::fromUtf8(it.key()), request);
+    }
+
+    QJsonObject root;
+    root.insert("mods", mods);
+    root.insert("requests", requests);
+    if (QDir().mkpath(loadedPath_) && FileUtils::writeJSON(QDir(loadedPath_).filePath(fileName), root))
+        dirty_ = false;
+}
+
+} // namespace iimodmanager
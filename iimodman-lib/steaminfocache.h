@@ -0,0 +1,66 @@
+#ifndef IIMODMANAGER_STEAMINFOCACHE_H
+#define IIMODMANAGER_STEAMINFOCACHE_H
+
+#include "moddownloader.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+
+
+namespace iimodmanager {
+
+class ModManConfig;
+
+//! Workshop details from recent Steam API lookups, persisted in the cache folder.
+//! Lets repeated update checks skip the network while the details are younger than the configured TTL,
+//! and still return the last known details when Steam can't be reached.
+//! Descriptions aren't kept, as nothing that checks for updates uses them.
+class SteamInfoCache
+{
+public:
+    SteamInfoCache(const ModManConfig &config);
+
+    //! Returns the cached details for the given workshop ID, or invalid details if there are none.
+    //! If provided, fresh is set if the details were fetched within the configured TTL.
+    SteamModInfo get(const QString &workshopId, bool *fresh = nullptr);
+    //! Stores newly fetched details.
+    void insert(const SteamModInfo &info);
+    //! Marks the cached details as just fetched, after the server confirmed they're unchanged.
+    void touch(const QString &workshopId);
+
+    //! Retrieves the validators from the last response to an identical request, for a conditional request.
+    //! Returns false if there are none.
+    bool requestValidators(const QByteArray &requestKey, QByteArray *etag, QByteArray *lastModified);
+    void setRequestValidators(const QByteArray &requestKey, const QByteArray &etag, const QByteArray &lastModified);
+
+    //! Writes any changes to disk.
+    void save();
+
+private:
+    struct Entry
+    {
+        SteamModInfo info;
+        QDateTime fetched;
+    };
+    struct Validators
+    {
+        QByteArray etag;
+        QByteArray lastModified;
+        QDateTime received;
+    };
+
+    const ModManConfig &config_;
+    //! Cache folder the entries were loaded from. Reloaded if the configured folder changes.
+    QString loadedPath_;
+    bool dirty_;
+    QHash<QString, Entry> entries_;
+    QHash<QByteArray, Validators> validators_;
+
+    void load();
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_STEAMINFOCACHE_H
@@ -0,0 +1,239 @@
+#include "tracing.h"
+
+#ifdef IIMODMAN_TRACING
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace iimodmanager {
+
+Q_DECLARE_LOGGING_CATEGORY(tracing)
+Q_LOGGING_CATEGORY(tracing, "tracing", QtWarningMsg)
+
+//! Names the trace file to write.
+static const char traceVariable[] = "IIMODMAN_TRACE";
+
+const bool Tracing::enabled = qEnvironmentVariableIsSet(traceVariable);
+
+namespace {
+
+//! A thread's buffer is appended to the file once it holds this many bytes.
+const qsizetype batchBytes = 64 * 1024;
+//! All buffers are appended and the file flushed at least this often while events are being recorded.
+const qint64 flushIntervalNs = 250 * 1000 * 1000;
+
+//! Events recorded on one thread and not yet appended to the trace file.
+struct ThreadBuffer
+{
+    QMutex mutex;
+    //! Compact JSON events, separated by commas.
+    QByteArray events;
+};
+
+//! Collects events in a buffer per thread, and appends them to the trace file in batches: when a buffer fills,
+//! when the flush interval has passed since the last flush, and at exit. A killed process loses at most the events
+//! since the last flush. Uses the JSON Array Format, which viewers accept without the closing bracket.
+class TraceWriter
+{
+public:
+    TraceWriter()
+        : file_(qEnvironmentVariable(traceVariable)), pid_(QCoreApplication::applicationPid()), isFirst_(true)
+    {
+        clock_.start();
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            qCWarning(tracing).noquote() << "Failed to open trace file" << file_.fileName() << ":" << file_.errorString();
+        else
+            file_.write("[\n");
+    }
+
+    ~TraceWriter()
+    {
+        QMutexLocker locker(&mutex_);
+        flushBuffers();
+        if (file_.isOpen())
+            file_.write("\n]\n");
+    }
+
+    //! Nanoseconds since the trace started.
+    inline qint64 now() const { return clock_.nsecsElapsed(); }
+
+    void write(QJsonObject event)
+    {
+        ThreadBuffer &buffer = threadBuffer();
+        event["pid"] = pid_;
+        event["tid"] = threadId_;
+        const QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+
+        QByteArray batch;
+        {
+            QMutexLocker locker(&buffer.mutex);
+            if (!buffer.events.isEmpty())
+                buffer.events += ",\n";
+            buffer.events += json;
+            if (buffer.events.size() >= batchBytes)
+                batch.swap(buffer.events);
+        }
+        if (!batch.isEmpty())
+        {
+            QMutexLocker locker(&mutex_);
+            append(batch);
+        }
+
+        // Also writes out the buffers of threads that have gone quiet or finished.
+        qint64 flushNs = nextFlushNs_;
+        const qint64 nowNs = now();
+        if (nowNs >= flushNs && nextFlushNs_.compare_exchange_strong(flushNs, nowNs + flushIntervalNs))
+        {
+            QMutexLocker locker(&mutex_);
+            flushBuffers();
+        }
+    }
+
+    static TraceWriter &instance()
+    {
+        static TraceWriter writer;
+        return writer;
+    }
+
+private:
+    QFile file_;
+    QElapsedTimer clock_;
+    //! Guards the file and the list of buffers.
+    QMutex mutex_;
+    const qint64 pid_;
+    bool isFirst_;
+    std::atomic<int> nextThreadId_{1};
+    std::atomic<qint64> nextFlushNs_{flushIntervalNs};
+    //! Each thread's buffer. Buffers of finished threads are dropped once flushed.
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    //! Small sequential IDs read better in trace viewers than native thread handles.
+    static thread_local int threadId_;
+    static thread_local std::shared_ptr<ThreadBuffer> threadBuffer_;
+
+    //! The current thread's buffer. The first event on each thread also records the thread's name.
+    ThreadBuffer &threadBuffer()
+    {
+        if (!threadBuffer_)
+        {
+            threadId_ = nextThreadId_++;
+            const QString objectName = QThread::currentThread()->objectName();
+            QJsonObject args;
+            args["name"] = objectName.isEmpty() ? QStringLiteral("Thread %1").arg(threadId_) : objectName;
+            QJsonObject event;
+            event["ph"] = QStringLiteral("M");
+            event["name"] = QStringLiteral("thread_name");
+            event["pid"] = pid_;
+            event["tid"] = threadId_;
+            event["args"] = args;
+
+            threadBuffer_ = std::make_shared<ThreadBuffer>();
+            threadBuffer_->events = QJsonDocument(event).toJson(QJsonDocument::Compact);
+            QMutexLocker locker(&mutex_);
+            buffers_.push_back(threadBuffer_);
+        }
+        return *threadBuffer_;
+    }
+
+    //! Appends a batch of events. The caller holds mutex_.
+    void append(const QByteArray &batch)
+    {
+        if (!file_.isOpen())
+            return;
+        if (!isFirst_)
+            file_.write(",\n");
+        isFirst_ = false;
+        file_.write(batch);
+    }
+
+    //! Appends every thread's buffered events and flushes the file. The caller holds mutex_.
+    void flushBuffers()
+    {
+        for (auto it = buffers_.begin(); it != buffers_.end(); )
+        {
+            QByteArray batch;
+            {
+                QMutexLocker locker(&(*it)->mutex);
+                batch.swap((*it)->events);
+            }
+            if (!batch.isEmpty())
+                append(batch);
+            // Only this list still refers to the buffer once its thread has finished.
+            if (it->use_count() == 1)
+                it = buffers_.erase(it);
+            else
+                ++it;
+        }
+        if (file_.isOpen())
+            file_.flush();
+    }
+};
+
+thread_local int TraceWriter::threadId_ = 0;
+thread_local std::shared_ptr<ThreadBuffer> TraceWriter::threadBuffer_;
+
+double toMicroseconds(qint64 ns)
+{
+    return ns / 1000.0;
+}
+
+} // namespace
+
+void Tracing::Span::start(const char *category, const char *name, const QString &detail, Kind kind)
+{
+    end();
+    category_ = category;
+    name_ = name;
+    detail_ = detail;
+    kind_ = kind;
+    startNs_ = TraceWriter::instance().now();
+}
+
+void Tracing::Span::finish()
+{
+    TraceWriter &writer = TraceWriter::instance();
+    const qint64 endNs = writer.now();
+
+    QJsonObject event;
+    event["name"] = QString::fromLatin1(name_);
+    event["cat"] = QString::fromLatin1(category_);
+    if (!detail_.isEmpty())
+        event["args"] = QJsonObject{{"detail", detail_}};
+
+    if (kind_ == ASYNC)
+    {
+        // Async begin and end events are matched up by ID.
+        static std::atomic<qint64> nextId{1};
+        event["id"] = nextId++;
+        event["ph"] = QStringLiteral("b");
+        event["ts"] = toMicroseconds(startNs_);
+        writer.write(event);
+        event.remove("args");
+        event["ph"] = QStringLiteral("e");
+        event["ts"] = toMicroseconds(endNs);
+        writer.write(event);
+    }
+    else
+    {
+        event["ph"] = QStringLiteral("X");
+        event["ts"] = toMicroseconds(startNs_);
+        event["dur"] = toMicroseconds(endNs - startNs_);
+        writer.write(event);
+    }
+
+    startNs_ = -1;
+    detail_.clear();
+}
+
+} // namespace iimodmanager
+
+#endif // IIMODMAN_TRACING
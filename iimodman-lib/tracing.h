@@ -0,0 +1,90 @@
+#ifndef IIMODMANAGER_TRACING_H
+#define IIMODMANAGER_TRACING_H
+
+#include "iimodman-lib_global.h"
+
+#include <QString>
+
+
+namespace iimodmanager {
+
+//! Records spans of library operations as Chrome trace events, for viewing in chrome://tracing or Perfetto.
+//!
+//! Compiled in with IIMODMAN_TRACING, and then only recorded if the IIMODMAN_TRACE environment variable names the output file.
+//! Without the compile flag, spans are empty and the macros expand to nothing.
+namespace Tracing {
+
+#ifdef IIMODMAN_TRACING
+//! True if a trace file was requested when the library was loaded.
+IIMODMANLIBSHARED_EXPORT extern const bool enabled;
+#else
+constexpr bool enabled = false;
+#endif
+
+//! A span of time, recorded when it ends.
+//! Spans that end on the stack frame they began in nest like a call stack. Async spans may overlap others on the same thread,
+//! such as a download that runs across several event loop iterations.
+class IIMODMANLIBSHARED_EXPORT Span
+{
+public:
+    enum Kind
+    {
+        SCOPED,
+        ASYNC,
+    };
+
+#ifdef IIMODMAN_TRACING
+    Span() : category_(nullptr), name_(nullptr), kind_(SCOPED), startNs_(-1) {}
+    //! The category and name must be string literals. The detail is shown as the span's argument.
+    Span(const char *category, const char *name, const QString &detail = QString()) : Span() { begin(category, name, detail); }
+    ~Span() { end(); }
+
+    inline void begin(const char *category, const char *name, const QString &detail = QString(), Kind kind = SCOPED)
+    {
+        if (enabled)
+            start(category, name, detail, kind);
+    }
+    inline void end()
+    {
+        if (startNs_ >= 0)
+            finish();
+    }
+
+private:
+    const char *category_;
+    const char *name_;
+    QString detail_;
+    Kind kind_;
+    qint64 startNs_;
+
+    void start(const char *category, const char *name, const QString &detail, Kind kind);
+    void finish();
+#else
+    inline void begin(const char *, const char *, const QString & = QString(), Kind = SCOPED) {}
+    inline void end() {}
+#endif
+
+    Q_DISABLE_COPY(Span)
+};
+
+} // namespace Tracing
+
+} // namespace iimodmanager
+
+#define IIMODMAN_TRACE_CONCAT_(a, b) a##b
+#define IIMODMAN_TRACE_CONCAT(a, b) IIMODMAN_TRACE_CONCAT_(a, b)
+
+#ifdef IIMODMAN_TRACING
+//! Records a span from here to the end of the enclosing scope.
+#define IIMODMAN_TRACE_SCOPE(category, name) \
+    iimodmanager::Tracing::Span IIMODMAN_TRACE_CONCAT(traceSpan_, __LINE__)(category, name)
+//! Like IIMODMAN_TRACE_SCOPE, with a detail such as a mod ID or path. The detail is only evaluated while tracing.
+#define IIMODMAN_TRACE_SCOPE_DETAIL(category, name, detail) \
+    iimodmanager::Tracing::Span IIMODMAN_TRACE_CONCAT(traceSpan_, __LINE__)( \
+            category, name, iimodmanager::Tracing::enabled ? QString(detail) : QString())
+#else
+#define IIMODMAN_TRACE_SCOPE(category, name)
+#define IIMODMAN_TRACE_SCOPE_DETAIL(category, name, detail)
+#endif
+
+#endif // IIMODMANAGER_TRACING_H
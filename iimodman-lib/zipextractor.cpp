@@ -0,0 +1,294 @@
+#include "fileutils.h"
+#include "modcache.h"
+#include "zipextractor.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <quazip.h>
+#include <quazipfile.h>
+#include <vector>
+
+namespace iimodmanager {
+
+//! Archives smaller than this are extracted on the calling thread, as starting workers would cost more than it saves.
+static const qint64 minParallelBytes = 4 * 1024 * 1024;
+//! Beyond this, extraction is limited by the disk rather than by inflating.
+static const int maxDefaultWorkers = 4;
+static const qint64 copyBufferSize = 64 * 1024;
+
+namespace {
+
+struct Entry
+{
+    //! Cleaned path relative to the output folder.
+    QString path;
+    bool isDir = false;
+    //! Set if a later entry has the same path, and would overwrite this one.
+    bool superseded = false;
+    //! Set if the path can't be written on this system.
+    bool skipped = false;
+    qint64 size = 0;
+    QFile::Permissions permissions;
+};
+
+struct Range
+{
+    qsizetype begin;
+    qsizetype end;
+    bool ok = true;
+    QString errorInfo;
+};
+
+} // namespace
+
+static bool fail(QString *errorInfo, const QString &msg)
+{
+    qCWarning(modcache).noquote() << "Unzip Failed:" << msg;
+    if (errorInfo)
+        *errorInfo = msg;
+    return false;
+}
+
+static bool listEntries(QuaZip &zip, QList<Entry> *entries, QString *errorInfo)
+{
+    entries->reserve(zip.getEntriesCount());
+    QHash<QString, qsizetype> indexByPath;
+    for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile())
+    {
+        QuaZipFileInfo64 info;
+        if (!zip.getCurrentFileInfo(&info))
+            return fail(errorInfo, QStringLiteral("Failed to read zip entry: error %1").arg(zip.getZipError()));
+
+        Entry entry;
+        entry.path = FileUtils::cleanArchivePath(info.name);
+        if (entry.path.isNull())
+            return fail(errorInfo, QStringLiteral("Unsafe path in zip archive: %1").arg(info.name));
+        entry.isDir = info.name.endsWith('/') || info.name.endsWith('\\') || entry.path.isEmpty();
+        entry.size = static_cast<qint64>(info.uncompressedSize);
+        entry.permissions = info.getPermissions();
+
+        if (!FileUtils::isWritableArchivePath(entry.path))
+        {
+            // Kept in the list, which matches the order of the zip's entries.
+            qCWarning(modcache).noquote() << "Skipping zip entry that can't be written on this system:" << info.name;
+            entry.skipped = true;
+        }
+        else if (!entry.isDir)
+        {
+            auto it = indexByPath.find(entry.path);
+            if (it != indexByPath.end())
+            {
+                (*entries)[*it].superseded = true;
+                *it = entries->size();
+            }
+            else
+                indexByPath.insert(entry.path, entries->size());
+        }
+        entries->append(entry);
+    }
+    if (zip.getZipError() != UNZ_OK)
+        return fail(errorInfo, QStringLiteral("Failed to read zip directory: error %1").arg(zip.getZipError()));
+    return true;
+}
+
+//! Creates every folder the entries need up front, so that workers never race to create the same folder.
+static bool createDirs(const QDir &outputDir, const QList<Entry> &entries, QString *errorInfo)
+{
+    QSet<QString> dirs;
+    for (const Entry &entry : entries)
+    {
+        if (entry.skipped)
+            continue;
+        if (entry.isDir)
+            dirs.insert(entry.path);
+        else
+        {
+            const qsizetype slash = entry.path.lastIndexOf('/');
+            dirs.insert(slash < 0 ? QString() : entry.path.left(slash));
+        }
+    }
+    for (const QString &dir : qAsConst(dirs))
+    {
+        const QString path = dir.isEmpty() ? outputDir.path() : outputDir.filePath(dir);
+        if (!QDir().mkpath(path))
+            return fail(errorInfo, QStringLiteral("Failed to create folder %1").arg(path));
+    }
+    return true;
+}
+
+//! Splits the entries into at most the given number of contiguous ranges with similar total sizes.
+static std::vector<Range> splitRanges(const QList<Entry> &entries, qint64 totalSize, int count)
+{
+    std::vector<Range> ranges;
+    qsizetype begin = 0;
+    qint64 accumulated = 0;
+    for (qsizetype i = 0; i < entries.size(); ++i)
+    {
+        accumulated += entries.at(i).size;
+        const int nextRange = static_cast<int>(ranges.size()) + 1;
+        if (nextRange < count && accumulated >= totalSize * nextRange / count)
+        {
+            ranges.push_back({begin, i + 1});
+            begin = i + 1;
+        }
+    }
+    if (begin < entries.size() || ranges.empty())
+        ranges.push_back({begin, entries.size()});
+    return ranges;
+}
+
+static bool extractEntry(QuaZip &zip, const Entry &entry, const QString &filePath, QByteArray &buffer, QString *errorInfo)
+{
+    QuaZipFile in(&zip);
+    if (!in.open(QIODevice::ReadOnly))
+        return fail(errorInfo, QStringLiteral("Failed to open zip entry %1: error %2").arg(entry.path).arg(in.getZipError()));
+
+    QFile out(filePath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return fail(errorInfo, QStringLiteral("Failed to create %1: %2").arg(filePath, out.errorString()));
+
+    while (true)
+    {
+        const qint64 read = in.read(buffer.data(), buffer.size());
+        if (read < 0)
+            return fail(errorInfo, QStringLiteral("Corrupt compressed data in %1").arg(entry.path));
+        if (read == 0)
+            break;
+        if (out.write(buffer.constData(), read) != read)
+            return fail(errorInfo, QStringLiteral("Failed to write %1: %2").arg(filePath, out.errorString()));
+    }
+
+    // Closing verifies the checksum.
+    in.close();
+    if (in.getZipError() != UNZ_OK)
+        return fail(errorInfo, QStringLiteral("Checksum mismatch in %1").arg(entry.path));
+    out.close();
+    if (out.error() != QFileDevice::NoError)
+        return fail(errorInfo, QStringLiteral("Failed to write %1: %2").arg(filePath, out.errorString()));
+
+    if (entry.permissions != QFile::Permissions())
+        out.setPermissions(entry.permissions | QFile::ReadOwner | QFile::WriteOwner);
+    return true;
+}
+
+static void extractRange(QuaZip &zip, const QDir &outputDir, const QList<Entry> &entries, Range &range)
+{
+    // Stepping through the central directory is cheap, as it doesn't touch the entries' data.
+    bool more = zip.goToFirstFile();
+    for (qsizetype i = 0; more && i < range.begin; ++i)
+        more = zip.goToNextFile();
+
+    QByteArray buffer(copyBufferSize, Qt::Uninitialized);
+    for (qsizetype i = range.begin; i < range.end; ++i, more = zip.goToNextFile())
+    {
+        if (!more)
+        {
+            range.ok = fail(&range.errorInfo, QStringLiteral("Zip archive changed during extraction"));
+            return;
+        }
+        const Entry &entry = entries.at(i);
+        if (entry.isDir || entry.superseded || entry.skipped)
+            continue;
+        if (!extractEntry(zip, entry, outputDir.filePath(entry.path), buffer, &range.errorInfo))
+        {
+            range.ok = false;
+            return;
+        }
+    }
+}
+
+static void extractRangeFromFile(const QString &zipPath, const QDir &outputDir, const QList<Entry> &entries, Range &range)
+{
+    QuaZip zip(zipPath);
+    if (!zip.open(QuaZip::mdUnzip))
+    {
+        range.ok = fail(&range.errorInfo, QStringLiteral("Failed to open %1: error %2").arg(zipPath).arg(zip.getZipError()));
+        return;
+    }
+    extractRange(zip, outputDir, entries, range);
+}
+
+static bool checkRanges(const std::vector<Range> &ranges, QString *errorInfo)
+{
+    for (const Range &range : ranges)
+    {
+        if (!range.ok)
+        {
+            if (errorInfo)
+                *errorInfo = range.errorInfo;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ZipExtractor::extractFile(const QString &zipPath, const QString &outputPath, QString *errorInfo, int maxWorkers)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<Entry> entries;
+    {
+        QuaZip zip(zipPath);
+        if (!zip.open(QuaZip::mdUnzip))
+            return fail(errorInfo, QStringLiteral("Failed to open %1: error %2").arg(zipPath).arg(zip.getZipError()));
+        if (!listEntries(zip, &entries, errorInfo))
+            return false;
+    }
+
+    const QDir outputDir(outputPath);
+    if (!createDirs(outputDir, entries, errorInfo))
+        return false;
+
+    qint64 totalSize = 0;
+    for (const Entry &entry : qAsConst(entries))
+        totalSize += entry.size;
+    int workers = maxWorkers > 0 ? maxWorkers : qMin(QThread::idealThreadCount(), maxDefaultWorkers);
+    if (totalSize < minParallelBytes)
+        workers = 1;
+    std::vector<Range> ranges = splitRanges(entries, totalSize, qMax(1, workers));
+
+    // The calling thread takes the first range, and is otherwise idle while waiting.
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, static_cast<int>(ranges.size()) - 1));
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        Range *range = &ranges[i];
+        pool.start([&zipPath, &outputDir, &entries, range] { extractRangeFromFile(zipPath, outputDir, entries, *range); });
+    }
+    extractRangeFromFile(zipPath, outputDir, entries, ranges[0]);
+    pool.waitForDone();
+
+    if (!checkRanges(ranges, errorInfo))
+        return false;
+    qCDebug(modcache).noquote() << "Unzip" << entries.size() << "entries," << totalSize << "bytes on" << ranges.size() << "workers in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool ZipExtractor::extractDevice(QIODevice &device, const QString &outputPath, QString *errorInfo)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QuaZip zip(&device);
+    if (!zip.open(QuaZip::mdUnzip))
+        return fail(errorInfo, QStringLiteral("Failed to open zip archive: error %1").arg(zip.getZipError()));
+
+    QList<Entry> entries;
+    const QDir outputDir(outputPath);
+    if (!listEntries(zip, &entries, errorInfo) || !createDirs(outputDir, entries, errorInfo))
+        return false;
+
+    std::vector<Range> ranges{{0, entries.size()}};
+    extractRange(zip, outputDir, entries, ranges[0]);
+    if (!checkRanges(ranges, errorInfo))
+        return false;
+    qCDebug(modcache).noquote() << "Unzip" << entries.size() << "entries from device in" << timer.elapsed() << "ms";
+    return true;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,29 @@
+#ifndef IIMODMANAGER_ZIPEXTRACTOR_H
+#define IIMODMANAGER_ZIPEXTRACTOR_H
+
+#include "iimodman-lib_global.h"
+
+class QIODevice;
+class QString;
+
+
+namespace iimodmanager {
+
+//! Extracts complete zip archives, inflating their entries on several threads at once.
+//! Entry names are normalized as they're written, so archives zipped with Windows separators
+//! extract into the correct subfolders.
+//! Exported for benchmarking, but not part of the installed headers.
+namespace ZipExtractor
+{
+    //! Extracts the zip file at the given path into the output folder, which should be empty.
+    //! Large archives are split into ranges of entries of similar size, and each range is extracted by a
+    //! worker with its own handle on the file. Blocks until all workers are done.
+    //! Set maxWorkers to limit the number of threads, or 0 to choose based on the available cores.
+    IIMODMANLIBSHARED_EXPORT bool extractFile(const QString &zipPath, const QString &outputPath, QString *errorInfo = nullptr, int maxWorkers = 0);
+    //! Extracts a zip archive from a device that can't be reopened, such as an in-memory buffer, on the calling thread.
+    IIMODMANLIBSHARED_EXPORT bool extractDevice(QIODevice &device, const QString &outputPath, QString *errorInfo = nullptr);
+}
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_ZIPEXTRACTOR_H
@@ -0,0 +1,343 @@
+#include "fileutils.h"
+#include "modcache.h"
+#include "zipstreamextractor.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <zlib.h>
+
+namespace iimodmanager {
+
+static const quint32 localHeaderSignature = 0x04034b50;
+static const quint32 descriptorSignature = 0x08074b50;
+static const quint32 centralHeaderSignature = 0x02014b50;
+static const quint32 endOfCentralDirSignature = 0x06054b50;
+static const qsizetype localHeaderSize = 30;
+
+static const quint16 encryptedFlag = 0x0001;
+static const quint16 utf8NameFlag = 0x0800;
+static const quint16 storedMethod = 0;
+static const quint16 deflatedMethod = 8;
+static const quint16 zip64ExtraId = 0x0001;
+
+static inline quint16 readU16(const char *p)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(p));
+}
+
+static inline quint32 readU32(const char *p)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(p));
+}
+
+static bool hasZip64Extra(const char *extra, quint16 length)
+{
+    qsizetype pos = 0;
+    while (pos + 4 <= length)
+    {
+        if (readU16(extra + pos) == zip64ExtraId)
+            return true;
+        pos += 4 + readU16(extra + pos + 2);
+    }
+    return false;
+}
+
+ZipStreamExtractor::ZipStreamExtractor(const QString &outputPath)
+    : outputPath_(outputPath), state_(READING), step_(HEADER_STEP), inflater_(std::make_unique<z_stream_s>())
+{
+    inflateBuffer_.resize(64 * 1024);
+    if (inflateInit2(inflater_.get(), -MAX_WBITS) != Z_OK)
+    {
+        inflater_.reset();
+        fail(QStringLiteral("Failed to initialize zlib"));
+    }
+}
+
+ZipStreamExtractor::~ZipStreamExtractor()
+{
+    if (inflater_)
+        inflateEnd(inflater_.get());
+}
+
+ZipStreamExtractor::State ZipStreamExtractor::write(const QByteArray &data)
+{
+    if (state_ != READING)
+        return state_;
+
+    buffer_.append(data);
+    qsizetype pos = 0;
+    bool progressed = true;
+    while (progressed && state_ == READING)
+    {
+        switch (step_)
+        {
+        case HEADER_STEP:
+            progressed = readHeader(&pos);
+            break;
+        case DATA_STEP:
+            progressed = readData(&pos);
+            break;
+        case DESCRIPTOR_STEP:
+            progressed = readDescriptor(&pos);
+            break;
+        }
+    }
+    buffer_.remove(0, pos);
+    return state_;
+}
+
+bool ZipStreamExtractor::finish(QString *errorInfo)
+{
+    if (state_ == READING)
+        fail(QStringLiteral("Zip archive ended unexpectedly"));
+    if (errorInfo && state_ != DONE)
+        *errorInfo = errorDetail_;
+    return state_ == DONE;
+}
+
+bool ZipStreamExtractor::readHeader(qsizetype *pos)
+{
+    const qsizetype available = buffer_.size() - *pos;
+    const char *p = buffer_.constData() + *pos;
+    if (available < 4)
+        return false;
+
+    const quint32 signature = readU32(p);
+    if (signature == centralHeaderSignature || signature == endOfCentralDirSignature)
+    {
+        // Everything after the last entry only describes the entries again.
+        state_ = DONE;
+        buffer_.clear();
+        *pos = 0;
+        return false;
+    }
+    if (signature != localHeaderSignature)
+    {
+        unsupported(QStringLiteral("Unrecognized data before zip entry"));
+        return false;
+    }
+    if (available < localHeaderSize)
+        return false;
+
+    const quint16 nameLength = readU16(p + 26);
+    const quint16 extraLength = readU16(p + 28);
+    if (available < localHeaderSize + nameLength + extraLength)
+        return false;
+
+    Entry entry;
+    entry.flags = readU16(p + 6);
+    entry.method = readU16(p + 8);
+    entry.crc = readU32(p + 14);
+    entry.compressedSize = readU32(p + 18);
+    entry.uncompressedSize = readU32(p + 22);
+    const QByteArray rawName(p + localHeaderSize, nameLength);
+    entry.name = (entry.flags & utf8NameFlag) ? QString::fromUtf8(rawName) : QString::fromLocal8Bit(rawName);
+
+    if (entry.flags & encryptedFlag)
+    {
+        unsupported(QStringLiteral("Encrypted entry %1").arg(entry.name));
+        return false;
+    }
+    if (entry.method != storedMethod && entry.method != deflatedMethod)
+    {
+        unsupported(QStringLiteral("Unsupported compression method %1 for %2").arg(entry.method).arg(entry.name));
+        return false;
+    }
+    if (entry.compressedSize == 0xFFFFFFFF || entry.uncompressedSize == 0xFFFFFFFF
+            || hasZip64Extra(p + localHeaderSize + nameLength, extraLength))
+    {
+        unsupported(QStringLiteral("Zip64 entry %1").arg(entry.name));
+        return false;
+    }
+    if (entry.method == storedMethod && entry.hasDescriptor())
+    {
+        // The end of the data can't be found without the central directory.
+        unsupported(QStringLiteral("Stored entry %1 without a size").arg(entry.name));
+        return false;
+    }
+    if (entry.method == deflatedMethod && !entry.hasDescriptor() && entry.compressedSize == 0)
+        entry.method = storedMethod;
+
+    const QString relativePath = FileUtils::cleanArchivePath(entry.name);
+    if (relativePath.isNull())
+    {
+        fail(QStringLiteral("Unsafe path in zip archive: %1").arg(entry.name));
+        return false;
+    }
+    *pos += localHeaderSize + nameLength + extraLength;
+
+    entry_ = entry;
+    const bool isDir = entry.name.endsWith('/') || entry.name.endsWith('\\');
+    const QString outputPath = QDir(outputPath_).filePath(relativePath);
+    if (!FileUtils::isWritableArchivePath(relativePath))
+    {
+        qCWarning(modcache).noquote() << "Skipping zip entry that can't be written on this system:" << entry.name;
+        entry_.skipped = true;
+    }
+    else if (isDir || relativePath.isEmpty())
+    {
+        if (!QDir().mkpath(outputPath))
+        {
+            fail(QStringLiteral("Failed to create folder %1").arg(outputPath));
+            return false;
+        }
+    }
+    else
+    {
+        file_.setFileName(outputPath);
+        if (!QDir().mkpath(QFileInfo(outputPath).absolutePath()) || !file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            fail(QStringLiteral("Failed to create %1: %2").arg(outputPath, file_.errorString()));
+            return false;
+        }
+    }
+
+    if (entry_.method == deflatedMethod)
+        inflateReset(inflater_.get());
+    step_ = DATA_STEP;
+    return true;
+}
+
+bool ZipStreamExtractor::readData(qsizetype *pos)
+{
+    const qsizetype available = buffer_.size() - *pos;
+    const char *p = buffer_.constData() + *pos;
+
+    if (entry_.method == storedMethod)
+    {
+        const qint64 size = qMin<qint64>(available, entry_.compressedSize - entry_.compressedRead);
+        if (size > 0 && !writeOutput(p, size))
+            return false;
+        entry_.compressedRead += size;
+        *pos += size;
+        if (entry_.compressedRead < entry_.compressedSize)
+            return false;
+        return finishEntry();
+    }
+
+    qint64 inputSize = available;
+    if (!entry_.hasDescriptor())
+        inputSize = qMin<qint64>(inputSize, entry_.compressedSize - entry_.compressedRead);
+
+    z_stream_s *z = inflater_.get();
+    z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(p));
+    z->avail_in = static_cast<uInt>(inputSize);
+    int ret;
+    do
+    {
+        z->next_out = reinterpret_cast<Bytef *>(inflateBuffer_.data());
+        z->avail_out = static_cast<uInt>(inflateBuffer_.size());
+        ret = inflate(z, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        {
+            fail(QStringLiteral("Corrupt compressed data in %1").arg(entry_.name));
+            return false;
+        }
+        const qint64 produced = inflateBuffer_.size() - z->avail_out;
+        if (produced > 0 && !writeOutput(inflateBuffer_.constData(), produced))
+            return false;
+    } while (ret == Z_OK && z->avail_out == 0);
+
+    const qint64 consumed = inputSize - z->avail_in;
+    entry_.compressedRead += consumed;
+    *pos += consumed;
+
+    if (ret != Z_STREAM_END)
+    {
+        if (!entry_.hasDescriptor() && entry_.compressedRead >= entry_.compressedSize)
+            fail(QStringLiteral("Truncated compressed data in %1").arg(entry_.name));
+        return false;
+    }
+    if (entry_.hasDescriptor())
+    {
+        step_ = DESCRIPTOR_STEP;
+        return true;
+    }
+    return finishEntry();
+}
+
+bool ZipStreamExtractor::readDescriptor(qsizetype *pos)
+{
+    const qsizetype available = buffer_.size() - *pos;
+    const char *p = buffer_.constData() + *pos;
+    if (available < 4)
+        return false;
+
+    // The descriptor signature is optional.
+    const qsizetype offset = readU32(p) == descriptorSignature ? 4 : 0;
+    if (available < offset + 12)
+        return false;
+
+    entry_.crc = readU32(p + offset);
+    entry_.compressedSize = readU32(p + offset + 4);
+    entry_.uncompressedSize = readU32(p + offset + 8);
+    *pos += offset + 12;
+    return finishEntry();
+}
+
+bool ZipStreamExtractor::writeOutput(const char *data, qint64 size)
+{
+    if (!entry_.skipped && !file_.isOpen())
+    {
+        fail(QStringLiteral("Folder entry %1 has contents").arg(entry_.name));
+        return false;
+    }
+    entry_.uncompressedWritten += size;
+    if (!entry_.hasDescriptor() && entry_.uncompressedWritten > entry_.uncompressedSize)
+    {
+        fail(QStringLiteral("%1 is larger than its recorded size").arg(entry_.name));
+        return false;
+    }
+    entry_.actualCrc = crc32(entry_.actualCrc, reinterpret_cast<const Bytef *>(data), static_cast<uInt>(size));
+    if (!entry_.skipped && file_.write(data, size) != size)
+    {
+        fail(QStringLiteral("Failed to write %1: %2").arg(file_.fileName(), file_.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool ZipStreamExtractor::finishEntry()
+{
+    if (file_.isOpen())
+    {
+        file_.close();
+        if (file_.error() != QFileDevice::NoError)
+        {
+            fail(QStringLiteral("Failed to write %1: %2").arg(file_.fileName(), file_.errorString()));
+            return false;
+        }
+    }
+    if (entry_.compressedRead != entry_.compressedSize
+            || entry_.uncompressedWritten != entry_.uncompressedSize
+            || entry_.actualCrc != entry_.crc)
+    {
+        fail(QStringLiteral("Checksum mismatch in %1").arg(entry_.name));
+        return false;
+    }
+
+    entry_ = Entry();
+    step_ = HEADER_STEP;
+    return true;
+}
+
+ZipStreamExtractor::State ZipStreamExtractor::unsupported(const QString &reason)
+{
+    qCDebug(modcache).noquote() << "Unzip Stream Unsupported" << outputPath_ << reason;
+    errorDetail_ = reason;
+    state_ = UNSUPPORTED;
+    file_.close();
+    return state_;
+}
+
+ZipStreamExtractor::State ZipStreamExtractor::fail(const QString &reason)
+{
+    qCWarning(modcache).noquote() << "Unzip Stream Failed" << outputPath_ << reason;
+    errorDetail_ = reason;
+    state_ = FAILED;
+    file_.close();
+    return state_;
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,100 @@
+#ifndef IIMODMANAGER_ZIPSTREAMEXTRACTOR_H
+#define IIMODMANAGER_ZIPSTREAMEXTRACTOR_H
+
+#include "iimodman-lib_global.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <memory>
+
+struct z_stream_s;
+
+
+namespace iimodmanager {
+
+//! Extracts a zip archive while its contents are still arriving, by reading each entry's local header in turn.
+//! Stops at the central directory, so the archive never needs to be complete on disk.
+//!
+//! Some layouts can't be read front-to-back: stored entries whose size is only given after their data,
+//! encrypted entries, Zip64 entries, and leading non-zip data. These are reported as UNSUPPORTED,
+//! so the caller can fall back to extracting from a complete file.
+//!
+//! Not thread-safe, but may be used from any single thread at a time.
+//! Exported for benchmarking, but not part of the installed headers.
+class IIMODMANLIBSHARED_EXPORT ZipStreamExtractor
+{
+public:
+    enum State
+    {
+        //! Waiting for more data.
+        READING,
+        //! Reached the central directory. All entries have been extracted.
+        DONE,
+        //! The archive needs random access to extract. Nothing further will be extracted.
+        UNSUPPORTED,
+        //! The archive is corrupt or unsafe to extract. Nothing further will be extracted.
+        FAILED,
+    };
+
+    ZipStreamExtractor(const QString &outputPath);
+    ~ZipStreamExtractor();
+
+    //! Extracts as much as possible from the next chunk of the archive. Returns the resulting state.
+    State write(const QByteArray &data);
+    //! Marks the end of the archive. Returns true if it was completely extracted.
+    bool finish(QString *errorInfo = nullptr);
+
+    inline State state() const { return state_; };
+    inline const QString &errorDetail() const { return errorDetail_; };
+
+private:
+    enum Step
+    {
+        HEADER_STEP,
+        DATA_STEP,
+        DESCRIPTOR_STEP,
+    };
+
+    struct Entry
+    {
+        QString name;
+        //! Read and checked, but not written, as its path can't be written on this system.
+        bool skipped = false;
+        quint16 flags = 0;
+        quint16 method = 0;
+        quint32 crc = 0;
+        quint32 compressedSize = 0;
+        quint32 uncompressedSize = 0;
+
+        quint32 actualCrc = 0;
+        qint64 compressedRead = 0;
+        qint64 uncompressedWritten = 0;
+
+        inline bool hasDescriptor() const { return flags & 0x08; };
+    };
+
+    QString outputPath_;
+    State state_;
+    QString errorDetail_;
+    Step step_;
+    //! Received bytes that haven't been consumed yet.
+    QByteArray buffer_;
+    Entry entry_;
+    QFile file_;
+    std::unique_ptr<z_stream_s> inflater_;
+    QByteArray inflateBuffer_;
+
+    bool readHeader(qsizetype *pos);
+    bool readData(qsizetype *pos);
+    bool readDescriptor(qsizetype *pos);
+    bool writeOutput(const char *data, qint64 size);
+    bool finishEntry();
+
+    State unsupported(const QString &reason);
+    State fail(const QString &reason);
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_ZIPSTREAMEXTRACTOR_H
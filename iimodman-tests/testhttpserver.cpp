@@ -0,0 +1,143 @@
+#include "testhttpserver.h"
+
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTimer>
+#include <memory>
+
+namespace iimodmanager {
+
+static QByteArray reasonPhrase(int status)
+{
+    switch (status)
+    {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 404: return "Not Found";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+    }
+}
+
+TestHttpServer::Response TestHttpServer::Response::content(const Request &request, const QByteArray &body, const QByteArray &etag)
+{
+    Response response;
+    if (!etag.isEmpty())
+        response.headers.append({"ETag", etag});
+
+    static const QRegularExpression rangeRe(QStringLiteral("^bytes=(\\d+)-$"));
+    const QRegularExpressionMatch match = rangeRe.match(QString::fromLatin1(request.headers.value("range")));
+    const QByteArray ifRange = request.headers.value("if-range");
+    if (!match.hasMatch() || (!ifRange.isEmpty() && ifRange != etag))
+    {
+        response.body = body;
+        return response;
+    }
+
+    const qint64 first = match.captured(1).toLongLong();
+    if (first >= body.size())
+    {
+        response.status = 416;
+        response.headers.append({"Content-Range", "bytes */" + QByteArray::number(body.size())});
+        return response;
+    }
+    response.status = 206;
+    response.headers.append({"Content-Range", QStringLiteral("bytes %1-%2/%3").arg(first).arg(body.size() - 1).arg(body.size()).toLatin1()});
+    response.body = body.mid(first);
+    return response;
+}
+
+TestHttpServer::Response TestHttpServer::Response::status(int status)
+{
+    Response response;
+    response.status = status;
+    response.body = reasonPhrase(status);
+    return response;
+}
+
+TestHttpServer::TestHttpServer(QObject *parent)
+    : QObject(parent), activeCount_(0), maxActiveCount_(0)
+{
+    connect(&server_, &QTcpServer::newConnection, this, &TestHttpServer::acceptConnections);
+}
+
+bool TestHttpServer::listen()
+{
+    return server_.listen(QHostAddress::LocalHost);
+}
+
+QUrl TestHttpServer::url(const QString &path) const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1%2").arg(server_.serverPort()).arg(path));
+}
+
+int TestHttpServer::requestCount(const QByteArray &path) const
+{
+    int count = 0;
+    for (const Request &request : requests_)
+        if (request.path == path)
+            ++count;
+    return count;
+}
+
+void TestHttpServer::acceptConnections()
+{
+    while (QTcpSocket *socket = server_.nextPendingConnection())
+    {
+        auto buffer = std::make_shared<QByteArray>();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, buffer] { readRequest(socket, buffer.get()); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void TestHttpServer::readRequest(QTcpSocket *socket, QByteArray *buffer)
+{
+    buffer->append(socket->readAll());
+    const int headerEnd = buffer->indexOf("\r\n\r\n");
+    if (headerEnd < 0)
+        return;
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    const QList<QByteArray> lines = buffer->left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    Request request;
+    request.method = requestLine.value(0);
+    request.path = requestLine.value(1);
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        const int colon = lines.at(i).indexOf(':');
+        if (colon > 0)
+            request.headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+    }
+    requests_.append(request);
+
+    ++activeCount_;
+    maxActiveCount_ = qMax(maxActiveCount_, activeCount_);
+    connect(socket, &QTcpSocket::disconnected, this, [this] { --activeCount_; });
+
+    const Response response = handler_ ? handler_(request) : Response::status(404);
+    if (response.stall && response.dropAfter < 0)
+        return;
+    QTimer::singleShot(response.delayMs, socket, [this, socket, response] { respond(socket, response); });
+}
+
+void TestHttpServer::respond(QTcpSocket *socket, const Response &response)
+{
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n";
+    for (const auto &header : response.headers)
+        head += header.first + ": " + header.second + "\r\n";
+    head += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    head += "Connection: close\r\n\r\n";
+
+    socket->write(head);
+    socket->write(response.dropAfter >= 0 ? response.body.left(response.dropAfter) : response.body);
+    if (response.stall)
+        return;
+    // Waits for everything written so far to be sent.
+    socket->disconnectFromHost();
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,82 @@
+#ifndef IIMODMANAGER_TESTHTTPSERVER_H
+#define IIMODMANAGER_TESTHTTPSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QTcpServer>
+#include <QUrl>
+#include <functional>
+
+class QTcpSocket;
+
+
+namespace iimodmanager {
+
+//! Stand-in HTTP/1.1 server on the loopback interface, for exercising network code without the internet.
+//! Answers GET requests through a handler, with optional faults: delays, stalls and dropped connections.
+//! Every response closes its connection, so each request is counted separately.
+class TestHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request
+    {
+        QByteArray method;
+        QByteArray path;
+        //! Keyed by lower-case header name.
+        QHash<QByteArray, QByteArray> headers;
+    };
+
+    struct Response
+    {
+        int status = 200;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray body;
+        //! Milliseconds to wait before responding.
+        int delayMs = 0;
+        //! Closes the connection after this many bytes of the body, or -1 to send all of it.
+        //! The full Content-Length is still sent, so the client sees a truncated response.
+        qint64 dropAfter = -1;
+        //! Leaves the connection open until the client gives up: without responding at all,
+        //! or after the first dropAfter bytes of the body if that's set.
+        bool stall = false;
+
+        //! Serves the content, honouring Range and If-Range headers like a static file server.
+        static Response content(const Request &request, const QByteArray &body, const QByteArray &etag = QByteArray());
+        static Response status(int status);
+    };
+    using Handler = std::function<Response(const Request &)>;
+
+    explicit TestHttpServer(QObject *parent = nullptr);
+
+    bool listen();
+    QUrl url(const QString &path) const;
+    void setHandler(Handler handler) { handler_ = std::move(handler); }
+
+    inline const QList<Request> &requests() const { return requests_; }
+    //! Requests received for the given path.
+    int requestCount(const QByteArray &path) const;
+    //! Responses in progress, from receiving the request until the connection closed.
+    inline int activeCount() const { return activeCount_; }
+    //! Highest number of responses in progress at once.
+    inline int maxActiveCount() const { return maxActiveCount_; }
+
+private:
+    QTcpServer server_;
+    Handler handler_;
+    QList<Request> requests_;
+    int activeCount_;
+    int maxActiveCount_;
+
+    void acceptConnections();
+    void readRequest(QTcpSocket *socket, QByteArray *buffer);
+    void respond(QTcpSocket *socket, const Response &response);
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_TESTHTTPSERVER_H
@@ -0,0 +1,126 @@
+#include "testutils.h"
+
+#include <QDateTime>
+#include <QtEndian>
+#include <moddownloader.h>
+#include <zlib.h>
+
+namespace iimodmanager {
+
+static void appendU16(QByteArray &data, quint16 value)
+{
+    value = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void appendU32(QByteArray &data, quint32 value)
+{
+    value = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+QByteArray makeZip(const QList<QPair<QString, QByteArray>> &entries, ZipLayout layout)
+{
+    static const quint16 descriptorFlag = 0x0008;
+    static const quint16 utf8NameFlag = 0x0800;
+    const quint16 flags = layout == SIZES_AFTER ? utf8NameFlag | descriptorFlag : utf8NameFlag;
+    static const quint16 dosDate = (0 << 9) | (1 << 5) | 1;  // 1980-01-01
+
+    QByteArray zip;
+    QByteArray centralDir;
+    for (const auto &entry : entries)
+    {
+        const QByteArray name = entry.first.toUtf8();
+        const QByteArray &content = entry.second;
+        const quint32 crc = crc32(0, reinterpret_cast<const Bytef *>(content.constData()), static_cast<uInt>(content.size()));
+        const quint32 offset = static_cast<quint32>(zip.size());
+
+        const bool sizesFirst = layout == SIZES_FIRST;
+        appendU32(zip, 0x04034b50);
+        appendU16(zip, 20);
+        appendU16(zip, flags);
+        appendU16(zip, 0);  // Stored.
+        appendU16(zip, 0);
+        appendU16(zip, dosDate);
+        appendU32(zip, sizesFirst ? crc : 0);
+        appendU32(zip, sizesFirst ? content.size() : 0);
+        appendU32(zip, sizesFirst ? content.size() : 0);
+        appendU16(zip, name.size());
+        appendU16(zip, 0);
+        zip.append(name);
+        zip.append(content);
+        if (!sizesFirst)
+        {
+            appendU32(zip, 0x08074b50);
+            appendU32(zip, crc);
+            appendU32(zip, content.size());
+            appendU32(zip, content.size());
+        }
+
+        appendU32(centralDir, 0x02014b50);
+        appendU16(centralDir, 20);
+        appendU16(centralDir, 20);
+        appendU16(centralDir, flags);
+        appendU16(centralDir, 0);
+        appendU16(centralDir, 0);
+        appendU16(centralDir, dosDate);
+        appendU32(centralDir, crc);
+        appendU32(centralDir, content.size());
+        appendU32(centralDir, content.size());
+        appendU16(centralDir, name.size());
+        appendU16(centralDir, 0);
+        appendU16(centralDir, 0);
+        appendU16(centralDir, 0);
+        appendU16(centralDir, 0);
+        appendU32(centralDir, 0);
+        appendU32(centralDir, offset);
+        centralDir.append(name);
+    }
+
+    const quint32 centralDirOffset = static_cast<quint32>(zip.size());
+    zip.append(centralDir);
+    appendU32(zip, 0x06054b50);
+    appendU16(zip, 0);
+    appendU16(zip, 0);
+    appendU16(zip, entries.size());
+    appendU16(zip, entries.size());
+    appendU32(zip, centralDir.size());
+    appendU32(zip, centralDirOffset);
+    appendU16(zip, 0);
+    return zip;
+}
+
+QByteArray makeModZip(const QString &name, qint64 scriptSize, ZipLayout layout)
+{
+    QByteArray script = QStringLiteral("-- %1\n").arg(name).toUtf8();
+    script.append(QByteArray(qMax<qint64>(0, scriptSize - script.size()), '-'));
+    return makeZip({
+                       {QStringLiteral("modinfo.txt"), QStringLiteral("name = %1\nversion = 1.0\n").arg(name).toUtf8()},
+                       {QStringLiteral("scripts/modinit.lua"), script},
+                   }, layout);
+}
+
+SteamModInfo testModInfo(int index, const QUrl &downloadUrl, qint64 fileSize)
+{
+    SteamModInfo info;
+    info.id = QString::number(1000 + index);
+    info.title = QStringLiteral("Test Mod %1").arg(index);
+    info.downloadUrl = downloadUrl.toString();
+    info.lastUpdated = QDateTime(QDate(2021, 1, 1), QTime(0, 0), Qt::UTC).addDays(index);
+    info.fileSize = fileSize;
+    return info;
+}
+
+TestFolder::TestFolder()
+    : config(dir.filePath("config.ini"))
+{
+    config.setCachePath(dir.filePath("cache"));
+    config.setDownloadMirrors({});
+    config.setDownloadStreaming(true);
+    config.setRequestRate(0);
+    config.setRequestTimeout(10);
+    config.setMaxRetries(0);
+    config.setRetryDelay(10);
+}
+
+} // namespace iimodmanager
@@ -0,0 +1,44 @@
+#ifndef IIMODMANAGER_TESTUTILS_H
+#define IIMODMANAGER_TESTUTILS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <modmanconfig.h>
+
+
+namespace iimodmanager {
+
+struct SteamModInfo;
+
+//! How a test zip records each entry's size.
+enum ZipLayout
+{
+    //! In the local header, so that the zip can be extracted as it streams in.
+    SIZES_FIRST,
+    //! Only after each entry's data, so that the zip can only be extracted from a complete file.
+    SIZES_AFTER,
+};
+
+//! A zip of uncompressed entries.
+QByteArray makeZip(const QList<QPair<QString, QByteArray>> &entries, ZipLayout layout = SIZES_FIRST);
+//! A zip that looks like a mod: a modinfo.txt, and a script padded to the given size.
+QByteArray makeModZip(const QString &name, qint64 scriptSize = 1024, ZipLayout layout = SIZES_FIRST);
+//! Steam details for a mod version served from the given URL.
+SteamModInfo testModInfo(int index, const QUrl &downloadUrl, qint64 fileSize);
+
+//! Settings and cache in a scratch folder, tuned for tests: no rate limit, no retries, and short delays.
+struct TestFolder
+{
+    TestFolder();
+
+    QTemporaryDir dir;
+    ModManConfig config;
+};
+
+} // namespace iimodmanager
+
+#endif // IIMODMANAGER_TESTUTILS_H
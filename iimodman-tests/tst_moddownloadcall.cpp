@@ -0,0 +1,261 @@
+#include "testhttpserver.h"
+#include "testutils.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+#include <modcache.h>
+#include <moddownloader.h>
+
+using namespace iimodmanager;
+
+class TestModDownloadCall : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void streamsDownload();
+    void unstreamableContinuesFromSavedBytes();
+    void resumesDroppedConnection_data();
+    void resumesDroppedConnection();
+    void completePartialDownloadIsNotFetchedAgain();
+    void streamingResumesEarlierSession();
+    void failedMirrorRestartsFromSteam_data();
+    void failedMirrorRestartsFromSteam();
+    void changedZipRestartsDownload_data();
+    void changedZipRestartsDownload();
+
+private:
+    std::unique_ptr<TestFolder> folder;
+    std::unique_ptr<TestHttpServer> server;
+
+    //! Downloads the mod and waits for the call to finish.
+    //! If provided, modName is set to the name of the mod as extracted.
+    bool download(const SteamModInfo &info, ModCache &cache, QString *errorInfo, DownloadMetrics *metrics = nullptr, QString *modName = nullptr);
+};
+
+void TestModDownloadCall::init()
+{
+    folder = std::make_unique<TestFolder>();
+    QVERIFY(folder->dir.isValid());
+    server = std::make_unique<TestHttpServer>();
+    QVERIFY(server->listen());
+}
+
+bool TestModDownloadCall::download(const SteamModInfo &info, ModCache &cache, QString *errorInfo, DownloadMetrics *metrics, QString *modName)
+{
+    ModDownloader downloader(folder->config);
+    ModDownloadCall *call = downloader.modDownloadCall(cache);
+    QSignalSpy finishedSpy(call, &ModDownloadCall::finished);
+    call->start(info);
+    if (!finishedSpy.wait(10000))
+    {
+        *errorInfo = QStringLiteral("Timed out");
+        return false;
+    }
+    *errorInfo = call->errorDetail();
+    if (metrics)
+        *metrics = call->metrics();
+    const CachedVersion *version = call->resultVersion();
+    if (version && modName)
+        *modName = version->info().name();
+    return version != nullptr;
+}
+
+void TestModDownloadCall::streamsDownload()
+{
+    const QByteArray zip = makeModZip("Streamed", 64 * 1024);
+    server->setHandler([&zip](const TestHttpServer::Request &request) {
+        return TestHttpServer::Response::content(request, zip);
+    });
+
+    ModCache cache(folder->config);
+    QString errorInfo;
+    DownloadMetrics metrics;
+    QVERIFY2(download(testModInfo(1, server->url("/mod.zip"), zip.size()), cache, &errorInfo, &metrics), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), 1);
+    QCOMPARE(metrics.bytes, qint64(zip.size()));
+    // Nothing is left behind for a later attempt to resume.
+    QVERIFY(QDir(folder->dir.filePath("cache/.iimodman-partial")).isEmpty());
+}
+
+void TestModDownloadCall::unstreamableContinuesFromSavedBytes()
+{
+    const QByteArray zip = makeModZip("Unstreamable", 256 * 1024, SIZES_AFTER);
+    server->setHandler([&zip](const TestHttpServer::Request &request) {
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, zip);
+        if (!request.headers.contains("range"))
+        {
+            // Hold the rest back, so that the extractor gives up on streaming partway.
+            response.dropAfter = zip.size() / 2;
+            response.stall = true;
+        }
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    QString errorInfo;
+    QVERIFY2(download(testModInfo(1, server->url("/mod.zip"), zip.size()), cache, &errorInfo), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), 2);
+    const QByteArray range = server->requests().at(1).headers.value("range");
+    QVERIFY2(range.startsWith("bytes=") && range != "bytes=0-", range.constData());
+}
+
+void TestModDownloadCall::resumesDroppedConnection_data()
+{
+    QTest::addColumn<bool>("streaming");
+    QTest::newRow("streamed") << true;
+    QTest::newRow("spooled") << false;
+}
+
+void TestModDownloadCall::resumesDroppedConnection()
+{
+    QFETCH(bool, streaming);
+    folder->config.setDownloadStreaming(streaming);
+    folder->config.setMaxRetries(1);
+    const QByteArray zip = makeModZip("Dropped", 256 * 1024);
+    const qint64 dropAfter = zip.size() / 3;
+    server->setHandler([&zip, dropAfter](const TestHttpServer::Request &request) {
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, zip);
+        if (!request.headers.contains("range"))
+            response.dropAfter = dropAfter;
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    QString errorInfo;
+    DownloadMetrics metrics;
+    QVERIFY2(download(testModInfo(1, server->url("/mod.zip"), zip.size()), cache, &errorInfo, &metrics), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), 2);
+    QCOMPARE(server->requests().at(1).headers.value("range"), "bytes=" + QByteArray::number(dropAfter) + '-');
+    QCOMPARE(metrics.retries, 1);
+    // Only the missing bytes were sent again.
+    QCOMPARE(metrics.bytes, qint64(zip.size()));
+}
+
+void TestModDownloadCall::completePartialDownloadIsNotFetchedAgain()
+{
+    folder->config.setDownloadStreaming(false);
+    const QByteArray zip = makeModZip("Complete");
+    server->setHandler([&zip](const TestHttpServer::Request &request) {
+        return TestHttpServer::Response::content(request, zip);
+    });
+
+    // Left by a session that exited after the transfer, but before extracting.
+    const SteamModInfo info = testModInfo(1, server->url("/mod.zip"), zip.size());
+    QDir partialDir(folder->dir.filePath("cache/.iimodman-partial"));
+    QVERIFY(partialDir.mkpath("."));
+    QFile partialFile(partialDir.filePath(QStringLiteral("%1-%2.zip.part").arg(info.id).arg(info.lastUpdated.toSecsSinceEpoch())));
+    QVERIFY(partialFile.open(QIODevice::WriteOnly));
+    partialFile.write(zip);
+    partialFile.close();
+
+    ModCache cache(folder->config);
+    QString errorInfo;
+    QVERIFY2(download(info, cache, &errorInfo), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), 1);
+    QCOMPARE(server->requests().at(0).headers.value("range"), "bytes=" + QByteArray::number(zip.size()) + '-');
+    QVERIFY(!partialFile.exists());
+}
+
+void TestModDownloadCall::streamingResumesEarlierSession()
+{
+    QVERIFY(folder->config.downloadStreaming());
+    const QByteArray zip = makeModZip("Interrupted", 256 * 1024);
+    const qint64 savedSize = zip.size() * 19 / 20;
+    server->setHandler([&zip](const TestHttpServer::Request &request) {
+        return TestHttpServer::Response::content(request, zip);
+    });
+
+    // Left by a session that was interrupted near the end of the transfer.
+    const SteamModInfo info = testModInfo(1, server->url("/mod.zip"), zip.size());
+    QDir partialDir(folder->dir.filePath("cache/.iimodman-partial"));
+    QVERIFY(partialDir.mkpath("."));
+    QFile partialFile(partialDir.filePath(QStringLiteral("%1-%2.zip.part").arg(info.id).arg(info.lastUpdated.toSecsSinceEpoch())));
+    QVERIFY(partialFile.open(QIODevice::WriteOnly));
+    partialFile.write(zip.left(savedSize));
+    partialFile.close();
+
+    ModCache cache(folder->config);
+    QString errorInfo;
+    DownloadMetrics metrics;
+    QString modName;
+    QVERIFY2(download(info, cache, &errorInfo, &metrics, &modName), qPrintable(errorInfo));
+    QCOMPARE(modName, QStringLiteral("Interrupted"));
+    QCOMPARE(server->requests().size(), 1);
+    QCOMPARE(server->requests().at(0).headers.value("range"), "bytes=" + QByteArray::number(savedSize) + '-');
+    // Only the missing bytes were fetched.
+    QCOMPARE(metrics.bytes, zip.size() - savedSize);
+    QVERIFY(!partialFile.exists());
+}
+
+void TestModDownloadCall::failedMirrorRestartsFromSteam_data()
+{
+    QTest::addColumn<bool>("streaming");
+    QTest::newRow("streamed") << true;
+    QTest::newRow("spooled") << false;
+}
+
+void TestModDownloadCall::failedMirrorRestartsFromSteam()
+{
+    QFETCH(bool, streaming);
+    folder->config.setDownloadStreaming(streaming);
+    folder->config.setDownloadMirrors({server->url("/mirror").toString()});
+    // Different builds of the same size, so that only the checksums would catch a spliced zip.
+    const QByteArray mirrorZip = makeModZip("Mirror Build", 64 * 1024);
+    const QByteArray steamZip = makeModZip("Steam Build!", 64 * 1024);
+    QCOMPARE(mirrorZip.size(), steamZip.size());
+    server->setHandler([&mirrorZip, &steamZip](const TestHttpServer::Request &request) {
+        if (!request.path.startsWith("/mirror/"))
+            return TestHttpServer::Response::content(request, steamZip);
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, mirrorZip);
+        response.dropAfter = mirrorZip.size() / 2;
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    const SteamModInfo info = testModInfo(1, server->url("/steam.zip"), steamZip.size());
+    QString errorInfo, modName;
+    QVERIFY2(download(info, cache, &errorInfo, nullptr, &modName), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), 2);
+    QCOMPARE(server->requests().at(0).path, "/mirror/" + QStringLiteral("%1-%2.zip").arg(info.id).arg(info.lastUpdated.toSecsSinceEpoch()).toLatin1());
+    QCOMPARE(server->requests().at(1).path, QByteArray("/steam.zip"));
+    QVERIFY(!server->requests().at(1).headers.contains("range"));
+    QCOMPARE(modName, QStringLiteral("Steam Build!"));
+}
+
+void TestModDownloadCall::changedZipRestartsDownload_data()
+{
+    QTest::addColumn<bool>("streaming");
+    QTest::addColumn<int>("expectedRequests");
+    // A stream can't rewind its extractor, so it asks for the new zip again.
+    QTest::newRow("streamed") << true << 3;
+    QTest::newRow("spooled") << false << 2;
+}
+
+void TestModDownloadCall::changedZipRestartsDownload()
+{
+    QFETCH(bool, streaming);
+    QFETCH(int, expectedRequests);
+    folder->config.setDownloadStreaming(streaming);
+    folder->config.setMaxRetries(2);
+    const QByteArray oldZip = makeModZip("Old Build", 64 * 1024);
+    const QByteArray newZip = makeModZip("New Build", 64 * 1024);
+    server->setHandler([this, &oldZip, &newZip](const TestHttpServer::Request &request) {
+        if (server->requests().size() > 1)
+            return TestHttpServer::Response::content(request, newZip, "\"new\"");
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, oldZip, "\"old\"");
+        response.dropAfter = oldZip.size() / 2;
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    QString errorInfo, modName;
+    QVERIFY2(download(testModInfo(1, server->url("/mod.zip"), newZip.size()), cache, &errorInfo, nullptr, &modName), qPrintable(errorInfo));
+    QCOMPARE(server->requests().size(), expectedRequests);
+    QCOMPARE(server->requests().at(1).headers.value("if-range"), QByteArray("\"old\""));
+    QCOMPARE(modName, QStringLiteral("New Build"));
+}
+
+QTEST_GUILESS_MAIN(TestModDownloadCall)
+#include "tst_moddownloadcall.moc"
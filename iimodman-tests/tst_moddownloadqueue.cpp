@@ -0,0 +1,151 @@
+#include "testhttpserver.h"
+#include "testutils.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+#include <modcache.h>
+#include <moddownloader.h>
+
+using namespace iimodmanager;
+
+class TestModDownloadQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void limitsConcurrency_data();
+    void limitsConcurrency();
+    void reportsInQueueOrder();
+    void reportsFailures();
+
+private:
+    std::unique_ptr<TestFolder> folder;
+    std::unique_ptr<TestHttpServer> server;
+    QHash<QByteArray, QByteArray> zips;
+
+    QList<SteamModInfo> serveMods(int count);
+};
+
+void TestModDownloadQueue::init()
+{
+    folder = std::make_unique<TestFolder>();
+    QVERIFY(folder->dir.isValid());
+    server = std::make_unique<TestHttpServer>();
+    QVERIFY(server->listen());
+    zips.clear();
+}
+
+QList<SteamModInfo> TestModDownloadQueue::serveMods(int count)
+{
+    QList<SteamModInfo> infos;
+    for (int i = 0; i < count; ++i)
+    {
+        const QByteArray path = QStringLiteral("/mod%1.zip").arg(i).toLatin1();
+        zips.insert(path, makeModZip(QStringLiteral("Mod %1").arg(i)));
+        infos.append(testModInfo(i, server->url(path), zips.value(path).size()));
+    }
+    return infos;
+}
+
+void TestModDownloadQueue::limitsConcurrency_data()
+{
+    QTest::addColumn<int>("concurrency");
+    QTest::addColumn<int>("hostConcurrency");
+    QTest::addColumn<int>("expectedActive");
+
+    QTest::newRow("total limit") << 3 << 8 << 3;
+    QTest::newRow("host limit") << 4 << 2 << 2;
+    QTest::newRow("serial") << 1 << 4 << 1;
+}
+
+void TestModDownloadQueue::limitsConcurrency()
+{
+    QFETCH(int, concurrency);
+    QFETCH(int, hostConcurrency);
+    QFETCH(int, expectedActive);
+
+    folder->config.setDownloadConcurrency(concurrency);
+    folder->config.setDownloadHostConcurrency(hostConcurrency);
+    const QList<SteamModInfo> infos = serveMods(6);
+    // Long enough that every allowed transfer is in progress at once.
+    server->setHandler([this](const TestHttpServer::Request &request) {
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, zips.value(request.path));
+        response.delayMs = 150;
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    ModDownloader downloader(folder->config);
+    ModDownloadQueue *queue = downloader.downloadQueue(cache);
+    QSignalSpy finishedSpy(queue, &ModDownloadQueue::finished);
+    queue->start(infos);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+    QCOMPARE(server->maxActiveCount(), expectedActive);
+    QCOMPARE(server->requests().size(), infos.size());
+    QCOMPARE(queue->summary().downloaded, infos.size());
+    for (int i = 0; i < infos.size(); ++i)
+        QVERIFY2(queue->resultVersion(i), qPrintable(queue->errorDetail(i)));
+}
+
+void TestModDownloadQueue::reportsInQueueOrder()
+{
+    folder->config.setDownloadConcurrency(4);
+    folder->config.setDownloadHostConcurrency(4);
+    const QList<SteamModInfo> infos = serveMods(4);
+    // The first mod finishes last.
+    server->setHandler([this](const TestHttpServer::Request &request) {
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, zips.value(request.path));
+        response.delayMs = request.path == "/mod0.zip" ? 400 : 20;
+        return response;
+    });
+
+    ModCache cache(folder->config);
+    ModDownloader downloader(folder->config);
+    ModDownloadQueue *queue = downloader.downloadQueue(cache);
+    QList<int> completed;
+    QList<int> reported;
+    connect(queue, &ModDownloadQueue::downloadCompleted, this, [&completed](int index) { completed.append(index); });
+    connect(queue, &ModDownloadQueue::downloadFinished, this, [&completed, &reported](int index) {
+        // Reported only once it and everything queued before it are done.
+        QVERIFY(completed.contains(index));
+        reported.append(index);
+    });
+    QSignalSpy finishedSpy(queue, &ModDownloadQueue::finished);
+    queue->start(infos);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+    QCOMPARE(reported, QList<int>({0, 1, 2, 3}));
+    QCOMPARE(completed.size(), 4);
+    QCOMPARE(completed.last(), 0);
+}
+
+void TestModDownloadQueue::reportsFailures()
+{
+    folder->config.setDownloadConcurrency(2);
+    const QList<SteamModInfo> infos = serveMods(3);
+    server->setHandler([this](const TestHttpServer::Request &request) {
+        if (request.path == "/mod1.zip")
+            return TestHttpServer::Response::status(404);
+        return TestHttpServer::Response::content(request, zips.value(request.path));
+    });
+
+    ModCache cache(folder->config);
+    ModDownloader downloader(folder->config);
+    ModDownloadQueue *queue = downloader.downloadQueue(cache);
+    QSignalSpy reportedSpy(queue, &ModDownloadQueue::downloadFinished);
+    QSignalSpy finishedSpy(queue, &ModDownloadQueue::finished);
+    queue->start(infos);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+    QCOMPARE(reportedSpy.count(), 3);
+    QVERIFY(queue->resultVersion(0));
+    QVERIFY(!queue->resultVersion(1));
+    QVERIFY(!queue->errorDetail(1).isEmpty());
+    QVERIFY(queue->resultVersion(2));
+    QCOMPARE(queue->summary().failed, 1);
+}
+
+QTEST_GUILESS_MAIN(TestModDownloadQueue)
+#include "tst_moddownloadqueue.moc"
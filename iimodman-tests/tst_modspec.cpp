@@ -0,0 +1,93 @@
+#include <QtTest>
+#include <modspec.h>
+
+using namespace iimodmanager;
+
+class TestModSpec : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parsesLines_data();
+    void parsesLines();
+};
+
+//! The parsed fields of each spec mod, in order.
+static QStringList describe(const QList<SpecMod> &mods)
+{
+    QStringList result;
+    for (const SpecMod &sm : mods)
+        result << QStringList({sm.id(), sm.alias(), sm.versionId(), sm.name()}).join('|');
+    return result;
+}
+
+//! Parses a line at a time, as each line is read and simplified by QTextStream.
+static QStringList describeByLine(QByteArray content)
+{
+    if (content.startsWith("\xEF\xBB\xBF"))
+        content.remove(0, 3);
+
+    QList<SpecMod> mods;
+    for (const QByteArray &bytes : content.split('\n'))
+    {
+        const QString line = QString::fromUtf8(bytes).simplified();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        if (std::optional<SpecMod> sm = SpecMod::fromSpecString(line))
+            mods.append(*sm);
+    }
+    return describe(mods);
+}
+
+void TestModSpec::parsesLines_data()
+{
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<QStringList>("expected");
+
+    const QStringList twoMods = {"workshop-1001|||Mod 1", "workshop-1002|renamed|2021-01-02T00_00_00Z|Mod 2"};
+    QTest::newRow("LF")
+            << QByteArray("workshop-1001::::Mod 1\nworkshop-1002:renamed:2021-01-02T00_00_00Z::Mod 2\n")
+            << twoMods;
+    QTest::newRow("CRLF")
+            << QByteArray("workshop-1001::::Mod 1\r\nworkshop-1002:renamed:2021-01-02T00_00_00Z::Mod 2\r\n")
+            << twoMods;
+    QTest::newRow("no final newline")
+            << QByteArray("workshop-1001::::Mod 1\nworkshop-1002:renamed:2021-01-02T00_00_00Z::Mod 2")
+            << twoMods;
+    QTest::newRow("byte order mark")
+            << QByteArray("\xEF\xBB\xBFworkshop-1001::::Mod 1\r\n")
+            << QStringList({"workshop-1001|||Mod 1"});
+    QTest::newRow("tabs")
+            << QByteArray("\tworkshop-1001::::Mod\t1\t\n")
+            << QStringList({"workshop-1001|||Mod 1"});
+    QTest::newRow("repeated spaces")
+            << QByteArray("  workshop-1001::::Mod   1  \r\n")
+            << QStringList({"workshop-1001|||Mod 1"});
+    QTest::newRow("non-ASCII name")
+            << QByteArray("workshop-1001::::Mod \xC3\xA9t\xC3\xA9  \xE2\x98\x85\n")
+            << QStringList({QString::fromUtf8("workshop-1001|||Mod \xC3\xA9t\xC3\xA9 \xE2\x98\x85")});
+    QTest::newRow("comments")
+            << QByteArray("# Mods\nworkshop-1001::::Mod 1\n  # workshop-1002::::Mod 2\r\n#workshop-1003::::Mod 3")
+            << QStringList({"workshop-1001|||Mod 1"});
+    QTest::newRow("blank lines")
+            << QByteArray("\n\nworkshop-1001::::Mod 1\n\n \t \r\n\r\n")
+            << QStringList({"workshop-1001|||Mod 1"});
+    QTest::newRow("empty")
+            << QByteArray()
+            << QStringList();
+}
+
+void TestModSpec::parsesLines()
+{
+    QFETCH(QByteArray, content);
+    QFETCH(QStringList, expected);
+
+    ModSpec spec;
+    QVERIFY(spec.appendFromFile(content));
+    QCOMPARE(describe(spec.mods()), expected);
+    // Same as reading and simplifying each line separately.
+    QCOMPARE(describe(spec.mods()), describeByLine(content));
+}
+
+QTEST_GUILESS_MAIN(TestModSpec)
+#include "tst_modspec.moc"
@@ -0,0 +1,619 @@
+#include "testutils.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QtTest>
+#include <modcache.h>
+#include <modlist.h>
+#include <modspec.h>
+#include <modsyncplan.h>
+#include <modversion.h>
+
+using namespace iimodmanager;
+
+class TestModSyncPlan : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void installsLatest();
+    void updatesToLatest();
+    void pinsLatest();
+    void pinsVersion();
+    void pinsCurrent();
+    void reAliases();
+    void removesUnlisted();
+    void lastLineWins();
+    void flagsNotFound();
+    void flagsNotDownloaded();
+    void flagsVersionNotCached();
+    void flagsRemovesUncached();
+    void flagsLockMismatch();
+    void collectsChanges();
+    void locksAsHashAndSize();
+    void ignoresInvalidLock_data();
+    void ignoresInvalidLock();
+    void pinsLockedInstall();
+    void locksUncachedInstall();
+    void installsLockedVersionWithoutId();
+    void checksLockedSpecWithoutHashing();
+
+private:
+    std::unique_ptr<TestFolder> folder;
+    std::unique_ptr<ModCache> cache;
+    std::unique_ptr<ModList> modList;
+
+    bool addVersion(int index, int day);
+    bool install(int index, int day, const QString &alias = QString());
+    bool installUncached(const QString &folderName);
+    void refresh();
+    ModSyncPlan plan(const QStringList &lines, ModSyncPlan::Scope scope = ModSyncPlan::SYNC) const;
+};
+
+//! Mod ID of a test mod, as used by testModInfo.
+static QString modId(int index)
+{
+    return QStringLiteral("workshop-%1").arg(1000 + index);
+}
+
+//! Cache version ID of a test version updated on the given day.
+static QString versionId(int day)
+{
+    return formatVersionTime(QDateTime(QDate(2021, 1, day), QTime(0, 0), Qt::UTC));
+}
+
+static bool writeFile(const QString &path, const QByteArray &content)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+//! A mod folder with a modinfo.txt, and a script whose size depends on the version.
+static bool writeModFolder(const QString &path, const QString &name, int day)
+{
+    return QDir().mkpath(path + "/scripts")
+            && writeFile(path + "/modinfo.txt", QStringLiteral("name = %1\nversion = %2\n").arg(name).arg(day).toUtf8())
+            && writeFile(path + "/scripts/modinit.lua", QByteArray(100 * day, '-'));
+}
+
+void TestModSyncPlan::init()
+{
+    folder = std::make_unique<TestFolder>();
+    QVERIFY(folder->dir.isValid());
+    const QString installPath = folder->dir.filePath("install");
+    QVERIFY(QDir().mkpath(installPath + "/mods"));
+    QVERIFY(writeFile(installPath + "/main.lua", QByteArray()));
+    folder->config.setInstallPath(installPath);
+
+    cache = std::make_unique<ModCache>(folder->config);
+    modList = std::make_unique<ModList>(folder->config, cache.get());
+    refresh();
+}
+
+void TestModSyncPlan::cleanup()
+{
+    modList.reset();
+    cache.reset();
+    folder.reset();
+}
+
+bool TestModSyncPlan::addVersion(int index, int day)
+{
+    const QString sourcePath = folder->dir.filePath(QStringLiteral("source/%1/%2").arg(modId(index), versionId(day)));
+    if (!writeModFolder(sourcePath, QStringLiteral("Mod %1").arg(index), day))
+        return false;
+    return cache->addModVersion(modId(index), versionId(day), sourcePath);
+}
+
+bool TestModSyncPlan::install(int index, int day, const QString &alias)
+{
+    return modList->installMod(SpecMod(modId(index), versionId(day), alias, QString(), QString()));
+}
+
+bool TestModSyncPlan::installUncached(const QString &folderName)
+{
+    return writeModFolder(folder->config.modPath() + "/" + folderName, QStringLiteral("Local Mod"), 1);
+}
+
+void TestModSyncPlan::refresh()
+{
+    cache->refresh();
+    modList->refresh();
+}
+
+ModSyncPlan TestModSyncPlan::plan(const QStringList &lines, ModSyncPlan::Scope scope) const
+{
+    QList<SpecMod> spec;
+    for (const QString &line : lines)
+        spec.append(*SpecMod::fromSpecString(line));
+    return ModSyncPlan::build(*cache, *modList, spec, scope);
+}
+
+void TestModSyncPlan::installsLatest()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::::Mod 1").arg(modId(1))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.modId, modId(1));
+    QCOMPARE(change.type, ModChange::INSTALL);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+    QCOMPARE(change.issues, int(ModChange::NO_ISSUE));
+    QVERIFY(result.hasActiveChanges());
+}
+
+void TestModSyncPlan::updatesToLatest()
+{
+    QVERIFY(addVersion(1, 1));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::::Mod 1").arg(modId(1))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::UPDATE);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+}
+
+void TestModSyncPlan::pinsLatest()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+    QVERIFY(install(1, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::::Mod 1").arg(modId(1))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::PIN_LATEST);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+    QVERIFY(!result.hasActiveChanges());
+}
+
+void TestModSyncPlan::pinsVersion()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    QVERIFY(addVersion(2, 1));
+    QVERIFY(addVersion(2, 2));
+    QVERIFY(addVersion(3, 1));
+    QVERIFY(addVersion(3, 2));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(install(2, 1));
+    refresh();
+
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1::%2::Mod 1").arg(modId(1), versionId(1)),
+        QStringLiteral("%1::%2::Mod 2").arg(modId(2), versionId(2)),
+        QStringLiteral("%1::%2::Mod 3").arg(modId(3), versionId(1)),
+    });
+    QCOMPARE(result.changes.size(), 3);
+    QCOMPARE(result.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(result.changes.at(1).type, ModChange::UPDATE);
+    QCOMPARE(result.changes.at(2).type, ModChange::INSTALL);
+    for (const ModChange &change : result.changes)
+    {
+        QCOMPARE(change.versionPin, ModChange::PINNED);
+        QCOMPARE(change.issues, int(ModChange::NO_ISSUE));
+    }
+    QCOMPARE(result.changes.at(0).versionId, versionId(1));
+    QCOMPARE(result.changes.at(1).versionId, versionId(2));
+    QCOMPARE(result.changes.at(2).versionId, versionId(1));
+}
+
+void TestModSyncPlan::pinsCurrent()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    QVERIFY(addVersion(2, 1));
+    QVERIFY(installUncached("local-mod"));
+    refresh();
+    QVERIFY(install(1, 1));
+    refresh();
+
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1::-::Mod 1").arg(modId(1)),
+        QStringLiteral("%1::-::Mod 2").arg(modId(2)),
+        QStringLiteral("local-mod::-::Local Mod"),
+    });
+    QCOMPARE(result.changes.size(), 3);
+
+    // Installed and cached.
+    QCOMPARE(result.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(result.changes.at(0).versionPin, ModChange::CURRENT);
+    QCOMPARE(result.changes.at(0).versionId, versionId(1));
+    // Not installed, so the latest version is used.
+    QCOMPARE(result.changes.at(1).type, ModChange::INSTALL);
+    QCOMPARE(result.changes.at(1).versionPin, ModChange::LATEST);
+    QCOMPARE(result.changes.at(1).versionId, versionId(1));
+    // Installed, but not cached.
+    QCOMPARE(result.changes.at(2).type, ModChange::PIN_CURRENT);
+    QCOMPARE(result.changes.at(2).versionPin, ModChange::CURRENT);
+    QVERIFY(result.changes.at(2).versionId.isEmpty());
+    QVERIFY(!result.hasActiveChanges());
+}
+
+void TestModSyncPlan::reAliases()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(2, 1));
+    QVERIFY(installUncached("local-mod"));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(install(2, 1, "old-alias"));
+    QVERIFY(addVersion(2, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1:renamed:-::Mod 1").arg(modId(1)),
+        QStringLiteral("%1::::Mod 2").arg(modId(2)),
+        QStringLiteral("local-mod:renamed-local:-::Local Mod"),
+    });
+    QCOMPARE(result.changes.size(), 3);
+
+    // A cached install keeps its version under the new alias.
+    const ModChange &current = result.changes.at(0);
+    QCOMPARE(current.type, ModChange::RE_ALIAS);
+    QCOMPARE(current.alias, QStringLiteral("renamed"));
+    QCOMPARE(current.versionPin, ModChange::CURRENT);
+    QCOMPARE(current.versionId, versionId(1));
+    QVERIFY(!current.isUncachedMove());
+    // Dropping the alias may also change the version.
+    const ModChange &latest = result.changes.at(1);
+    QCOMPARE(latest.type, ModChange::RE_ALIAS);
+    QVERIFY(latest.alias.isEmpty());
+    QCOMPARE(latest.versionPin, ModChange::LATEST);
+    QCOMPARE(latest.versionId, versionId(2));
+    // An uncached install can only be moved.
+    const ModChange &uncached = result.changes.at(2);
+    QCOMPARE(uncached.type, ModChange::RE_ALIAS);
+    QVERIFY(uncached.isUncachedMove());
+
+    QList<SpecMod> toInstall, toUpdate;
+    QList<InstalledMod> toRemove;
+    QVERIFY(current.collect(*cache, *modList, &toInstall, &toUpdate, &toRemove));
+    QVERIFY(latest.collect(*cache, *modList, &toInstall, &toUpdate, &toRemove));
+    QCOMPARE(toInstall.size(), 2);
+    QCOMPARE(toInstall.at(0).id(), modId(1));
+    QCOMPARE(toInstall.at(0).alias(), QStringLiteral("renamed"));
+    QCOMPARE(toInstall.at(0).versionId(), versionId(1));
+    QCOMPARE(toInstall.at(1).id(), modId(2));
+    QVERIFY(toInstall.at(1).alias().isEmpty());
+    QCOMPARE(toInstall.at(1).versionId(), versionId(2));
+    QVERIFY(toUpdate.isEmpty());
+    QVERIFY(toRemove.isEmpty());
+}
+
+void TestModSyncPlan::removesUnlisted()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(2, 1));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(install(2, 1));
+    refresh();
+
+    const QStringList lines = {QStringLiteral("%1::-::Mod 1").arg(modId(1))};
+    const ModSyncPlan sync = plan(lines, ModSyncPlan::SYNC);
+    QCOMPARE(sync.changes.size(), 2);
+    QCOMPARE(sync.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(sync.changes.at(1).modId, modId(2));
+    QCOMPARE(sync.changes.at(1).type, ModChange::REMOVE);
+    QCOMPARE(sync.changes.at(1).issues, int(ModChange::NO_ISSUE));
+
+    const ModSyncPlan partial = plan(lines, ModSyncPlan::PARTIAL);
+    QCOMPARE(partial.changes.size(), 1);
+    QVERIFY(!partial.hasActiveChanges());
+}
+
+void TestModSyncPlan::lastLineWins()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    QVERIFY(addVersion(2, 1));
+    refresh();
+
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1::%2::Mod 1").arg(modId(1), versionId(1)),
+        QStringLiteral("%1::::Mod 2").arg(modId(2)),
+        QStringLiteral("%1:renamed:::Mod 1").arg(modId(1)),
+    });
+    // The later line replaces the earlier change, in the earlier line's position.
+    QCOMPARE(result.changes.size(), 2);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.modId, modId(1));
+    QCOMPARE(change.type, ModChange::INSTALL);
+    QCOMPARE(change.alias, QStringLiteral("renamed"));
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+    QCOMPARE(result.changes.at(1).modId, modId(2));
+}
+
+void TestModSyncPlan::flagsNotFound()
+{
+    const ModSyncPlan result = plan({QStringLiteral("%1::::Missing Mod").arg(modId(9))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::NONE);
+    QCOMPARE(change.modName, QStringLiteral("Missing Mod"));
+    QCOMPARE(change.issues, int(ModChange::NOT_FOUND));
+}
+
+void TestModSyncPlan::flagsNotDownloaded()
+{
+    QVERIFY(cache->addUnloaded(testModInfo(5, QUrl(), 0)));
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::::Mod 5").arg(modId(5))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::NONE);
+    QCOMPARE(change.issues, int(ModChange::NOT_DOWNLOADED));
+}
+
+void TestModSyncPlan::flagsVersionNotCached()
+{
+    QVERIFY(addVersion(1, 1));
+    refresh();
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::%2::Mod 1").arg(modId(1), versionId(9))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::INSTALL);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(1));
+    QCOMPARE(change.requestedVersionId, versionId(9));
+    QCOMPARE(change.issues, int(ModChange::VERSION_NOT_CACHED));
+}
+
+void TestModSyncPlan::flagsRemovesUncached()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(installUncached("local-mod"));
+    refresh();
+    QVERIFY(install(1, 1));
+    refresh();
+
+    const ModSyncPlan result = plan({});
+    QCOMPARE(result.changes.size(), 2);
+    for (const ModChange &change : result.changes)
+    {
+        QCOMPARE(change.type, ModChange::REMOVE);
+        QCOMPARE(change.hasIssue(ModChange::REMOVES_UNCACHED), change.modId == QStringLiteral("local-mod"));
+    }
+}
+
+void TestModSyncPlan::flagsLockMismatch()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({QStringLiteral("%1::%2:0123456789abcdef/1:Mod 1").arg(modId(1), versionId(1))});
+    QCOMPARE(result.changes.size(), 1);
+    const ModChange &change = result.changes.at(0);
+    QCOMPARE(change.type, ModChange::INSTALL);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+    QCOMPARE(change.requestedVersionId, versionId(1));
+    QCOMPARE(change.issues, int(ModChange::LOCK_MISMATCH));
+}
+
+void TestModSyncPlan::collectsChanges()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(2, 1));
+    QVERIFY(addVersion(3, 1));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(install(2, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1::::Mod 1").arg(modId(1)),
+        QStringLiteral("%1::::Mod 3").arg(modId(3)),
+    });
+    QList<SpecMod> toInstall, toUpdate;
+    QList<InstalledMod> toRemove;
+    QStringList errors;
+    QVERIFY(result.collect(*cache, *modList, &toInstall, &toUpdate, &toRemove, &errors));
+    QVERIFY(errors.isEmpty());
+    QCOMPARE(toUpdate.size(), 1);
+    QCOMPARE(toUpdate.at(0).id(), modId(1));
+    QCOMPARE(toUpdate.at(0).versionId(), versionId(2));
+    QCOMPARE(toInstall.size(), 1);
+    QCOMPARE(toInstall.at(0).id(), modId(3));
+    QCOMPARE(toInstall.at(0).versionId(), versionId(1));
+    QCOMPARE(toRemove.size(), 1);
+    QCOMPARE(toRemove.at(0).id(), modId(2));
+
+    // A change planned against a version that has since left the cache.
+    ModSyncPlan stale;
+    stale.changes.append(result.changes.at(1));
+    stale.changes.last().versionId = versionId(9);
+    toInstall.clear();
+    QVERIFY(!stale.collect(*cache, *modList, &toInstall, &toUpdate, &toRemove, &errors));
+    QVERIFY(toInstall.isEmpty());
+    QCOMPARE(errors.size(), 1);
+    QVERIFY(errors.at(0).contains(versionId(9)));
+}
+
+void TestModSyncPlan::locksAsHashAndSize()
+{
+    const SpecMod sm = SpecMod(modId(1), versionId(1), "renamed", "Mod 1", "1.0").withLock("0123abcd", 4096);
+    const QString line = sm.asLockedSpecString();
+    QCOMPARE(line, QStringLiteral("%1:renamed:%2:0123abcd/4096:Mod 1 [1.0]").arg(modId(1), versionId(1)));
+
+    const std::optional<SpecMod> parsed = SpecMod::fromSpecString(line);
+    QVERIFY(parsed);
+    QVERIFY(parsed->isLocked());
+    QCOMPARE(parsed->id(), modId(1));
+    QCOMPARE(parsed->alias(), QStringLiteral("renamed"));
+    QCOMPARE(parsed->versionId(), versionId(1));
+    QCOMPARE(parsed->hash(), QStringLiteral("0123abcd"));
+    QCOMPARE(parsed->size(), qint64(4096));
+    QCOMPARE(parsed->asLockedSpecString(), line);
+
+    // Without a lock, the line is only versioned.
+    const SpecMod unlocked(modId(1), versionId(1), "Mod 1", QString());
+    QVERIFY(!unlocked.isLocked());
+    QCOMPARE(unlocked.asLockedSpecString(), QStringLiteral("%1::%2::Mod 1").arg(modId(1), versionId(1)));
+}
+
+void TestModSyncPlan::ignoresInvalidLock_data()
+{
+    QTest::addColumn<QString>("line");
+
+    QTest::newRow("no slash") << QStringLiteral("%1::%2:0123abcd:Mod 1").arg(modId(1), versionId(1));
+    QTest::newRow("no hash") << QStringLiteral("%1::%2:/4096:Mod 1").arg(modId(1), versionId(1));
+    QTest::newRow("no size") << QStringLiteral("%1::%2:0123abcd/:Mod 1").arg(modId(1), versionId(1));
+    QTest::newRow("non-numeric size") << QStringLiteral("%1::%2:0123abcd/big:Mod 1").arg(modId(1), versionId(1));
+    QTest::newRow("no version") << QStringLiteral("%1:::0123abcd/4096:Mod 1").arg(modId(1));
+}
+
+void TestModSyncPlan::ignoresInvalidLock()
+{
+    QFETCH(QString, line);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("^Ignoring invalid lock"));
+    const std::optional<SpecMod> parsed = SpecMod::fromSpecString(line);
+    // The rest of the line is still used.
+    QVERIFY(parsed);
+    QCOMPARE(parsed->id(), modId(1));
+    QCOMPARE(parsed->name(), QStringLiteral("Mod 1"));
+    QVERIFY(!parsed->isLocked());
+    QCOMPARE(parsed->size(), qint64(-1));
+}
+
+void TestModSyncPlan::pinsLockedInstall()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+    QVERIFY(install(1, 1));
+    refresh();
+    const CachedVersion *cv = cache->mod(modId(1))->version(versionId(1));
+    QVERIFY(cv);
+    const QString lock = QStringLiteral("%1/%2").arg(cv->hash()).arg(cv->size());
+
+    // The install matches the lock, even if its version ID is no longer cached.
+    const ModSyncPlan result = plan({
+        QStringLiteral("%1::%2:%3:Mod 1").arg(modId(1), versionId(1), lock),
+        QStringLiteral("%1::%2:%3:Mod 1").arg(modId(1), versionId(9), lock),
+    });
+    QCOMPARE(result.changes.size(), 1);
+    QCOMPARE(result.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(result.changes.at(0).versionId, versionId(1));
+    QCOMPARE(result.changes.at(0).issues, int(ModChange::NO_ISSUE));
+
+    // A different alias reinstalls the locked version.
+    const ModSyncPlan renamed = plan({QStringLiteral("%1:renamed:%2:%3:Mod 1").arg(modId(1), versionId(1), lock)});
+    QCOMPARE(renamed.changes.size(), 1);
+    QCOMPARE(renamed.changes.at(0).type, ModChange::RE_ALIAS);
+    QCOMPARE(renamed.changes.at(0).versionPin, ModChange::PINNED);
+    QCOMPARE(renamed.changes.at(0).versionId, versionId(1));
+}
+
+void TestModSyncPlan::locksUncachedInstall()
+{
+    QVERIFY(installUncached("local-mod"));
+    refresh();
+    const InstalledMod *im = modList->mod("local-mod");
+    QVERIFY(im);
+    const QString line = QStringLiteral("local-mod::-:%1/%2:Local Mod").arg(im->hash()).arg(im->size());
+
+    const ModSyncPlan matching = plan({line});
+    QCOMPARE(matching.changes.size(), 1);
+    QCOMPARE(matching.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(matching.changes.at(0).issues, int(ModChange::NO_ISSUE));
+
+    // Once its files change, the install no longer matches, and there's no cached version to install instead.
+    QVERIFY(writeFile(folder->config.modPath() + "/local-mod/scripts/modinit.lua", "-- changed"));
+    modList->refresh();
+    const ModSyncPlan changed = plan({line});
+    QCOMPARE(changed.changes.size(), 1);
+    const ModChange &change = changed.changes.at(0);
+    QCOMPARE(change.type, ModChange::PIN_CURRENT);
+    QCOMPARE(change.issues, int(ModChange::LOCK_MISMATCH));
+    QCOMPARE(change.requestedVersionId, QStringLiteral("-"));
+}
+
+void TestModSyncPlan::installsLockedVersionWithoutId()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(1, 2));
+    refresh();
+    const CachedVersion *cv = cache->mod(modId(1))->version(versionId(1));
+    QVERIFY(cv);
+
+    // The cached version with the locked signature is used, rather than the latest.
+    const ModSyncPlan matching = plan({QStringLiteral("%1::-:%2/%3:Mod 1").arg(modId(1), cv->hash()).arg(cv->size())});
+    QCOMPARE(matching.changes.size(), 1);
+    QCOMPARE(matching.changes.at(0).type, ModChange::INSTALL);
+    QCOMPARE(matching.changes.at(0).versionPin, ModChange::PINNED);
+    QCOMPARE(matching.changes.at(0).versionId, versionId(1));
+    QCOMPARE(matching.changes.at(0).issues, int(ModChange::NO_ISSUE));
+
+    const ModSyncPlan missing = plan({QStringLiteral("%1::-:0123abcd/%2:Mod 1").arg(modId(1)).arg(cv->size())});
+    QCOMPARE(missing.changes.size(), 1);
+    const ModChange &change = missing.changes.at(0);
+    QCOMPARE(change.type, ModChange::INSTALL);
+    QCOMPARE(change.versionPin, ModChange::LATEST);
+    QCOMPARE(change.versionId, versionId(2));
+    QCOMPARE(change.issues, int(ModChange::LOCK_MISMATCH));
+    QCOMPARE(change.requestedVersionId, QStringLiteral("-"));
+}
+
+void TestModSyncPlan::checksLockedSpecWithoutHashing()
+{
+    QVERIFY(addVersion(1, 1));
+    QVERIFY(addVersion(2, 1));
+    refresh();
+    QVERIFY(install(1, 1));
+    QVERIFY(install(2, 1));
+    refresh();
+    const CachedVersion *cv1 = cache->mod(modId(1))->version(versionId(1));
+    const CachedVersion *cv2 = cache->mod(modId(2))->version(versionId(1));
+    QVERIFY(cv1);
+    QVERIFY(cv2);
+    const QStringList lines = {
+        QStringLiteral("%1::%2:%3/%4:Mod 1").arg(modId(1), versionId(1), cv1->hash()).arg(cv1->size()),
+        QStringLiteral("%1::%2:%3/%4:Mod 2").arg(modId(2), versionId(1), cv2->hash()).arg(cv2->size() + 1),
+    };
+
+    // As for sync --check on a fully locked spec: installed mods are only read, not matched to the cache.
+    modList.reset();
+    cache.reset();
+    cache = std::make_unique<ModCache>(folder->config);
+    modList = std::make_unique<ModList>(folder->config, cache.get());
+    cache->refresh(ModCache::LATEST_ONLY);
+    modList->refresh(ModList::CONTENT_ONLY);
+    QVERIFY(!modList->mod(modId(1))->isHashed());
+    QVERIFY(!modList->mod(modId(2))->isHashed());
+
+    const ModSyncPlan result = plan(lines);
+    QCOMPARE(result.changes.size(), 2);
+    QCOMPARE(result.changes.at(0).type, ModChange::PIN_CURRENT);
+    QCOMPARE(result.changes.at(0).issues, int(ModChange::NO_ISSUE));
+    QVERIFY(result.changes.at(1).hasIssue(ModChange::LOCK_MISMATCH));
+    // Only the mod with the locked size was hashed.
+    QVERIFY(modList->mod(modId(1))->isHashed());
+    QVERIFY(!modList->mod(modId(2))->isHashed());
+}
+
+QTEST_GUILESS_MAIN(TestModSyncPlan)
+#include "tst_modsyncplan.moc"
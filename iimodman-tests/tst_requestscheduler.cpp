@@ -0,0 +1,134 @@
+#include "testhttpserver.h"
+#include "testutils.h"
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QtTest>
+#include <moddownloader.h>
+
+using namespace iimodmanager;
+
+class TestRequestScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void honoursRetryAfter();
+    void retriesStalledRequest();
+    void retriesServerError_data();
+    void retriesServerError();
+    void givesUpAfterMaxRetries();
+
+private:
+    std::unique_ptr<TestFolder> folder;
+    std::unique_ptr<TestHttpServer> server;
+
+    //! Sends a GET with retries, and waits for the final reply. Returns its status, or 0 if it had none.
+    int get(RequestScheduler &scheduler, QByteArray *body = nullptr);
+};
+
+void TestRequestScheduler::init()
+{
+    folder = std::make_unique<TestFolder>();
+    QVERIFY(folder->dir.isValid());
+    folder->config.setMaxRetries(2);
+    server = std::make_unique<TestHttpServer>();
+    QVERIFY(server->listen());
+}
+
+int TestRequestScheduler::get(RequestScheduler &scheduler, QByteArray *body)
+{
+    int status = -1;
+    scheduler.sendWithRetry(RequestScheduler::GET_OP, QNetworkRequest(server->url("/file")), QByteArray(), this, [&status, body](QNetworkReply *reply)
+    {
+        status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (body)
+            *body = reply->readAll();
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(status >= 0, 10000);
+    return status;
+}
+
+void TestRequestScheduler::honoursRetryAfter()
+{
+    server->setHandler([this](const TestHttpServer::Request &request) {
+        if (server->requests().size() > 1)
+            return TestHttpServer::Response::content(request, "done");
+        TestHttpServer::Response response = TestHttpServer::Response::status(429);
+        response.headers.append({"Retry-After", "1"});
+        return response;
+    });
+
+    QNetworkAccessManager qnam;
+    RequestScheduler scheduler(folder->config, qnam);
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray body;
+    QCOMPARE(get(scheduler, &body), 200);
+    QCOMPARE(body, QByteArray("done"));
+    // The configured backoff is only 10 ms, so the wait came from the header.
+    QVERIFY2(timer.elapsed() >= 900, qPrintable(QString::number(timer.elapsed())));
+    QCOMPARE(server->requests().size(), 2);
+    QCOMPARE(scheduler.stats().requests, 2);
+    QCOMPARE(scheduler.stats().retries, 1);
+}
+
+void TestRequestScheduler::retriesStalledRequest()
+{
+    folder->config.setRequestTimeout(1);
+    server->setHandler([this](const TestHttpServer::Request &request) {
+        TestHttpServer::Response response = TestHttpServer::Response::content(request, "done");
+        response.stall = server->requests().size() == 1;
+        return response;
+    });
+
+    QNetworkAccessManager qnam;
+    RequestScheduler scheduler(folder->config, qnam);
+    QCOMPARE(get(scheduler), 200);
+    QCOMPARE(server->requests().size(), 2);
+    QCOMPARE(scheduler.stats().timeouts, 1);
+    QCOMPARE(scheduler.stats().retries, 1);
+}
+
+void TestRequestScheduler::retriesServerError_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::newRow("500") << 500;
+    QTest::newRow("502") << 502;
+    QTest::newRow("503") << 503;
+    QTest::newRow("504") << 504;
+}
+
+void TestRequestScheduler::retriesServerError()
+{
+    QFETCH(int, status);
+    server->setHandler([this, status](const TestHttpServer::Request &request) {
+        if (server->requests().size() > 1)
+            return TestHttpServer::Response::content(request, "done");
+        return TestHttpServer::Response::status(status);
+    });
+
+    QNetworkAccessManager qnam;
+    RequestScheduler scheduler(folder->config, qnam);
+    QCOMPARE(get(scheduler), 200);
+    QCOMPARE(server->requests().size(), 2);
+    QCOMPARE(scheduler.stats().retries, 1);
+}
+
+void TestRequestScheduler::givesUpAfterMaxRetries()
+{
+    server->setHandler([](const TestHttpServer::Request &) {
+        return TestHttpServer::Response::status(503);
+    });
+
+    QNetworkAccessManager qnam;
+    RequestScheduler scheduler(folder->config, qnam);
+    QCOMPARE(get(scheduler), 503);
+    QCOMPARE(server->requests().size(), 3);
+    QCOMPARE(scheduler.stats().retries, 2);
+}
+
+QTEST_GUILESS_MAIN(TestRequestScheduler)
+#include "tst_requestscheduler.moc"